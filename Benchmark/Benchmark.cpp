@@ -0,0 +1,1020 @@
+#include "Compressor.h"
+#include "Shape.h"
+#include "Polygon.h"
+#include "PolygonTriangulator.h"
+#include "Predicates.h"
+#include "Mesh.h"
+#include "TriangleMesh.h"
+#include "MeshGraph.h"
+#include "MeshGenerator.h"
+#include "BoundingBoxTree.h"
+#include "FileFormats/OBJFormat.h"
+#include "MeshOperations/MeshSetOperation.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+using namespace MeshWarrior;
+
+// This many random triangles get split by this many random planes in the cutting benchmark.
+#define BENCHMARK_SPLIT_TRIANGLE_COUNT		20000
+#define BENCHMARK_SPLIT_PLANE_COUNT			16
+
+// The all-pairs compressor queues N^2/2 pairs up front, so beyond this it just eats all the memory.
+#define BENCHMARK_MAX_ALL_PAIRS_SIZE		2048
+
+// These are the defaults for the mesh benchmarks, all of which can be changed from the command line.
+#define BENCHMARK_DEFAULT_REPEAT_COUNT		3
+#define BENCHMARK_DEFAULT_MIN_FACES			10000
+#define BENCHMARK_DEFAULT_MAX_FACES			5000000
+#define BENCHMARK_DEFAULT_MAX_SET_OP_FACES	100000
+
+// Welding with a tolerance compares each new vertex against all the others, and loading a file welds
+// as it goes, so beyond this many faces these stages take minutes and are skipped unless asked for.
+#define BENCHMARK_DEFAULT_MAX_WELD_FACES	40000
+#define BENCHMARK_TEMP_FILE					"BenchmarkTemp.obj"
+
+// Build with MW_SINGLE_PRECISION_VERTICES set, and again without, to compare the two.
+#if MW_SINGLE_PRECISION_VERTICES
+#	define BENCHMARK_VERTEX_STORAGE			"float"
+#else
+#	define BENCHMARK_VERTEX_STORAGE			"double"
+#endif
+
+static void GeneratePointArray(int count, std::vector<Point*>& pointArray)
+{
+	// Every point gets an approximate twin, so compression should cut the array in half.
+	std::mt19937 generator(count);
+	std::uniform_real_distribution<double> distribution(-100.0, 100.0);
+
+	pointArray.clear();
+	while ((int)pointArray.size() < count)
+	{
+		Vector center(distribution(generator), distribution(generator), distribution(generator));
+		pointArray.push_back(new Point(center));
+		if ((int)pointArray.size() < count)
+			pointArray.push_back(new Point(center + Vector(MW_EPS / 4.0, 0.0, 0.0)));
+	}
+
+	std::shuffle(pointArray.begin(), pointArray.end(), generator);
+}
+
+static double BenchmarkCompressArray(int count, bool bucketed, int& resultCount)
+{
+	std::vector<Point*> pointArray;
+	GeneratePointArray(count, pointArray);
+
+	auto compressorFunc = [](const Point* pointA, const Point* pointB) -> Point* {
+		if (pointA->ContainsPoint(pointB->center))
+		{
+			delete pointB;
+			return const_cast<Point*>(pointA);
+		}
+		return nullptr;
+	};
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+
+	if (bucketed)
+	{
+		CompressArray<Point>(pointArray, compressorFunc, [](const Point* point, CompressorCell* cellArray) -> int {
+			cellArray[0] = CompressorCell::FromPoint(point->center, MW_EPS);
+			return 1;
+		});
+	}
+	else
+	{
+		CompressArray<Point>(pointArray, compressorFunc);
+	}
+
+	std::chrono::high_resolution_clock::time_point stopTime = std::chrono::high_resolution_clock::now();
+
+	resultCount = (int)pointArray.size();
+	for (Point* point : pointArray)
+		delete point;
+
+	return std::chrono::duration<double, std::milli>(stopTime - startTime).count();
+}
+
+static void BenchmarkCompressor()
+{
+	std::cout << "CompressArray (point de-duplication)" << std::endl;
+	std::cout << std::setw(10) << "N" << std::setw(16) << "all-pairs ms" << std::setw(16) << "bucketed ms" << std::setw(10) << "result" << std::endl;
+
+	int countArray[] = { 4, 8, 16, 32, 64, 256, 1024, 2048, 4096, 16384, 65536, 100000 };
+	for (int count : countArray)
+	{
+		int allPairsResultCount = -1, bucketedResultCount = -1;
+
+		std::cout << std::setw(10) << count;
+
+		if (count <= BENCHMARK_MAX_ALL_PAIRS_SIZE)
+			std::cout << std::setw(16) << std::fixed << std::setprecision(3) << BenchmarkCompressArray(count, false, allPairsResultCount);
+		else
+			std::cout << std::setw(16) << "skipped";
+
+		std::cout << std::setw(16) << std::fixed << std::setprecision(3) << BenchmarkCompressArray(count, true, bucketedResultCount);
+		std::cout << std::setw(10) << bucketedResultCount;
+
+		if (allPairsResultCount >= 0 && allPairsResultCount != bucketedResultCount)
+			std::cout << "  MISMATCH (" << allPairsResultCount << ")";
+
+		std::cout << std::endl;
+	}
+}
+
+// This is how ConvexPolygon::SplitAgainstPlane used to work before it was given exact predicates,
+// kept here so that we can see what they cost us.
+static bool LegacySplitAgainstPlane(const ConvexPolygon& polygon, const Plane& plane, std::vector<ConvexPolygon>& polygonArray)
+{
+	std::vector<Vector> pointArray;
+
+	for (int i = 0; i < (signed)polygon.vertexArray->size(); i++)
+	{
+		pointArray.push_back((*polygon.vertexArray)[i]);
+
+		int j = (i + 1) % polygon.vertexArray->size();
+		LineSegment edge((*polygon.vertexArray)[i], (*polygon.vertexArray)[j]);
+		Point* point = (Point*)plane.IntersectWith(&edge);
+		if (point)
+		{
+			if (!point->ContainsPoint(edge.GetPoint(0)) && !point->ContainsPoint(edge.GetPoint(1)))
+				pointArray.push_back(point->center);
+			delete point;
+		}
+	}
+
+	ConvexPolygon polygonFront, polygonBack;
+
+	for (int i = 0; i < (signed)pointArray.size(); i++)
+	{
+		Vector& point = pointArray[i];
+		double distance = plane.ShortestSignedDistanceToPoint(point);
+		if (::fabs(distance) <= MW_EPS)
+		{
+			polygonFront.vertexArray->push_back(point);
+			polygonBack.vertexArray->push_back(point);
+		}
+		else if (distance > 0.0)
+			polygonFront.vertexArray->push_back(point);
+		else if (distance < 0.0)
+			polygonBack.vertexArray->push_back(point);
+	}
+
+	if (!(polygonFront.IsDegenerate() || polygonBack.IsDegenerate()))
+	{
+		polygonArray.push_back(polygonFront);
+		polygonArray.push_back(polygonBack);
+	}
+
+	return polygonArray.size() > 0;
+}
+
+static double BenchmarkSplit(const std::vector<ConvexPolygon>& polygonArray, const std::vector<Plane>& planeArray, bool legacy, int& splitCount)
+{
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+
+	splitCount = 0;
+	std::vector<ConvexPolygon> splitPolygonArray;
+	for (const Plane& plane : planeArray)
+	{
+		for (const ConvexPolygon& polygon : polygonArray)
+		{
+			splitPolygonArray.clear();
+			if (legacy ? LegacySplitAgainstPlane(polygon, plane, splitPolygonArray) : polygon.SplitAgainstPlane(plane, splitPolygonArray))
+				splitCount++;
+		}
+	}
+
+	std::chrono::high_resolution_clock::time_point stopTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(stopTime - startTime).count();
+}
+
+static void BenchmarkPredicates()
+{
+	std::mt19937 generator(0);
+	std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+
+	auto randomVector = [&generator, &distribution]() -> Vector {
+		return Vector(distribution(generator), distribution(generator), distribution(generator));
+	};
+
+	std::vector<ConvexPolygon> polygonArray;
+	for (int i = 0; i < BENCHMARK_SPLIT_TRIANGLE_COUNT; i++)
+	{
+		ConvexPolygon polygon;
+		Vector center = randomVector();
+		for (int j = 0; j < 3; j++)
+			polygon.vertexArray->push_back(center + randomVector() * 0.1);
+		polygonArray.push_back(polygon);
+	}
+
+	std::vector<Plane> planeArray;
+	for (int i = 0; i < BENCHMARK_SPLIT_PLANE_COUNT; i++)
+		planeArray.push_back(Plane(randomVector(), randomVector()));
+
+	// The second round puts a vertex of every triangle right on the edge of each plane's
+	// tolerance band, which is the worst case for the exact predicates.
+	std::vector<ConvexPolygon> nearPolygonArray;
+	for (int i = 0; i < BENCHMARK_SPLIT_TRIANGLE_COUNT; i++)
+	{
+		const Plane& plane = planeArray[i % BENCHMARK_SPLIT_PLANE_COUNT];
+		ConvexPolygon polygon = polygonArray[i];
+		Vector& vertex = (*polygon.vertexArray)[0];
+		vertex -= plane.unitNormal * (plane.ShortestSignedDistanceToPoint(vertex) - MW_EPS);
+		nearPolygonArray.push_back(polygon);
+	}
+
+	std::cout << "ConvexPolygon::SplitAgainstPlane (" << BENCHMARK_SPLIT_TRIANGLE_COUNT << " triangles x " << BENCHMARK_SPLIT_PLANE_COUNT << " planes)" << std::endl;
+	std::cout << std::setw(10) << "case" << std::setw(16) << "legacy ms" << std::setw(16) << "exact ms" << std::setw(10) << "legacy" << std::setw(10) << "exact" << std::endl;
+
+	const char* caseNameArray[] = { "random", "near" };
+	const std::vector<ConvexPolygon>* caseArray[] = { &polygonArray, &nearPolygonArray };
+	for (int i = 0; i < 2; i++)
+	{
+		int legacySplitCount = 0, exactSplitCount = 0;
+		std::cout << std::setw(10) << caseNameArray[i];
+		std::cout << std::setw(16) << std::fixed << std::setprecision(3) << BenchmarkSplit(*caseArray[i], planeArray, true, legacySplitCount);
+		std::cout << std::setw(16) << std::fixed << std::setprecision(3) << BenchmarkSplit(*caseArray[i], planeArray, false, exactSplitCount);
+		std::cout << std::setw(10) << legacySplitCount << std::setw(10) << exactSplitCount << std::endl;
+	}
+
+	std::cout << std::endl;
+	std::cout << "Predicates::Orient3D (1000000 nearly-coplanar points)" << std::endl;
+
+	std::vector<Vector> pointArray;
+	for (int i = 0; i < 1000000 * 4; i += 4)
+	{
+		Vector pointA = randomVector(), pointB = randomVector(), pointC = randomVector();
+		double s = distribution(generator), t = distribution(generator);
+		pointArray.push_back(pointA);
+		pointArray.push_back(pointB);
+		pointArray.push_back(pointC);
+		pointArray.push_back(pointA + (pointB - pointA) * s + (pointC - pointA) * t);
+	}
+
+	int naivePositiveCount = 0, exactPositiveCount = 0;
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < (int)pointArray.size(); i += 4)
+	{
+		Vector normal;
+		normal.Cross(pointArray[i + 1] - pointArray[i], pointArray[i + 2] - pointArray[i]);
+		if (Vector::Dot(pointArray[i + 3] - pointArray[i], normal) > 0.0)
+			naivePositiveCount++;
+	}
+	std::chrono::high_resolution_clock::time_point stopTime = std::chrono::high_resolution_clock::now();
+	double naiveTime = std::chrono::duration<double, std::milli>(stopTime - startTime).count();
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < (int)pointArray.size(); i += 4)
+		if (Predicates::Orient3D(pointArray[i], pointArray[i + 1], pointArray[i + 2], pointArray[i + 3]) > 0)
+			exactPositiveCount++;
+	stopTime = std::chrono::high_resolution_clock::now();
+	double exactTime = std::chrono::duration<double, std::milli>(stopTime - startTime).count();
+
+	std::cout << std::setw(16) << "naive ms" << std::setw(16) << "exact ms" << std::setw(10) << "naive +" << std::setw(10) << "exact +" << std::endl;
+	std::cout << std::setw(16) << std::fixed << std::setprecision(3) << naiveTime << std::setw(16) << exactTime;
+	std::cout << std::setw(10) << naivePositiveCount << std::setw(10) << exactPositiveCount << std::endl;
+}
+
+// These are the sorts of concave polygons that make naive triangulation slow: a star with a reflex vertex every
+// other step or so, a comb whose teeth all hide each other, and a spiral whose every ear is long and thin.
+static void GenerateConcavePolygon(const std::string& shapeName, int vertexCount, std::vector<Vector>& pointArray)
+{
+	std::mt19937 generator(vertexCount);
+	std::uniform_real_distribution<double> distribution(0.2, 1.0);
+
+	pointArray.clear();
+	if (shapeName == "star")
+	{
+		for (int i = 0; i < vertexCount; i++)
+		{
+			double angle = MW_TWO_PI * double(i) / double(vertexCount);
+			double radius = distribution(generator);
+			pointArray.push_back(Vector(radius * ::cos(angle), radius * ::sin(angle), 0.0));
+		}
+	}
+	else if (shapeName == "comb")
+	{
+		int toothCount = MW_MAX((vertexCount - 3) / 3, 1);
+		pointArray.push_back(Vector(0.0, 0.0, 0.0));
+		pointArray.push_back(Vector(2.0 * toothCount, 0.0, 0.0));
+		for (int i = toothCount - 1; i >= 0; i--)
+		{
+			pointArray.push_back(Vector(2.0 * i + 2.0, 1.0, 0.0));
+			pointArray.push_back(Vector(2.0 * i + 1.5, 10.0, 0.0));
+			pointArray.push_back(Vector(2.0 * i + 1.0, 1.0, 0.0));
+		}
+		pointArray.push_back(Vector(0.0, 1.0, 0.0));
+	}
+	else if (shapeName == "spiral")
+	{
+		int armCount = MW_MAX(vertexCount / 2, 2);
+		for (int i = 0; i < armCount; i++)
+		{
+			double angle = 10.0 * MW_TWO_PI * double(i) / double(armCount);
+			pointArray.push_back(Vector((1.0 + angle) * ::cos(angle), (1.0 + angle) * ::sin(angle), 0.0));
+		}
+		for (int i = armCount - 1; i >= 0; i--)
+		{
+			double angle = 10.0 * MW_TWO_PI * double(i) / double(armCount);
+			pointArray.push_back(Vector((0.5 + angle) * ::cos(angle), (0.5 + angle) * ::sin(angle), 0.0));
+		}
+	}
+}
+
+static void BenchmarkTriangulation()
+{
+	std::cout << "Polygon::Tessellate (concave polygons, times in ms)" << std::endl;
+	std::cout << std::setw(10) << "N" << std::setw(14) << "star ms" << std::setw(14) << "comb ms" << std::setw(14) << "spiral ms" << std::endl;
+
+	const char* shapeNameArray[] = { "star", "comb", "spiral" };
+	int vertexCountArray[] = { 10, 100, 1000, 10000, 100000 };
+	for (int vertexCount : vertexCountArray)
+	{
+		std::cout << std::setw(10) << vertexCount;
+
+		for (const char* shapeName : shapeNameArray)
+		{
+			Polygon polygon;
+			GenerateConcavePolygon(shapeName, vertexCount, *polygon.vertexArray);
+
+			// Small polygons go by too fast to time one at a time.
+			int repeatCount = MW_MAX(100000 / vertexCount, 1);
+			std::vector<ConvexPolygon> triangleArray;
+
+			std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < repeatCount; i++)
+				polygon.Tessellate(triangleArray);
+			std::chrono::high_resolution_clock::time_point stopTime = std::chrono::high_resolution_clock::now();
+			double time = std::chrono::duration<double, std::milli>(stopTime - startTime).count() / double(repeatCount);
+
+			// Tessellate always hands back n - 2 triangles, so make sure the triangulation itself worked and that the triangles
+			// cover the polygon without overlapping.
+			PolygonTriangulator triangulator;
+			std::vector<int> indexArray;
+			bool triangulated = triangulator.Triangulate(*polygon.vertexArray, indexArray);
+
+			double triangleArea = 0.0;
+			for (const ConvexPolygon& triangle : triangleArray)
+				triangleArea += triangle.CalcArea();
+
+			double area = polygon.CalcArea();
+			std::cout << std::setw(14) << std::fixed << std::setprecision(4) << time;
+			if (!triangulated || ::fabs(triangleArea - area) > 1e-9 * area)
+				std::cout << " (BAD)";
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+//--------------------------------- mesh benchmarks ---------------------------------
+
+struct MeshBenchmarkOptions
+{
+	int repeatCount;
+	int minFaces;
+	int maxFaces;
+	int maxSetOpFaces;
+	int maxWeldFaces;
+	std::string assetPath;
+};
+
+struct MeshBenchmarkResult
+{
+	std::string meshName;
+	std::string stageName;
+	int faceCount;
+	int repeatCount;
+	double minTime;			// These are all in milliseconds.
+	double medianTime;
+	double meanTime;
+	double deviation;
+	int64_t memory;			// In bytes.
+	std::string statisticsJSON;
+};
+
+static std::vector<MeshBenchmarkResult> meshBenchmarkResultArray;
+
+// This is only a rough idea of how much memory the mesh takes up, not counting its vertex index.
+static int64_t EstimateMeshMemory(const Mesh* mesh)
+{
+	int64_t memory = int64_t(mesh->GetNumVertices()) * sizeof(Mesh::Vertex);
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+		memory += sizeof(Mesh::Face) + mesh->GetFace(i)->vertexArray.capacity() * sizeof(int);
+
+	return memory;
+}
+
+// Make each face into as many quads as it has corners, by way of the center of the face and the
+// midpoints of its edges.  The midpoints are shared between neighbors, so the result stays welded.
+static Mesh* SubdivideMesh(const Mesh* mesh)
+{
+	Mesh* subdividedMesh = new Mesh();
+	*subdividedMesh->name = *mesh->name;
+
+	for (int i = 0; i < mesh->GetNumVertices(); i++)
+		subdividedMesh->AddVertex(*mesh->GetVertex(i));
+
+	std::map<std::pair<int, int>, int> midpointMap;
+
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+	{
+		const std::vector<int>& vertexArray = mesh->GetFace(i)->vertexArray;
+		int vertexCount = (int)vertexArray.size();
+
+		Vector center(0.0, 0.0, 0.0);
+		for (int j : vertexArray)
+			center += mesh->GetVertex(j)->point;
+		center *= 1.0 / double(vertexCount);
+
+		int centerIndex = subdividedMesh->AddVertex(mesh->GetFace(i)->GeneratePolygon(mesh).InterpolateVertex(center));
+
+		std::vector<int> midpointArray(vertexCount);
+		for (int j = 0; j < vertexCount; j++)
+		{
+			int vertexA = vertexArray[j];
+			int vertexB = vertexArray[(j + 1) % vertexCount];
+			std::pair<int, int> key(MW_MIN(vertexA, vertexB), MW_MAX(vertexA, vertexB));
+
+			std::map<std::pair<int, int>, int>::iterator iter = midpointMap.find(key);
+			if (iter != midpointMap.end())
+				midpointArray[j] = iter->second;
+			else
+			{
+				midpointArray[j] = subdividedMesh->AddVertex(Mesh::Vertex::Lerp(*mesh->GetVertex(key.first), *mesh->GetVertex(key.second), 0.5));
+				midpointMap.insert(std::pair<std::pair<int, int>, int>(key, midpointArray[j]));
+			}
+		}
+
+		for (int j = 0; j < vertexCount; j++)
+		{
+			Mesh::Face face;
+			face.vertexArray.push_back(centerIndex);
+			face.vertexArray.push_back(midpointArray[(j + vertexCount - 1) % vertexCount]);
+			face.vertexArray.push_back(vertexArray[j]);
+			face.vertexArray.push_back(midpointArray[j]);
+			subdividedMesh->AddFace(face);
+		}
+	}
+
+	return subdividedMesh;
+}
+
+// Make a copy of the given mesh, scaled and moved so that its bounding box has the given center and width.
+static Mesh* PlaceMesh(const Mesh* mesh, const Vector& center, double width)
+{
+	AxisAlignedBox box = mesh->CalcBoundingBox();
+	double scale = width / (box.max.x - box.min.x);
+	Vector boxCenter = (box.min + box.max) * 0.5;
+
+	Mesh* placedMesh = new Mesh();
+	*placedMesh->name = *mesh->name;
+
+	for (int i = 0; i < mesh->GetNumVertices(); i++)
+	{
+		Mesh::Vertex vertex = *mesh->GetVertex(i);
+		vertex.point = center + (vertex.point - boxCenter) * scale;
+		placedMesh->AddVertex(vertex);
+	}
+
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+		placedMesh->AddFace(*mesh->GetFace(i));
+
+	return placedMesh;
+}
+
+// Run the given function the given number of times and keep track of how long it took.  The function
+// does its own timing so that it can leave out any setup or cleanup, and reports the memory it used.
+static void MeasureStage(const std::string& meshName, const std::string& stageName, int faceCount, int repeatCount, std::function<double(int64_t&, std::string&)> stageFunc)
+{
+	MeshBenchmarkResult result;
+	result.meshName = meshName;
+	result.stageName = stageName;
+	result.faceCount = faceCount;
+	result.repeatCount = repeatCount;
+	result.memory = 0;
+
+	std::vector<double> timeArray;
+	for (int i = 0; i < repeatCount; i++)
+		timeArray.push_back(stageFunc(result.memory, result.statisticsJSON));
+
+	std::sort(timeArray.begin(), timeArray.end());
+
+	result.minTime = timeArray[0];
+	result.medianTime = (repeatCount % 2 == 1) ? timeArray[repeatCount / 2] : (timeArray[repeatCount / 2 - 1] + timeArray[repeatCount / 2]) * 0.5;
+
+	result.meanTime = 0.0;
+	for (double time : timeArray)
+		result.meanTime += time;
+	result.meanTime /= double(repeatCount);
+
+	result.deviation = 0.0;
+	for (double time : timeArray)
+		result.deviation += (time - result.meanTime) * (time - result.meanTime);
+	result.deviation = ::sqrt(result.deviation / double(repeatCount));
+
+	// Throughput is figured from the median, which isn't thrown off by the odd slow run.
+	double facesPerSecond = (result.medianTime > 0.0) ? double(faceCount) / (result.medianTime / 1000.0) : 0.0;
+
+	std::cout << std::setw(20) << meshName << std::setw(18) << stageName << std::setw(10) << faceCount;
+	std::cout << std::setw(12) << std::fixed << std::setprecision(3) << result.minTime;
+	std::cout << std::setw(12) << std::fixed << std::setprecision(3) << result.medianTime;
+	std::cout << std::setw(10) << std::fixed << std::setprecision(3) << result.deviation;
+	std::cout << std::setw(14) << std::fixed << std::setprecision(0) << facesPerSecond;
+	std::cout << std::setw(12) << std::fixed << std::setprecision(2) << double(result.memory) / (1024.0 * 1024.0) << std::endl;
+
+	meshBenchmarkResultArray.push_back(result);
+}
+
+static void SkipStage(const std::string& meshName, const std::string& stageName, int faceCount)
+{
+	std::cout << std::setw(20) << meshName << std::setw(18) << stageName << std::setw(10) << faceCount << std::setw(12) << "skipped" << std::endl;
+}
+
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point startTime)
+{
+	std::chrono::high_resolution_clock::time_point stopTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(stopTime - startTime).count();
+}
+
+class BenchmarkFaceBox : public BoundingBoxTree::Guest
+{
+public:
+	virtual AxisAlignedBox CalcBoundingBox() const override
+	{
+		return this->box;
+	}
+
+	AxisAlignedBox box;
+};
+
+// Time everything that can be done to a single mesh.  If the mesh was loaded from a file, that's
+// the file we time loading, otherwise we load back whatever we saved.
+static void BenchmarkMeshStages(const std::string& meshName, const Mesh* mesh, const std::string& meshFile, const MeshBenchmarkOptions& options)
+{
+	int repeatCount = options.repeatCount;
+	int faceCount = mesh->GetNumFaces();
+	OBJFormat objFormat;
+
+	MeasureStage(meshName, "save", faceCount, repeatCount, [mesh, &objFormat](int64_t& /*memory*/, std::string& /*statisticsJSON*/) -> double {
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		objFormat.SaveMesh(BENCHMARK_TEMP_FILE, *mesh);
+		return MillisecondsSince(startTime);
+	});
+
+	if (faceCount > options.maxWeldFaces)
+	{
+		SkipStage(meshName, "load", faceCount);
+		SkipStage(meshName, "weld", faceCount);
+	}
+	else
+	{
+		std::string loadFile = meshFile.empty() ? BENCHMARK_TEMP_FILE : meshFile;
+		MeasureStage(meshName, "load", faceCount, repeatCount, [&loadFile, &objFormat](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+			std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+			Mesh* loadedMesh = objFormat.LoadMesh(loadFile);
+			double time = MillisecondsSince(startTime);
+			memory = loadedMesh ? EstimateMeshMemory(loadedMesh) : 0;
+			delete loadedMesh;
+			return time;
+		});
+
+		// Welding is what happens when a mesh is made from a polygon soup, as when a file gives each face its own vertices.
+		std::vector<Mesh::ConvexPolygon> polygonArray;
+		mesh->ToPolygonArray(polygonArray);
+		MeasureStage(meshName, "weld", faceCount, repeatCount, [&polygonArray](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+			Mesh weldedMesh;
+			std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+			weldedMesh.FromPolygonArray(polygonArray);
+			double time = MillisecondsSince(startTime);
+			memory = EstimateMeshMemory(&weldedMesh);
+			return time;
+		});
+	}
+
+	::remove(BENCHMARK_TEMP_FILE);
+
+	// This is a pass over all the vertices that does hardly anything with each one, so it mostly
+	// measures how fast they can be streamed in, which is what single-precision storage speeds up.
+	MeasureStage(meshName, "bounding_box", faceCount, repeatCount, [mesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		AxisAlignedBox box = mesh->CalcBoundingBox();
+		double time = MillisecondsSince(startTime);
+		memory = int64_t(mesh->GetNumVertices()) * sizeof(Mesh::Vertex);
+		return box.IsValid() ? time : 0.0;
+	});
+
+	MeasureStage(meshName, "tree_build", faceCount, repeatCount, [mesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+		std::vector<BenchmarkFaceBox> faceBoxArray(mesh->GetNumFaces());
+		for (int i = 0; i < mesh->GetNumFaces(); i++)
+			for (int j : mesh->GetFace(i)->vertexArray)
+				faceBoxArray[i].box.MinimallyExpandToContainPoint(mesh->GetVertex(j)->point);
+
+		BoundingBoxTree tree;
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		tree.SetRootBox(mesh->CalcBoundingBox());
+		for (BenchmarkFaceBox& faceBox : faceBoxArray)
+			tree.AddGuest(&faceBox);
+		double time = MillisecondsSince(startTime);
+		memory = int64_t(faceBoxArray.size()) * sizeof(BenchmarkFaceBox);
+		return time;
+	});
+
+	MeasureStage(meshName, "graph_build", faceCount, repeatCount, [mesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+		MeshGraph graph;
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		graph.Generate(mesh);
+		double time = MillisecondsSince(startTime);
+		int64_t elementCount = 0;
+		graph.ForAllElements([&elementCount](MeshGraph::GraphElement* /*element*/) -> bool {
+			elementCount++;
+			return false;
+		});
+		memory = elementCount * sizeof(MeshGraph::Edge);
+		return time;
+	});
+
+	MeasureStage(meshName, "convex_hull", faceCount, repeatCount, [mesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+		std::vector<Vector> pointArray(mesh->GetNumVertices());
+		for (int i = 0; i < mesh->GetNumVertices(); i++)
+			pointArray[i] = mesh->GetVertex(i)->point;
+
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		Mesh* hullMesh = Mesh::GenerateConvexHull(pointArray);
+		double time = MillisecondsSince(startTime);
+		memory = hullMesh ? EstimateMeshMemory(hullMesh) : 0;
+		delete hullMesh;
+		return time;
+	});
+
+	MeasureStage(meshName, "triangulate", faceCount, repeatCount, [mesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		Mesh* triangleMesh = mesh->GenerateTriangleMesh();
+		double time = MillisecondsSince(startTime);
+		memory = EstimateMeshMemory(triangleMesh);
+		delete triangleMesh;
+		return time;
+	});
+
+	// This is what it costs to get a mesh into the fixed-size triangle form and then find
+	// everything the triangle form has a fast path for that a renderer or solver would want.
+	MeasureStage(meshName, "triangle_mesh", faceCount, repeatCount, [mesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+		Mesh* triangleMesh = mesh->GenerateTriangleMesh();
+		TriangleMesh fixedTriangleMesh;
+		std::vector<Vector3> faceNormalArray;
+		std::vector<int> neighborArray;
+
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		fixedTriangleMesh.MoveFromMesh(triangleMesh);
+		AxisAlignedBox box = fixedTriangleMesh.CalcBoundingBox();
+		fixedTriangleMesh.CalcFaceNormals(faceNormalArray);
+		fixedTriangleMesh.CalcVertexNormals();
+		fixedTriangleMesh.CalcAdjacency(neighborArray);
+		double time = MillisecondsSince(startTime);
+
+		memory = int64_t(fixedTriangleMesh.GetNumVertices()) * sizeof(Mesh::Vertex) + int64_t(fixedTriangleMesh.GetNumTriangles()) * sizeof(TriangleMesh::Triangle);
+		delete triangleMesh;
+		return box.IsValid() ? time : 0.0;
+	});
+}
+
+// Time each kind of set operation on its own, so that the cost of one isn't hidden by another.
+static void BenchmarkSetOperations(const std::string& meshName, Mesh* meshA, Mesh* meshB, int repeatCount)
+{
+	struct SetOp
+	{
+		int flag;
+		const char* name;
+	};
+
+	static const SetOp setOpArray[] =
+	{
+		{ MW_FLAG_UNION_SET_OP, "union" },
+		{ MW_FLAG_INTERSECTION_SETP_OP, "intersection" },
+		{ MW_FLAG_A_MINUS_B_SET_OP, "a_minus_b" },
+		{ MW_FLAG_B_MINUS_A_SET_OP, "b_minus_a" }
+	};
+
+	int faceCount = meshA->GetNumFaces() + meshB->GetNumFaces();
+
+	for (const SetOp& setOp : setOpArray)
+	{
+		MeasureStage(meshName, setOp.name, faceCount, repeatCount, [meshA, meshB, &setOp](int64_t& memory, std::string& statisticsJSON) -> double {
+			MeshOperation::Statistics statistics;
+			MeshOperation* meshOp = new MeshSetOperation(setOp.flag);
+			meshOp->statistics = &statistics;
+
+			std::vector<Mesh*> inputMeshArray, outputMeshArray;
+			inputMeshArray.push_back(meshA);
+			inputMeshArray.push_back(meshB);
+
+			std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+			if (!meshOp->Calculate(inputMeshArray, outputMeshArray))
+				std::cerr << "Set operation failed: " << *meshOp->error << std::endl;
+			double time = MillisecondsSince(startTime);
+
+			memory = statistics.peakAllocation;
+			for (const Mesh* mesh : outputMeshArray)
+				memory += EstimateMeshMemory(mesh);
+
+			statisticsJSON = statistics.ToJSON();
+
+			for (Mesh* mesh : outputMeshArray)
+				delete mesh;
+
+			delete meshOp;
+			return time;
+		});
+	}
+}
+
+static std::string EscapeJSON(const std::string& string)
+{
+	std::string escapedString;
+	for (char ch : string)
+	{
+		if (ch == '"' || ch == '\\')
+			escapedString += '\\';
+		escapedString += ch;
+	}
+
+	return escapedString;
+}
+
+static bool SaveMeshBenchmarkResults(const std::string& filePath)
+{
+	std::ofstream fileStream(filePath);
+	if (!fileStream.is_open())
+		return false;
+
+	fileStream << "{\n\"vertex_storage\": \"" << BENCHMARK_VERTEX_STORAGE << "\", \"vertex_bytes\": " << sizeof(Mesh::Vertex) << ",\n";
+	fileStream << "\"results\": [\n";
+
+	for (int i = 0; i < (int)meshBenchmarkResultArray.size(); i++)
+	{
+		const MeshBenchmarkResult& result = meshBenchmarkResultArray[i];
+
+		fileStream << std::setprecision(9);
+		fileStream << "{\"mesh\": \"" << EscapeJSON(result.meshName) << "\", ";
+		fileStream << "\"stage\": \"" << EscapeJSON(result.stageName) << "\", ";
+		fileStream << "\"faces\": " << result.faceCount << ", ";
+		fileStream << "\"repeat\": " << result.repeatCount << ", ";
+		fileStream << "\"min_ms\": " << result.minTime << ", ";
+		fileStream << "\"median_ms\": " << result.medianTime << ", ";
+		fileStream << "\"mean_ms\": " << result.meanTime << ", ";
+		fileStream << "\"deviation_ms\": " << result.deviation << ", ";
+		fileStream << "\"memory_bytes\": " << result.memory;
+		if (!result.statisticsJSON.empty())
+			fileStream << ", \"statistics\": " << result.statisticsJSON;
+		fileStream << "}" << (i + 1 < (int)meshBenchmarkResultArray.size() ? "," : "") << "\n";
+	}
+
+	fileStream << "]\n}\n";
+	return fileStream.good();
+}
+
+// These don't need any assets.  Each shape is made at about a quarter as many faces as it was the last
+// time, down from the largest size, and then a sphere and a torus cutting through it are set against
+// each other at every size the set operations are allowed.
+static void BenchmarkGeneratedMeshes(const MeshBenchmarkOptions& options)
+{
+	MeshGenerator generator;
+
+	for (int faceCount = options.minFaces; faceCount <= options.maxFaces; faceCount *= 4)
+	{
+		// A triangulated sphere or torus with N segments each way has about 2N^2 faces, and a box about 12N^2.
+		int segmentCount = int(::sqrt(double(faceCount) / 2.0));
+		int boxSegmentCount = int(::sqrt(double(faceCount) / 12.0));
+
+		struct GeneratedMesh
+		{
+			const char* name;
+			std::function<Mesh*()> generateFunc;
+		};
+
+		GeneratedMesh generatedMeshArray[] = {
+			{ "GenSphere", [&]() { return generator.GenerateSphere(Sphere(Vector(0.0, 0.0, 0.0), 1.0), segmentCount, segmentCount); } },
+			{ "GenBox", [&]() { return generator.GenerateBox(AxisAlignedBox(Vector(-1.0, -1.0, -1.0), Vector(1.0, 1.0, 1.0)), boxSegmentCount); } },
+			{ "GenCylinder", [&]() { return generator.GenerateCylinder(Cylinder(Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 1.0), 1.0), 2.0, segmentCount, segmentCount / 2); } },
+			{ "GenTorus", [&]() { return generator.GenerateTorus(Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 1.0), 1.0, 0.3, segmentCount, segmentCount); } }
+		};
+
+		for (const GeneratedMesh& generatedMesh : generatedMeshArray)
+		{
+			Mesh* mesh = generatedMesh.generateFunc();
+			std::string meshName = std::string(generatedMesh.name) + "_" + std::to_string(mesh->GetNumFaces());
+			int meshFaceCount = mesh->GetNumFaces();
+			delete mesh;
+
+			MeasureStage(meshName, "generate", meshFaceCount, options.repeatCount, [&generatedMesh](int64_t& memory, std::string& /*statisticsJSON*/) -> double {
+				auto startTime = std::chrono::high_resolution_clock::now();
+				Mesh* mesh = generatedMesh.generateFunc();
+				double time = MillisecondsSince(startTime);
+				memory = EstimateMeshMemory(mesh);
+				delete mesh;
+				return time;
+			});
+		}
+
+		if (2 * faceCount <= options.maxSetOpFaces)
+		{
+			Mesh* sphereMesh = generator.GenerateSphere(Sphere(Vector(0.0, 0.0, 0.0), 1.0), segmentCount, segmentCount);
+			Mesh* torusMesh = generator.GenerateTorus(Vector(0.3, 0.2, 0.1), Vector(1.0, 0.0, 0.2), 1.0, 0.3, segmentCount, segmentCount);
+			BenchmarkSetOperations("GenSphere/GenTorus_" + std::to_string(sphereMesh->GetNumFaces()), sphereMesh, torusMesh, options.repeatCount);
+			delete sphereMesh;
+			delete torusMesh;
+		}
+	}
+}
+
+static void BenchmarkMeshes(const MeshBenchmarkOptions& options)
+{
+	std::cout << "Mesh stages (" << options.repeatCount << " runs each, times in ms, memory in MB)" << std::endl;
+	std::cout << "Vertex storage is " << BENCHMARK_VERTEX_STORAGE << ", " << sizeof(Mesh::Vertex) << " bytes per vertex" << std::endl;
+	std::cout << std::setw(20) << "mesh" << std::setw(18) << "stage" << std::setw(10) << "faces";
+	std::cout << std::setw(12) << "min" << std::setw(12) << "median" << std::setw(10) << "stddev";
+	std::cout << std::setw(14) << "faces/s" << std::setw(12) << "memory" << std::endl;
+
+	OBJFormat objFormat;
+	std::map<std::string, Mesh*> assetMap;
+
+	const char* assetNameArray[] = { "MeshA", "MeshB", "BoxA", "BoxB", "Sphere", "Teapot" };
+	for (const char* assetName : assetNameArray)
+	{
+		std::string assetFile = options.assetPath + "/" + assetName + ".obj";
+		Mesh* mesh = objFormat.LoadMesh(assetFile);
+		if (!mesh || mesh->GetNumFaces() == 0)
+		{
+			delete mesh;
+			std::cerr << "Failed to load " << assetFile << std::endl;
+			continue;
+		}
+
+		*mesh->name = assetName;
+		assetMap[assetName] = mesh;
+		BenchmarkMeshStages(assetName, mesh, assetFile, options);
+	}
+
+	if (assetMap.find("MeshA") != assetMap.end() && assetMap.find("MeshB") != assetMap.end())
+		BenchmarkSetOperations("MeshA/MeshB", assetMap["MeshA"], assetMap["MeshB"], options.repeatCount);
+
+	if (assetMap.find("BoxA") != assetMap.end() && assetMap.find("BoxB") != assetMap.end())
+		BenchmarkSetOperations("BoxA/BoxB", assetMap["BoxA"], assetMap["BoxB"], options.repeatCount);
+
+	// The bigger meshes are the teapot, subdivided over and over, and a sphere biting into its side,
+	// subdivided until it is about as fine.
+	if (assetMap.find("Teapot") != assetMap.end() && assetMap.find("Sphere") != assetMap.end())
+	{
+		Mesh* teapotMesh = assetMap["Teapot"];
+		AxisAlignedBox teapotBox = teapotMesh->CalcBoundingBox();
+		double teapotWidth = teapotBox.max.x - teapotBox.min.x;
+		Mesh* sphereMesh = PlaceMesh(assetMap["Sphere"], teapotBox.min + (teapotBox.max - teapotBox.min) * 0.3, teapotWidth * 0.4);
+
+		BenchmarkSetOperations("Teapot/Sphere", teapotMesh, sphereMesh, options.repeatCount);
+
+		Mesh* meshA = teapotMesh;
+		Mesh* meshB = sphereMesh;
+
+		while (true)
+		{
+			Mesh* subdividedMeshA = SubdivideMesh(meshA);
+			if (meshA != teapotMesh)
+				delete meshA;
+			meshA = subdividedMeshA;
+
+			if (meshA->GetNumFaces() > options.maxFaces)
+				break;
+
+			while (meshB->GetNumFaces() * 4 <= meshA->GetNumFaces())
+			{
+				Mesh* subdividedMeshB = SubdivideMesh(meshB);
+				delete meshB;
+				meshB = subdividedMeshB;
+			}
+
+			if (meshA->GetNumFaces() < options.minFaces)
+				continue;
+
+			std::string meshName = "Teapot_" + std::to_string(meshA->GetNumFaces());
+			BenchmarkMeshStages(meshName, meshA, "", options);
+
+			if (meshA->GetNumFaces() + meshB->GetNumFaces() <= options.maxSetOpFaces)
+				BenchmarkSetOperations(meshName + "/Sphere_" + std::to_string(meshB->GetNumFaces()), meshA, meshB, options.repeatCount);
+		}
+
+		if (meshA != teapotMesh)
+			delete meshA;
+
+		delete meshB;
+	}
+
+	for (std::pair<const std::string, Mesh*>& pair : assetMap)
+		delete pair.second;
+
+	BenchmarkGeneratedMeshes(options);
+}
+
+static void PrintUsage()
+{
+	std::cout << "Usage: Benchmark [options] [compressor] [predicates] [triangulation] [meshes]" << std::endl;
+	std::cout << "  Runs the named benchmarks, or all of them if none are named." << std::endl;
+	std::cout << "  --assets <path>       Where to find the test meshes (default: ../Test)" << std::endl;
+	std::cout << "  --repeat <count>      How many times to run each mesh stage (default: " << BENCHMARK_DEFAULT_REPEAT_COUNT << ")" << std::endl;
+	std::cout << "  --min-faces <count>   Smallest subdivided mesh to benchmark (default: " << BENCHMARK_DEFAULT_MIN_FACES << ")" << std::endl;
+	std::cout << "  --max-faces <count>   Largest subdivided mesh to benchmark (default: " << BENCHMARK_DEFAULT_MAX_FACES << ")" << std::endl;
+	std::cout << "  --max-set-op-faces <count>  Most faces to give the set operations (default: " << BENCHMARK_DEFAULT_MAX_SET_OP_FACES << ")" << std::endl;
+	std::cout << "  --max-weld-faces <count>    Most faces to load or weld (default: " << BENCHMARK_DEFAULT_MAX_WELD_FACES << ")" << std::endl;
+	std::cout << "  --json <file>         Also write the mesh benchmark results to the given file" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	MeshBenchmarkOptions options;
+	options.repeatCount = BENCHMARK_DEFAULT_REPEAT_COUNT;
+	options.minFaces = BENCHMARK_DEFAULT_MIN_FACES;
+	options.maxFaces = BENCHMARK_DEFAULT_MAX_FACES;
+	options.maxSetOpFaces = BENCHMARK_DEFAULT_MAX_SET_OP_FACES;
+	options.maxWeldFaces = BENCHMARK_DEFAULT_MAX_WELD_FACES;
+	options.assetPath = "../Test";
+
+	std::string jsonFile;
+	std::vector<std::string> benchmarkNameArray;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (::strcmp(argv[i], "--assets") == 0 && hasValue)
+			options.assetPath = argv[++i];
+		else if (::strcmp(argv[i], "--repeat") == 0 && hasValue)
+			options.repeatCount = ::atoi(argv[++i]);
+		else if (::strcmp(argv[i], "--min-faces") == 0 && hasValue)
+			options.minFaces = ::atoi(argv[++i]);
+		else if (::strcmp(argv[i], "--max-faces") == 0 && hasValue)
+			options.maxFaces = ::atoi(argv[++i]);
+		else if (::strcmp(argv[i], "--max-set-op-faces") == 0 && hasValue)
+			options.maxSetOpFaces = ::atoi(argv[++i]);
+		else if (::strcmp(argv[i], "--max-weld-faces") == 0 && hasValue)
+			options.maxWeldFaces = ::atoi(argv[++i]);
+		else if (::strcmp(argv[i], "--json") == 0 && hasValue)
+			jsonFile = argv[++i];
+		else if (argv[i][0] != '-')
+			benchmarkNameArray.push_back(argv[i]);
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	// Every stage has to run at least once for there to be anything to report.
+	options.repeatCount = MW_MAX(options.repeatCount, 1);
+
+	auto shouldRun = [&benchmarkNameArray](const char* name) -> bool {
+		return benchmarkNameArray.size() == 0 || std::find(benchmarkNameArray.begin(), benchmarkNameArray.end(), name) != benchmarkNameArray.end();
+	};
+
+	if (shouldRun("compressor"))
+	{
+		BenchmarkCompressor();
+		std::cout << std::endl;
+	}
+
+	if (shouldRun("predicates"))
+	{
+		BenchmarkPredicates();
+		std::cout << std::endl;
+	}
+
+	if (shouldRun("triangulation"))
+	{
+		BenchmarkTriangulation();
+		std::cout << std::endl;
+	}
+
+	if (shouldRun("meshes"))
+	{
+		BenchmarkMeshes(options);
+
+		if (!jsonFile.empty() && !SaveMeshBenchmarkResults(jsonFile))
+		{
+			std::cerr << "Failed to write " << jsonFile << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
\ No newline at end of file
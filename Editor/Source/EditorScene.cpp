@@ -125,10 +125,13 @@ void EditorScene::MeshRenderObject::DrawMesh() const
 
 /*virtual*/ void EditorScene::MeshRenderObject::SolidifyTransform()
 {
-	// TODO: Apply the local-to-world transform to the mesh, then reset the local-to-world transform.
-	//       This is also where we would rebuild our vertex buffers, by the way.
-
+	// If the transform can't be applied, it stays where it is, so nothing is lost.
+	if (!this->mesh->ApplyTransform(this->localToWorldTransform))
+		return;
 
+	// This is also where we would rebuild our vertex buffers, by the way.
+	delete this->triMesh;
+	this->triMesh = nullptr;
 
 	this->localToWorldTransform.SetIdentity();
 }
\ No newline at end of file
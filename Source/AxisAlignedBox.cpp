@@ -1,4 +1,5 @@
 #include "AxisAlignedBox.h"
+#include "Vector3.h"
 #include <float.h>
 
 using namespace MeshWarrior;
@@ -33,6 +34,13 @@ AxisAlignedBox::AxisAlignedBox(const AxisAlignedBox& box)
 {
 }
 
+AxisAlignedBox& AxisAlignedBox::operator=(const AxisAlignedBox& box)
+{
+	this->min = box.min;
+	this->max = box.max;
+	return *this;
+}
+
 bool AxisAlignedBox::IsValid() const
 {
 	if (this->min.x > this->max.x)
@@ -55,14 +63,7 @@ bool AxisAlignedBox::IsValid() const
 
 /*virtual*/ bool AxisAlignedBox::ContainsPoint(const Vector& point, double eps /*= 0.0*/) const
 {
-	if (this->min.x <= point.x && point.x <= this->max.x &&
-		this->min.y <= point.y && point.y <= this->max.y &&
-		this->min.z <= point.z && point.z <= this->max.z)
-	{
-		return true;
-	}
-
-	return false;
+	return Box3(*this).ContainsPoint(Vector3(point));
 }
 
 bool AxisAlignedBox::ContainsPointOnBoundary(const Vector& point, double eps /*= MW_EPS*/) const
@@ -75,7 +76,7 @@ bool AxisAlignedBox::ContainsPointOnBoundary(const Vector& point, double eps /*=
 
 bool AxisAlignedBox::ContainsBox(const AxisAlignedBox& box) const
 {
-	return this->ContainsPoint(box.min) && this->ContainsPoint(box.max);
+	return Box3(*this).ContainsBox(Box3(box));
 }
 
 void AxisAlignedBox::ScaleAboutCenter(double delta)
@@ -167,8 +168,7 @@ bool AxisAlignedBox::Intersect(const AxisAlignedBox& boxA, const AxisAlignedBox&
 
 bool AxisAlignedBox::OverlapsWith(const AxisAlignedBox& box) const
 {
-	AxisAlignedBox intersection;
-	return intersection.Intersect(*this, box);
+	return Box3(*this).OverlapsWith(Box3(box));
 }
 
 void AxisAlignedBox::SplitReasonably(AxisAlignedBox& boxA, AxisAlignedBox& boxB) const
@@ -15,6 +15,8 @@ namespace MeshWarrior
 		AxisAlignedBox(const AxisAlignedBox& box);
 		virtual ~AxisAlignedBox();
 
+		AxisAlignedBox& operator=(const AxisAlignedBox& box);
+
 		bool IsValid() const;
 
 		virtual double ShortestSignedDistanceToPoint(const Vector& point) const override;
@@ -17,7 +17,7 @@ void BoundingBoxTree::SetRootBox(const AxisAlignedBox& box)
 	if (!this->rootNode)
 	{
 		this->rootNode = new Node();
-		this->rootNode->boundingBox = box;
+		this->rootNode->boundingBox = Box3(box);
 	}
 }
 
@@ -26,7 +26,7 @@ bool BoundingBoxTree::AddGuest(Guest* guest)
 	if (!this->rootNode)
 		return false;
 
-	return this->rootNode->AddGuest(guest, 1, 16);
+	return this->rootNode->AddGuest(guest, Box3(guest->CalcBoundingBox()), 1, 16);
 }
 
 void BoundingBoxTree::FindGuests(const AxisAlignedBox& box, std::list<Guest*>& foundGuestList) const
@@ -34,7 +34,7 @@ void BoundingBoxTree::FindGuests(const AxisAlignedBox& box, std::list<Guest*>& f
 	foundGuestList.clear();
 
 	if (this->rootNode)
-		this->rootNode->FindGuests(box, foundGuestList);
+		this->rootNode->FindGuests(Box3(box), foundGuestList);
 }
 
 int BoundingBoxTree::TotalGuests() const
@@ -81,9 +81,9 @@ BoundingBoxTree::Node::Node()
 	delete this->node[1];
 }
 
-bool BoundingBoxTree::Node::AddGuest(Guest* guest, int currentDepth, int maxDepth)
+bool BoundingBoxTree::Node::AddGuest(Guest* guest, const Box3& guestBox, int currentDepth, int maxDepth)
 {
-	if (!this->boundingBox.ContainsBox(guest->CalcBoundingBox()))
+	if (!this->boundingBox.ContainsBox(guestBox))
 		return false;
 
 	if (!this->node[0])
@@ -91,19 +91,23 @@ bool BoundingBoxTree::Node::AddGuest(Guest* guest, int currentDepth, int maxDept
 		this->node[0] = new Node();
 		this->node[1] = new Node();
 
-		this->boundingBox.SplitReasonably(this->node[0]->boundingBox, this->node[1]->boundingBox);
+		AxisAlignedBox boxA, boxB;
+		this->boundingBox.ToAxisAlignedBox().SplitReasonably(boxA, boxB);
+		this->node[0]->boundingBox = Box3(boxA);
+		this->node[1]->boundingBox = Box3(boxB);
 	}
 
 	if (currentDepth < maxDepth)
 		for (int i = 0; i < 2; i++)
-			if (this->node[i]->AddGuest(guest, currentDepth + 1, maxDepth))
+			if (this->node[i]->AddGuest(guest, guestBox, currentDepth + 1, maxDepth))
 				return true;
 
-	this->guestList.push_back(guest);
+	this->guestArray.push_back(guest);
+	this->guestBoxArray.push_back(guestBox);
 	return true;
 }
 
-void BoundingBoxTree::Node::FindGuests(const AxisAlignedBox& box, std::list<Guest*>& foundGuestList) const
+void BoundingBoxTree::Node::FindGuests(const Box3& box, std::list<Guest*>& foundGuestList) const
 {
 	if (!this->boundingBox.OverlapsWith(box))
 		return;
@@ -112,14 +116,14 @@ void BoundingBoxTree::Node::FindGuests(const AxisAlignedBox& box, std::list<Gues
 		if (this->node[i])
 			this->node[i]->FindGuests(box, foundGuestList);
 
-	for (Guest* guest : this->guestList)
-		if (box.OverlapsWith(guest->CalcBoundingBox()))
-			foundGuestList.push_back(guest);
+	for (int i = 0; i < (int)this->guestArray.size(); i++)
+		if (box.OverlapsWith(this->guestBoxArray[i]))
+			foundGuestList.push_back(this->guestArray[i]);
 }
 
 void BoundingBoxTree::Node::TallyGuests(int& tally) const
 {
-	tally += (int)this->guestList.size();
+	tally += (int)this->guestArray.size();
 
 	for (int i = 0; i < 2; i++)
 		if (this->node[i])
@@ -128,7 +132,7 @@ void BoundingBoxTree::Node::TallyGuests(int& tally) const
 
 void BoundingBoxTree::Node::GatherAllGuests(std::list<Guest*>& givenGuestList) const
 {
-	for (Guest* guest : this->guestList)
+	for (Guest* guest : this->guestArray)
 		givenGuestList.push_back(guest);
 
 	for (int i = 0; i < 2; i++)
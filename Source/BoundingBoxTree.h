@@ -2,10 +2,13 @@
 
 #include "Defines.h"
 #include "AxisAlignedBox.h"
+#include "Vector3.h"
+#include <vector>
 #include <list>
 
 namespace MeshWarrior
 {
+	// A guest's box is taken when it's added, and kept alongside it, so it mustn't change while the guest is in the tree.
 	class MESH_WARRIOR_API BoundingBoxTree
 	{
 	public:
@@ -36,14 +39,15 @@ namespace MeshWarrior
 			Node();
 			virtual ~Node();
 
-			bool AddGuest(Guest* guest, int currentDepth, int maxDepth);
-			void FindGuests(const AxisAlignedBox& box, std::list<Guest*>& foundGuestList) const;
+			bool AddGuest(Guest* guest, const Box3& guestBox, int currentDepth, int maxDepth);
+			void FindGuests(const Box3& box, std::list<Guest*>& foundGuestList) const;
 			void TallyGuests(int& tally) const;
 			void GatherAllGuests(std::list<Guest*>& givenGuestList) const;
 
-			AxisAlignedBox boundingBox;
+			Box3 boundingBox;
 			Node* node[2];
-			std::list<Guest*> guestList;
+			std::vector<Guest*> guestArray;
+			std::vector<Box3> guestBoxArray;
 		};
 
 		Node* rootNode;
@@ -1,17 +1,105 @@
 #pragma once
 
 #include "Defines.h"
+#include "Vector.h"
 #include <vector>
 #include <functional>
 #include <list>
+#include <unordered_map>
+#include <algorithm>
+#include <math.h>
+
+// Arrays up to this size are compressed with all-pairs testing in fixed-size storage.
+#define MW_COMPRESSOR_SMALL_ARRAY_SIZE		16
+
+// This is the most cells a single array member can be bucketed into.
+#define MW_COMPRESSOR_MAX_CELLS				2
 
 namespace MeshWarrior
 {
+	// This identifies a cube of space in a uniform grid.  Two members of an array
+	// are only ever considered for compression if one of their cells neighbors
+	// (or is) one of the other's cells, so the cell size must be at least as big
+	// as the distance within which the compressor function would combine members.
+	struct CompressorCell
+	{
+		long long i, j, k;
+
+		static CompressorCell FromPoint(const Vector& point, double cellSize)
+		{
+			CompressorCell cell;
+			cell.i = (long long)::floor(point.x / cellSize);
+			cell.j = (long long)::floor(point.y / cellSize);
+			cell.k = (long long)::floor(point.z / cellSize);
+			return cell;
+		}
+
+		bool operator==(const CompressorCell& cell) const
+		{
+			return this->i == cell.i && this->j == cell.j && this->k == cell.k;
+		}
+
+		struct Hash
+		{
+			size_t operator()(const CompressorCell& cell) const
+			{
+				size_t hash = std::hash<long long>()(cell.i);
+				hash = hash * 31 + std::hash<long long>()(cell.j);
+				hash = hash * 31 + std::hash<long long>()(cell.k);
+				return hash;
+			}
+		};
+	};
+
+	// Small arrays are common (e.g., when de-duplicating the few points of a polygon intersection),
+	// so here we test all pairs without ever touching the heap.  Since every compression removes
+	// two members and adds one, no more than 2N-1 slots can ever be needed.  False is returned if
+	// the given array is too big for this to work.
+	template<typename Type>
+	bool CompressSmallArray(std::vector<Type*>& givenArray, const std::function<Type*(const Type*, const Type*)>& compressorFunc)
+	{
+		if (givenArray.size() > MW_COMPRESSOR_SMALL_ARRAY_SIZE)
+			return false;
+
+		Type* slotArray[2 * MW_COMPRESSOR_SMALL_ARRAY_SIZE];
+		int slotCount = 0;
+		for (Type* type : givenArray)
+			slotArray[slotCount++] = type;
+
+		for (int j = 1; j < slotCount; j++)
+		{
+			for (int i = 0; i < j && slotArray[j] != nullptr; i++)
+			{
+				if (slotArray[i] != nullptr)
+				{
+					// If the compressor function returns a new allocation, it should delete the given allocations.
+					Type* newType = compressorFunc(slotArray[i], slotArray[j]);
+					if (newType)
+					{
+						slotArray[i] = nullptr;
+						slotArray[j] = nullptr;
+						slotArray[slotCount++] = newType;
+					}
+				}
+			}
+		}
+
+		givenArray.clear();
+		for (int i = 0; i < slotCount; i++)
+			if (slotArray[i] != nullptr)
+				givenArray.push_back(slotArray[i]);
+
+		return true;
+	}
+
 	// Regardless of the order of the given array, this should consistently compress if
 	// the given compression function is both associative and commutative.
 	template<typename Type>
 	void CompressArray(std::vector<Type*>& givenArray, std::function<Type*(const Type*, const Type*)> compressorFunc)
 	{
+		if (CompressSmallArray(givenArray, compressorFunc))
+			return;
+
 		struct Pair
 		{
 			int i, j;
@@ -56,4 +144,93 @@ namespace MeshWarrior
 
 		givenArray = contiguousArray;
 	}
+
+	// This is the same as the above, but only members bucketed into the same or neighboring
+	// cells are ever tested against one another, which makes the whole thing roughly linear
+	// in the size of the given array instead of quadratic.  The cell function fills in the
+	// given cell array (which has room for MW_COMPRESSOR_MAX_CELLS cells) and returns how
+	// many cells it used.  A polyline, for example, is bucketed by both of its end-points.
+	template<typename Type>
+	void CompressArray(std::vector<Type*>& givenArray, std::function<Type*(const Type*, const Type*)> compressorFunc, std::function<int(const Type*, CompressorCell*)> cellFunc)
+	{
+		if (CompressSmallArray(givenArray, compressorFunc))
+			return;
+
+		typedef std::unordered_map<CompressorCell, std::vector<int>, CompressorCell::Hash> CellMap;
+		CellMap cellMap;
+
+		auto bucketMember = [&givenArray, &cellMap, &cellFunc](int i) {
+			CompressorCell cellArray[MW_COMPRESSOR_MAX_CELLS];
+			int cellCount = cellFunc(givenArray[i], cellArray);
+			for (int j = 0; j < cellCount; j++)
+				cellMap[cellArray[j]].push_back(i);
+		};
+
+		int originalCount = (int)givenArray.size();
+		for (int i = 0; i < originalCount; i++)
+			bucketMember(i);
+
+		std::vector<int> candidateArray;
+
+		// Note that the array grows as we go, and that new members get their own turn at the end.
+		for (int i = 0; i < (signed)givenArray.size(); i++)
+		{
+			if (givenArray[i] == nullptr)
+				continue;
+
+			// Original members only need to look ahead, because anything behind them already
+			// looked at them.  New members were never seen by anyone, so they look everywhere.
+			candidateArray.clear();
+			CompressorCell cellArray[MW_COMPRESSOR_MAX_CELLS];
+			int cellCount = cellFunc(givenArray[i], cellArray);
+			for (int j = 0; j < cellCount; j++)
+			{
+				for (long long di = -1; di <= 1; di++)
+				{
+					for (long long dj = -1; dj <= 1; dj++)
+					{
+						for (long long dk = -1; dk <= 1; dk++)
+						{
+							CompressorCell cell{ cellArray[j].i + di, cellArray[j].j + dj, cellArray[j].k + dk };
+							typename CellMap::iterator iter = cellMap.find(cell);
+							if (iter == cellMap.end())
+								continue;
+
+							for (int k : iter->second)
+								if (k != i && givenArray[k] != nullptr && (k > i || i >= originalCount))
+									candidateArray.push_back(k);
+						}
+					}
+				}
+			}
+
+			std::sort(candidateArray.begin(), candidateArray.end());
+			candidateArray.erase(std::unique(candidateArray.begin(), candidateArray.end()), candidateArray.end());
+
+			for (int j : candidateArray)
+			{
+				const Type* typeA = givenArray[MW_MIN(i, j)];
+				const Type* typeB = givenArray[MW_MAX(i, j)];
+
+				// If the compressor function returns a new allocation, it should delete the given allocations.
+				Type* newType = compressorFunc(typeA, typeB);
+				if (newType)
+				{
+					givenArray[i] = nullptr;
+					givenArray[j] = nullptr;
+
+					givenArray.push_back(newType);
+					bucketMember((int)givenArray.size() - 1);
+					break;
+				}
+			}
+		}
+
+		std::vector<Type*> contiguousArray;
+		for (int i = 0; i < (signed)givenArray.size(); i++)
+			if (givenArray[i] != nullptr)
+				contiguousArray.push_back(givenArray[i]);
+
+		givenArray = contiguousArray;
+	}
 }
\ No newline at end of file
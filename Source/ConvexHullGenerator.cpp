@@ -0,0 +1,560 @@
+#include "ConvexHullGenerator.h"
+#include "Mesh.h"
+#include "TaskScheduler.h"
+#include <float.h>
+#include <math.h>
+#include <mutex>
+#include <algorithm>
+
+// Below this many points, it's not worth waking up any other threads.
+#define MW_CONVEX_HULL_GRAIN_SIZE		4096
+
+using namespace MeshWarrior;
+
+static Plane3 MakeTrianglePlane(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC)
+{
+	Vector3 normal = (pointB - pointA) ^ (pointC - pointA);
+	double length = normal.Length();
+	if (length > 0.0)
+		normal = normal / length;
+
+	return Plane3((pointA + pointB + pointC) / 3.0, normal);
+}
+
+ConvexHullGenerator::ConvexHullGenerator()
+{
+	this->mergeCoplanarFaces = true;
+	this->concurrency = 0;
+	this->scheduler = nullptr;
+	this->pointArray = new std::vector<Vector3>();
+	this->faceArray = new std::vector<Face>();
+	this->freeFaceArray = new std::vector<int>();
+	this->pendingFaceArray = new std::vector<int>();
+	this->extremePointArray = new std::vector<int>();
+	this->extent = Vector3(0.0, 0.0, 0.0);
+	this->eps = 0.0;
+}
+
+/*virtual*/ ConvexHullGenerator::~ConvexHullGenerator()
+{
+	delete this->pointArray;
+	delete this->faceArray;
+	delete this->freeFaceArray;
+	delete this->pendingFaceArray;
+	delete this->extremePointArray;
+}
+
+Mesh* ConvexHullGenerator::Generate(const std::vector<Vector>& pointArray)
+{
+	if (pointArray.size() < 4)
+		return nullptr;
+
+	this->pointArray->resize(pointArray.size());
+	this->ParallelFor(0, (int)pointArray.size(), [this, &pointArray](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			(*this->pointArray)[i] = Vector3(pointArray[i]);
+	});
+
+	Mesh* mesh = nullptr;
+	if (this->MakeInitialHull())
+	{
+		this->ExpandHull();
+		mesh = this->MakeMesh();
+	}
+
+	// None of this is needed between hulls, and for a big cloud, it's a lot of memory to hang on to.
+	std::vector<Vector3>().swap(*this->pointArray);
+	std::vector<Face>().swap(*this->faceArray);
+	std::vector<int>().swap(*this->freeFaceArray);
+	std::vector<int>().swap(*this->pendingFaceArray);
+	this->extremePointArray->clear();
+
+	return mesh;
+}
+
+void ConvexHullGenerator::ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc)
+{
+	if (end - begin < MW_CONVEX_HULL_GRAIN_SIZE || this->concurrency == 1)
+		rangeFunc(begin, end);
+	else
+		(this->scheduler ? this->scheduler : TaskScheduler::GetDefault())->ParallelFor(begin, end, rangeFunc, MW_CONVEX_HULL_GRAIN_SIZE, this->concurrency);
+}
+
+// Ties go to the lower index, so that the answer doesn't depend on how the work was divided up.
+int ConvexHullGenerator::FindFarthestPoint(std::function<double(const Vector3&)> distanceFunc)
+{
+	int farthestPoint = -1;
+	double farthestDistance = -DBL_MAX;
+	std::mutex mutex;
+
+	this->ParallelFor(0, (int)this->pointArray->size(), [&](int begin, int end) {
+		int rangeFarthestPoint = -1;
+		double rangeFarthestDistance = -DBL_MAX;
+		for (int i = begin; i < end; i++)
+		{
+			double distance = distanceFunc((*this->pointArray)[i]);
+			if (distance > rangeFarthestDistance)
+			{
+				rangeFarthestDistance = distance;
+				rangeFarthestPoint = i;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (rangeFarthestDistance > farthestDistance || (rangeFarthestDistance == farthestDistance && rangeFarthestPoint < farthestPoint))
+		{
+			farthestDistance = rangeFarthestDistance;
+			farthestPoint = rangeFarthestPoint;
+		}
+	});
+
+	return farthestPoint;
+}
+
+// Start with a tetrahedron that's as big as we can easily find, then grow it to take in the extreme points along
+// each axis, which makes it an octahedron, more or less.  For a cloud that fills out its box at all evenly, most
+// of the points are inside that, and they're thrown out here in one parallel pass without ever being looked at again.
+bool ConvexHullGenerator::MakeInitialHull()
+{
+	const std::vector<Vector3>& pointArray = *this->pointArray;
+
+	int minPoint[3] = { 0, 0, 0 };
+	int maxPoint[3] = { 0, 0, 0 };
+	std::mutex mutex;
+
+	this->ParallelFor(0, (int)pointArray.size(), [&](int begin, int end) {
+		int rangeMinPoint[3] = { begin, begin, begin };
+		int rangeMaxPoint[3] = { begin, begin, begin };
+		for (int i = begin + 1; i < end; i++)
+		{
+			const double* coordinate = &pointArray[i].x;
+			for (int j = 0; j < 3; j++)
+			{
+				if (coordinate[j] < (&pointArray[rangeMinPoint[j]].x)[j])
+					rangeMinPoint[j] = i;
+				if (coordinate[j] > (&pointArray[rangeMaxPoint[j]].x)[j])
+					rangeMaxPoint[j] = i;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int j = 0; j < 3; j++)
+		{
+			double minCoordinate = (&pointArray[minPoint[j]].x)[j];
+			double maxCoordinate = (&pointArray[maxPoint[j]].x)[j];
+			double rangeMinCoordinate = (&pointArray[rangeMinPoint[j]].x)[j];
+			double rangeMaxCoordinate = (&pointArray[rangeMaxPoint[j]].x)[j];
+			if (rangeMinCoordinate < minCoordinate || (rangeMinCoordinate == minCoordinate && rangeMinPoint[j] < minPoint[j]))
+				minPoint[j] = rangeMinPoint[j];
+			if (rangeMaxCoordinate > maxCoordinate || (rangeMaxCoordinate == maxCoordinate && rangeMaxPoint[j] < maxPoint[j]))
+				maxPoint[j] = rangeMaxPoint[j];
+		}
+	});
+
+	// This is the tolerance used by qhull and most everyone since, and is about how far off a plane distance
+	// can be for points of this size, just from rounding error along the way.  It only goes into deciding
+	// whether the cloud is too flat to have a hull and which faces to merge at the end.  Whether a point is
+	// outside a face is always decided exactly, since deciding it within tolerance, for points that are
+	// nearly coplanar, can leave some of them outside the hull, or even turn some of its faces inside out.
+	double maxCoordinateSum = 0.0;
+	for (int j = 0; j < 3; j++)
+		maxCoordinateSum += MW_MAX(::fabs((&pointArray[minPoint[j]].x)[j]), ::fabs((&pointArray[maxPoint[j]].x)[j]));
+	this->eps = 3.0 * DBL_EPSILON * maxCoordinateSum;
+
+	// No two points are farther apart than this along each axis, which lets each face work out
+	// the error bound for its exact outside test once, instead of for every point it's given.
+	for (int j = 0; j < 3; j++)
+		(&this->extent.x)[j] = (&pointArray[maxPoint[j]].x)[j] - (&pointArray[minPoint[j]].x)[j];
+
+	this->extremePointArray->clear();
+	for (int j = 0; j < 3; j++)
+	{
+		this->extremePointArray->push_back(minPoint[j]);
+		this->extremePointArray->push_back(maxPoint[j]);
+	}
+
+	int pointA = 0, pointB = 0;
+	double maxDistance = 0.0;
+	for (int i : *this->extremePointArray)
+	{
+		for (int j : *this->extremePointArray)
+		{
+			double distance = (pointArray[j] - pointArray[i]).Length();
+			if (distance > maxDistance)
+			{
+				maxDistance = distance;
+				pointA = i;
+				pointB = j;
+			}
+		}
+	}
+
+	if (maxDistance <= this->eps)
+		return false;
+
+	Vector3 unitLineVector = (pointArray[pointB] - pointArray[pointA]) / maxDistance;
+	int pointC = this->FindFarthestPoint([&](const Vector3& point) -> double {
+		Vector3 vector = (point - pointArray[pointA]) ^ unitLineVector;
+		return Vector3::Dot(vector, vector);
+	});
+
+	if (((pointArray[pointC] - pointArray[pointA]) ^ unitLineVector).Length() <= this->eps)
+		return false;
+
+	Plane3 plane = MakeTrianglePlane(pointArray[pointA], pointArray[pointB], pointArray[pointC]);
+	int pointD = this->FindFarthestPoint([&](const Vector3& point) -> double {
+		return ::fabs(plane.ShortestSignedDistanceToPoint(point));
+	});
+
+	if (::fabs(plane.ShortestSignedDistanceToPoint(pointArray[pointD])) <= this->eps)
+		return false;
+
+	// Every face has to face away from the fourth point.
+	int orientation = Predicates::Orient3D(pointArray[pointA], pointArray[pointB], pointArray[pointC], pointArray[pointD]);
+	if (orientation == 0)
+		return false;
+	if (orientation > 0)
+		std::swap(pointB, pointC);
+
+	this->faceArray->clear();
+	this->freeFaceArray->clear();
+	this->pendingFaceArray->clear();
+	this->AddFace(pointA, pointB, pointC);
+	this->AddFace(pointA, pointD, pointB);
+	this->AddFace(pointB, pointD, pointC);
+	this->AddFace(pointC, pointD, pointA);
+
+	// Each edge of each face is matched up with the same edge going the other way.
+	std::vector<Face>& faceArray = *this->faceArray;
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 3; j++)
+			for (int k = 0; k < 4; k++)
+				for (int l = 0; l < 3; l++)
+					if (faceArray[i].vertex[j] == faceArray[k].vertex[(l + 1) % 3] && faceArray[i].vertex[(j + 1) % 3] == faceArray[k].vertex[l])
+						faceArray[i].neighbor[j] = k;
+
+	std::vector<int> candidateFaceArray{ 0, 1, 2, 3 };
+	this->AssignOutsidePoints(this->extremePointArray->data(), (int)this->extremePointArray->size(), candidateFaceArray);
+	this->ExpandHull();
+
+	candidateFaceArray.clear();
+	for (int i = 0; i < (int)faceArray.size(); i++)
+		if (!faceArray[i].deleted)
+			candidateFaceArray.push_back(i);
+
+	this->AssignOutsidePoints(nullptr, (int)pointArray.size(), candidateFaceArray);
+	return true;
+}
+
+// The neighbors are left for the caller to fill in.
+int ConvexHullGenerator::AddFace(int vertexA, int vertexB, int vertexC)
+{
+	int i = 0;
+	if (this->freeFaceArray->size() > 0)
+	{
+		i = this->freeFaceArray->back();
+		this->freeFaceArray->pop_back();
+	}
+	else
+	{
+		i = (int)this->faceArray->size();
+		this->faceArray->push_back(Face());
+	}
+
+	const std::vector<Vector3>& pointArray = *this->pointArray;
+	Face& face = (*this->faceArray)[i];
+	face.vertex[0] = vertexA;
+	face.vertex[1] = vertexB;
+	face.vertex[2] = vertexC;
+	face.neighbor[0] = face.neighbor[1] = face.neighbor[2] = -1;
+	face.plane = MakeTrianglePlane(pointArray[vertexA], pointArray[vertexB], pointArray[vertexC]);
+	Predicates::MakeOrient3DPlane(pointArray[vertexA], pointArray[vertexB], pointArray[vertexC], this->extent, face.orientPlane);
+	face.outsidePointArray.clear();
+	face.eyePoint = -1;
+	face.eyeDistance = 0.0;
+	face.deleted = false;
+	return i;
+}
+
+// Each of the given points (all of them, if no array is given) goes to whichever of the given faces it is farthest
+// outside of, if any.  Being outside is decided exactly, and only how far outside is left to the plane distance.
+// The choosing is done in parallel, and the handing out after, in order, so that every face's points, and so its
+// eye point, come out the same no matter how many threads there are.
+void ConvexHullGenerator::AssignOutsidePoints(const int* candidatePointArray, int candidatePointCount, const std::vector<int>& candidateFaceArray)
+{
+	std::vector<int> chosenFaceArray(candidatePointCount);
+	std::vector<double> distanceArray(candidatePointCount);
+
+	this->ParallelFor(0, candidatePointCount, [&](int begin, int end) {
+		const std::vector<Vector3>& pointArray = *this->pointArray;
+		const std::vector<Face>& faceArray = *this->faceArray;
+		for (int i = begin; i < end; i++)
+		{
+			const Vector3& point = pointArray[candidatePointArray ? candidatePointArray[i] : i];
+			chosenFaceArray[i] = -1;
+			distanceArray[i] = -DBL_MAX;
+			for (int j : candidateFaceArray)
+			{
+				const Face& face = faceArray[j];
+				if (Predicates::Orient3D(pointArray[face.vertex[0]], pointArray[face.vertex[1]], pointArray[face.vertex[2]], face.orientPlane, point) <= 0)
+					continue;
+
+				double distance = face.plane.ShortestSignedDistanceToPoint(point);
+				if (distance > distanceArray[i])
+				{
+					distanceArray[i] = distance;
+					chosenFaceArray[i] = j;
+				}
+			}
+		}
+	});
+
+	std::vector<Face>& faceArray = *this->faceArray;
+	for (int i = 0; i < candidatePointCount; i++)
+	{
+		if (chosenFaceArray[i] < 0)
+			continue;
+
+		Face& face = faceArray[chosenFaceArray[i]];
+		if (face.outsidePointArray.size() == 0)
+			this->pendingFaceArray->push_back(chosenFaceArray[i]);
+
+		face.outsidePointArray.push_back(candidatePointArray ? candidatePointArray[i] : i);
+		if (face.eyePoint < 0 || distanceArray[i] > face.eyeDistance)
+		{
+			face.eyeDistance = distanceArray[i];
+			face.eyePoint = face.outsidePointArray.back();
+		}
+	}
+}
+
+// A face can be on the pending list more than once, or have been deleted since it was put there,
+// but then it won't have any outside points anymore by the time we get to it.
+void ConvexHullGenerator::ExpandHull()
+{
+	while (this->pendingFaceArray->size() > 0)
+	{
+		int i = this->pendingFaceArray->back();
+		this->pendingFaceArray->pop_back();
+
+		const Face& face = (*this->faceArray)[i];
+		if (!face.deleted && face.outsidePointArray.size() > 0)
+			this->AddEyePoint(i);
+	}
+}
+
+// Every face the eye point can see gets replaced by a fan of new faces from the eye point to the horizon.
+void ConvexHullGenerator::AddEyePoint(int faceIndex)
+{
+	int eyePoint = (*this->faceArray)[faceIndex].eyePoint;
+
+	std::vector<int> visibleFaceArray;
+	std::vector<HorizonEdge> horizonEdgeArray;
+	this->FindHorizon(faceIndex, (*this->pointArray)[eyePoint], visibleFaceArray, horizonEdgeArray);
+
+	// The points outside the visible faces are either outside the new ones, or inside the hull now.
+	std::vector<int> orphanPointArray;
+	for (int i : visibleFaceArray)
+	{
+		Face& face = (*this->faceArray)[i];
+		for (int j : face.outsidePointArray)
+			if (j != eyePoint)
+				orphanPointArray.push_back(j);
+
+		std::vector<int>().swap(face.outsidePointArray);
+		this->freeFaceArray->push_back(i);
+	}
+
+	std::vector<int> newFaceArray;
+	for (const HorizonEdge& horizonEdge : horizonEdgeArray)
+	{
+		int i = this->AddFace(horizonEdge.vertexA, horizonEdge.vertexB, eyePoint);
+		(*this->faceArray)[i].neighbor[0] = horizonEdge.face;
+		(*this->faceArray)[horizonEdge.face].neighbor[horizonEdge.edge] = i;
+		newFaceArray.push_back(i);
+	}
+
+	// The horizon comes around in order, so each new face's neighbors in the fan are the ones before and after it.
+	int newFaceCount = (int)newFaceArray.size();
+	for (int i = 0; i < newFaceCount; i++)
+	{
+		Face& face = (*this->faceArray)[newFaceArray[i]];
+		face.neighbor[1] = newFaceArray[(i + 1) % newFaceCount];
+		face.neighbor[2] = newFaceArray[(i + newFaceCount - 1) % newFaceCount];
+	}
+
+	this->AssignOutsidePoints(orphanPointArray.data(), (int)orphanPointArray.size(), newFaceArray);
+}
+
+// Starting from a face the eye point can see, spread out across the edges to all the faces it can see, marking
+// them deleted as we go.  The edges across which we can't spread any farther make up the horizon.  Spreading
+// depth-first, and trying the edges of each face in order, walks the horizon around in order, CCW as seen
+// from the eye point, each edge starting where the one before it ended.  A face the eye point is exactly in
+// the plane of isn't visible, so the new faces never fold back over the ones left behind.
+void ConvexHullGenerator::FindHorizon(int faceIndex, const Vector3& eyePoint, std::vector<int>& visibleFaceArray, std::vector<HorizonEdge>& horizonEdgeArray)
+{
+	struct Step
+	{
+		int face;
+		int edge;
+		int edgeCount;
+	};
+
+	const std::vector<Vector3>& pointArray = *this->pointArray;
+	std::vector<Face>& faceArray = *this->faceArray;
+	std::vector<Step> stepStack;
+
+	faceArray[faceIndex].deleted = true;
+	visibleFaceArray.push_back(faceIndex);
+	stepStack.push_back(Step{ faceIndex, 0, 3 });
+
+	while (stepStack.size() > 0)
+	{
+		Step& step = stepStack.back();
+		if (step.edgeCount == 0)
+		{
+			stepStack.pop_back();
+			continue;
+		}
+
+		const Face& face = faceArray[step.face];
+		int i = step.edge;
+		step.edge = (i + 1) % 3;
+		step.edgeCount--;
+
+		int j = face.neighbor[i];
+		Face& neighborFace = faceArray[j];
+		if (neighborFace.deleted)
+			continue;
+
+		// The same edge goes the other way in the neighbor.
+		int vertexA = face.vertex[i];
+		int vertexB = face.vertex[(i + 1) % 3];
+		int k = (neighborFace.vertex[0] == vertexB) ? 0 : ((neighborFace.vertex[1] == vertexB) ? 1 : 2);
+
+		if (Predicates::Orient3D(pointArray[neighborFace.vertex[0]], pointArray[neighborFace.vertex[1]], pointArray[neighborFace.vertex[2]], neighborFace.orientPlane, eyePoint) > 0)
+		{
+			neighborFace.deleted = true;
+			visibleFaceArray.push_back(j);
+			stepStack.push_back(Step{ j, (k + 1) % 3, 2 });
+		}
+		else
+			horizonEdgeArray.push_back(HorizonEdge{ vertexA, vertexB, j, k });
+	}
+}
+
+// Neighboring triangles are gathered up into the same polygon as long as all their corners are on the
+// plane of the first one, within tolerance.  The edges of each polygon are then the edges of its triangles
+// that border some other polygon, and they're chained together, starting anywhere, to get its corners.
+Mesh* ConvexHullGenerator::MakeMesh() const
+{
+	const std::vector<Face>& faceArray = *this->faceArray;
+	int faceCount = (int)faceArray.size();
+	int pointCount = (int)this->pointArray->size();
+
+	std::vector<int> polygonArray(faceCount, -1);
+	std::vector<int> polygonFaceArray;
+	std::vector<int> polygonOffsetArray;
+
+	for (int i = 0; i < faceCount; i++)
+	{
+		if (faceArray[i].deleted || polygonArray[i] >= 0)
+			continue;
+
+		int polygon = (int)polygonOffsetArray.size();
+		polygonOffsetArray.push_back((int)polygonFaceArray.size());
+		polygonArray[i] = polygon;
+		polygonFaceArray.push_back(i);
+
+		if (!this->mergeCoplanarFaces)
+			continue;
+
+		const Plane3& plane = faceArray[i].plane;
+		for (int j = polygonOffsetArray.back(); j < (int)polygonFaceArray.size(); j++)
+		{
+			const Face& face = faceArray[polygonFaceArray[j]];
+			for (int k = 0; k < 3; k++)
+			{
+				int l = face.neighbor[k];
+				if (polygonArray[l] >= 0 || Vector3::Dot(faceArray[l].plane.unitNormal, plane.unitNormal) <= 0.0)
+					continue;
+
+				bool coplanar = true;
+				for (int m = 0; m < 3 && coplanar; m++)
+					coplanar = ::fabs(plane.ShortestSignedDistanceToPoint((*this->pointArray)[faceArray[l].vertex[m]])) <= this->eps;
+
+				if (coplanar)
+				{
+					polygonArray[l] = polygon;
+					polygonFaceArray.push_back(l);
+				}
+			}
+		}
+	}
+
+	polygonOffsetArray.push_back((int)polygonFaceArray.size());
+
+	Mesh* mesh = new Mesh();
+	std::vector<int> meshVertexArray(pointCount, -1);
+	std::vector<int> nextVertexArray(pointCount, -1);
+
+	auto addMeshVertex = [this, mesh, &meshVertexArray](int i) -> int {
+		if (meshVertexArray[i] < 0)
+		{
+			Mesh::Vertex vertex;
+			vertex.point = (*this->pointArray)[i].ToVector();
+			meshVertexArray[i] = mesh->AddVertex(vertex);
+		}
+
+		return meshVertexArray[i];
+	};
+
+	for (int polygon = 0; polygon < (int)polygonOffsetArray.size() - 1; polygon++)
+	{
+		int firstVertex = -1;
+		int edgeCount = 0;
+		for (int j = polygonOffsetArray[polygon]; j < polygonOffsetArray[polygon + 1]; j++)
+		{
+			const Face& face = faceArray[polygonFaceArray[j]];
+			for (int k = 0; k < 3; k++)
+			{
+				if (polygonArray[face.neighbor[k]] != polygon)
+				{
+					firstVertex = face.vertex[k];
+					nextVertexArray[face.vertex[k]] = face.vertex[(k + 1) % 3];
+					edgeCount++;
+				}
+			}
+		}
+
+		Mesh::Face meshFace;
+		int i = firstVertex;
+		do
+		{
+			meshFace.vertexArray.push_back(addMeshVertex(i));
+			i = nextVertexArray[i];
+		} while (i != firstVertex && i >= 0 && (int)meshFace.vertexArray.size() <= edgeCount);
+
+		// If the edges didn't chain together into one loop, rounding error must have made
+		// a mess of things, so fall back on putting in the triangles just as they are.
+		if (i != firstVertex || (int)meshFace.vertexArray.size() != edgeCount)
+		{
+			for (int j = polygonOffsetArray[polygon]; j < polygonOffsetArray[polygon + 1]; j++)
+			{
+				const Face& face = faceArray[polygonFaceArray[j]];
+				Mesh::Face triangleFace;
+				for (int k = 0; k < 3; k++)
+					triangleFace.vertexArray.push_back(addMeshVertex(face.vertex[k]));
+				mesh->AddFace(triangleFace);
+			}
+		}
+		else
+			mesh->AddFace(meshFace);
+
+		for (int j = polygonOffsetArray[polygon]; j < polygonOffsetArray[polygon + 1]; j++)
+			for (int k = 0; k < 3; k++)
+				nextVertexArray[faceArray[polygonFaceArray[j]].vertex[k]] = -1;
+	}
+
+	return mesh;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Defines.h"
+#include "Vector.h"
+#include "Vector3.h"
+#include "Predicates.h"
+#include <vector>
+#include <functional>
+
+namespace MeshWarrior
+{
+	class Mesh;
+	class TaskScheduler;
+
+	// This finds the convex hull of a cloud of points with the quickhull algorithm.  The hull starts out as
+	// the hull of the extreme points of the cloud along each axis, and every point inside that is thrown
+	// out before the rest of the work begins, which for most clouds is the bulk of them.  Each remaining
+	// point is then given to a face it is outside of, and the hull grows by its farthest outside point at a
+	// time.  Whenever there are enough points to give out at once, which is to say early on, they're sorted
+	// out to their faces in parallel.  Whether a point is outside a face is decided exactly, so every point
+	// ends up inside the hull or on it, however nearly coplanar they are.
+	class MESH_WARRIOR_API ConvexHullGenerator
+	{
+	public:
+		ConvexHullGenerator();
+		virtual ~ConvexHullGenerator();
+
+		// The faces are wound CCW when seen from the outside.  This gives null if
+		// the points are all coplanar, since then there's no volume to enclose.
+		Mesh* Generate(const std::vector<Vector>& pointArray);
+
+		// If set, which is the default, neighboring coplanar triangles of the hull are merged into
+		// convex polygons, so that, for example, the hull of the corners of a box has six faces.
+		bool mergeCoplanarFaces;
+
+		// These work the same as they do for mesh operations.
+		int concurrency;
+		TaskScheduler* scheduler;
+
+	private:
+
+		// While the hull is being built, it is made of triangles, each of which knows its neighbor
+		// across each of its edges.  Edge i goes from vertex i to vertex i + 1.
+		struct Face
+		{
+			int vertex[3];
+			int neighbor[3];
+			Plane3 plane;
+			Predicates::Orient3DPlane orientPlane;
+			std::vector<int> outsidePointArray;
+			int eyePoint;
+			double eyeDistance;
+			bool deleted;
+		};
+
+		struct HorizonEdge
+		{
+			int vertexA, vertexB;
+			int face, edge;
+		};
+
+		void ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc);
+		bool MakeInitialHull();
+		int FindFarthestPoint(std::function<double(const Vector3&)> distanceFunc);
+		int AddFace(int vertexA, int vertexB, int vertexC);
+		void AssignOutsidePoints(const int* candidatePointArray, int candidatePointCount, const std::vector<int>& candidateFaceArray);
+		void ExpandHull();
+		void AddEyePoint(int faceIndex);
+		void FindHorizon(int faceIndex, const Vector3& eyePoint, std::vector<int>& visibleFaceArray, std::vector<HorizonEdge>& horizonEdgeArray);
+		Mesh* MakeMesh() const;
+
+		std::vector<Vector3>* pointArray;
+		std::vector<Face>* faceArray;
+		std::vector<int>* freeFaceArray;
+		std::vector<int>* pendingFaceArray;
+		std::vector<int>* extremePointArray;
+		Vector3 extent;
+		double eps;
+	};
+}
\ No newline at end of file
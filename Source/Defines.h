@@ -8,6 +8,12 @@
 #	define MESH_WARRIOR_API
 #endif
 
+// Setting this to 1 stores the attributes of mesh vertices as floats rather than doubles, which makes
+// meshes less than half the size, at the cost of rounding every vertex to single precision.
+#if !defined MW_SINGLE_PRECISION_VERTICES
+#	define MW_SINGLE_PRECISION_VERTICES		0
+#endif
+
 #define MW_EPS					1e-5
 #define MW_PI					3.1415926536
 #define MW_TWO_PI				(2.0 * MW_PI)
@@ -1,6 +1,7 @@
 #include "FileFormat.h"
 #include "MeshOperations/MeshMergeOperation.h"
 #include "Mesh.h"
+#include "TriangleMesh.h"
 
 using namespace MeshWarrior;
 
@@ -53,5 +54,13 @@ bool FileFormat::SaveMesh(const std::string& meshFile, const Mesh& mesh)
 	std::vector<FileObject*> fileObjectArray;
 	fileObjectArray.push_back(const_cast<Mesh*>(&mesh));
 
+	return this->Save(meshFile, fileObjectArray);
+}
+
+bool FileFormat::SaveMesh(const std::string& meshFile, const TriangleMesh& mesh)
+{
+	std::vector<FileObject*> fileObjectArray;
+	fileObjectArray.push_back(const_cast<TriangleMesh*>(&mesh));
+
 	return this->Save(meshFile, fileObjectArray);
 }
\ No newline at end of file
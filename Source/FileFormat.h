@@ -8,6 +8,7 @@ namespace MeshWarrior
 {
 	class FileObject;
 	class Mesh;
+	class TriangleMesh;
 
 	class MESH_WARRIOR_API FileFormat
 	{
@@ -22,5 +23,6 @@ namespace MeshWarrior
 
 		Mesh* LoadMesh(const std::string& meshFile);
 		bool SaveMesh(const std::string& meshFile, const Mesh& mesh);
+		bool SaveMesh(const std::string& meshFile, const TriangleMesh& mesh);
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "OBJFormat.h"
+#include <limits.h>
 
 using namespace MeshWarrior;
 
@@ -131,7 +132,7 @@ void OBJFormat::FlushMesh(std::vector<FileObject*>& fileObjectArray)
 	}
 }
 
-void OBJFormat::LookupAndAssign(const std::vector<Vector>& vectorArray, int i, Vector& result)
+void OBJFormat::LookupAndAssign(const std::vector<Vector>& vectorArray, int i, Mesh::VertexVector& result)
 {
 	if (vectorArray.size() > 0 && i != INT_MAX)
 	{
@@ -171,6 +172,10 @@ void OBJFormat::LookupAndAssign(const std::vector<Vector>& vectorArray, int i, V
 		if (mesh)
 			this->DumpMesh(fileStream, mesh);
 
+		const TriangleMesh* triangleMesh = dynamic_cast<const TriangleMesh*>(fileObject);
+		if (triangleMesh)
+			this->DumpTriangleMesh(fileStream, triangleMesh);
+
 		const Polyline* polyline = dynamic_cast<const Polyline*>(fileObject);
 		if (polyline)
 			this->DumpPolyline(fileStream, polyline);
@@ -183,32 +188,38 @@ void OBJFormat::LookupAndAssign(const std::vector<Vector>& vectorArray, int i, V
 	return true;
 }
 
-void OBJFormat::DumpMesh(std::ofstream& fileStream, const Mesh* mesh)
+void OBJFormat::DumpVertices(std::ofstream& fileStream, const Mesh::Vertex* vertexArray, int vertexCount)
 {
-	for (int i = 0; i < mesh->GetNumVertices(); i++)
+	for (int i = 0; i < vertexCount; i++)
 	{
 		// TODO: Output vertex colors too?
-		const Mesh::Vertex* vertex = mesh->GetVertex(i);
+		const Mesh::Vertex* vertex = &vertexArray[i];
 		fileStream << "v " << vertex->point.x << " " << vertex->point.y << " " << vertex->point.z << "\n";
 	}
 
 	fileStream << "\n";
 
-	for (int i = 0; i < mesh->GetNumVertices(); i++)
+	for (int i = 0; i < vertexCount; i++)
 	{
-		const Mesh::Vertex* vertex = mesh->GetVertex(i);
+		const Mesh::Vertex* vertex = &vertexArray[i];
 		fileStream << "vt " << vertex->texCoords.x << " " << vertex->texCoords.y << " " << vertex->texCoords.z << "\n";
 	}
 
 	fileStream << "\n";
 
-	for (int i = 0; i < mesh->GetNumVertices(); i++)
+	for (int i = 0; i < vertexCount; i++)
 	{
-		const Mesh::Vertex* vertex = mesh->GetVertex(i);
+		const Mesh::Vertex* vertex = &vertexArray[i];
 		fileStream << "vn " << vertex->normal.x << " " << vertex->normal.y << " " << vertex->normal.z << "\n";
 	}
 
 	fileStream << "\n";
+}
+
+void OBJFormat::DumpMesh(std::ofstream& fileStream, const Mesh* mesh)
+{
+	this->DumpVertices(fileStream, mesh->GetVertex(0), mesh->GetNumVertices());
+
 	fileStream << "g " << mesh->name->c_str() << "\n\n";
 
 	for (int i = 0; i < mesh->GetNumFaces(); i++)
@@ -234,6 +245,33 @@ void OBJFormat::DumpMesh(std::ofstream& fileStream, const Mesh* mesh)
 	this->totalFaces += mesh->GetNumFaces();
 }
 
+// Every face here has exactly three corners, so each one is written with a single statement.
+void OBJFormat::DumpTriangleMesh(std::ofstream& fileStream, const TriangleMesh* mesh)
+{
+	this->DumpVertices(fileStream, mesh->GetVertex(0), mesh->GetNumVertices());
+
+	fileStream << "g " << mesh->name->c_str() << "\n\n";
+
+	for (int i = 0; i < mesh->GetNumTriangles(); i++)
+	{
+		const TriangleMesh::Triangle* triangle = mesh->GetTriangle(i);
+
+		// Needs to be 1-based, not 0-based.
+		int vertexA_i = this->totalVertices + triangle->vertex[0] + 1;
+		int vertexB_i = this->totalVertices + triangle->vertex[1] + 1;
+		int vertexC_i = this->totalVertices + triangle->vertex[2] + 1;
+
+		fileStream << "f " << vertexA_i << "/" << vertexA_i << "/" << vertexA_i << " "
+			<< vertexB_i << "/" << vertexB_i << "/" << vertexB_i << " "
+			<< vertexC_i << "/" << vertexC_i << "/" << vertexC_i << " \n";
+	}
+
+	fileStream << "\n";
+
+	this->totalVertices += mesh->GetNumVertices();
+	this->totalFaces += mesh->GetNumTriangles();
+}
+
 void OBJFormat::DumpPolyline(std::ofstream& fileStream, const Polyline* polyline)
 {
 	for (int i = 0; i < (int)polyline->vertexArray->size(); i++)
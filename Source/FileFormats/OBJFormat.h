@@ -3,6 +3,7 @@
 #include "../FileFormat.h"
 #include "../Vector.h"
 #include "../Mesh.h"
+#include "../TriangleMesh.h"
 #include "../Polyline.h"
 #include <fstream>
 #include <sstream>
@@ -40,9 +41,11 @@ namespace MeshWarrior
 
 		void TokenizeLine(const std::string& line, char delimeter, std::vector<std::string>& tokenArray, bool stripEmptyTokens);
 		void ProcessTokenizedLine(const std::vector<std::string>& tokenArray, std::vector<FileObject*>& fileObjectArray);
-		void LookupAndAssign(const std::vector<Vector>& vectorArray, int i, Vector& result);
+		void LookupAndAssign(const std::vector<Vector>& vectorArray, int i, Mesh::VertexVector& result);
 		void FlushMesh(std::vector<FileObject*>& fileObjectArray);
+		void DumpVertices(std::ofstream& fileStream, const Mesh::Vertex* vertexArray, int vertexCount);
 		void DumpMesh(std::ofstream& fileStream, const Mesh* mesh);
+		void DumpTriangleMesh(std::ofstream& fileStream, const TriangleMesh* mesh);
 		void DumpPolyline(std::ofstream& fileStream, const Polyline* polyline);
 	};
 }
\ No newline at end of file
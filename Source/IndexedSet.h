@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Defines.h"
+#include <vector>
+#include <functional>
+#include <assert.h>
+
+namespace MeshWarrior
+{
+	template<typename Type>
+	class IndexedSet;
+
+	// Anything put into an indexed set must derive from this so that
+	// the set can find it again in constant time.
+	class MESH_WARRIOR_API IndexedSetMember
+	{
+	public:
+		IndexedSetMember()
+		{
+			this->setIndex = -1;
+		}
+
+		virtual ~IndexedSetMember()
+		{
+		}
+
+		int GetSetIndex() const { return this->setIndex; }
+
+	private:
+
+		template<typename Type>
+		friend class IndexedSet;
+
+		int setIndex;
+	};
+
+	// This is a set of pointers that, unlike std::set, does not order its members by
+	// address.  Members are kept in the order they were added, so iteration is the same
+	// from run to run no matter where the members were allocated.  Each member is
+	// identified by a slot index that stays put until the set is compacted.  Removal
+	// just leaves a tombstone (a null slot) behind, so both adding and removing are
+	// constant time, and compaction squeezes the tombstones out when convenient.
+	template<typename Type>
+	class MESH_WARRIOR_API IndexedSet
+	{
+	public:
+		IndexedSet()
+		{
+			this->slotArray = new std::vector<Type*>();
+			this->memberCount = 0;
+		}
+
+		virtual ~IndexedSet()
+		{
+			delete this->slotArray;
+		}
+
+		int Add(Type* member)
+		{
+			MW_ASSERT(member->setIndex == -1);
+			member->setIndex = (int)this->slotArray->size();
+			this->slotArray->push_back(member);
+			this->memberCount++;
+			return member->setIndex;
+		}
+
+		bool Remove(Type* member)
+		{
+			if (!this->Contains(member))
+				return false;
+
+			(*this->slotArray)[member->setIndex] = nullptr;
+			member->setIndex = -1;
+			this->memberCount--;
+			return true;
+		}
+
+		bool Contains(const Type* member) const
+		{
+			int i = member->setIndex;
+			return 0 <= i && i < (signed)this->slotArray->size() && (*this->slotArray)[i] == member;
+		}
+
+		// Note that this returns null for tombstones.
+		Type* GetMember(int i) const
+		{
+			if (i < 0 || i >= (signed)this->slotArray->size())
+				return nullptr;
+
+			return (*this->slotArray)[i];
+		}
+
+		int GetNumSlots() const { return (int)this->slotArray->size(); }
+		int GetNumMembers() const { return this->memberCount; }
+
+		void Clear()
+		{
+			for (Type* member : *this->slotArray)
+				if (member)
+					member->setIndex = -1;
+
+			this->slotArray->clear();
+			this->memberCount = 0;
+		}
+
+		// Remove all the tombstones.  Members keep their relative order, but their slot indices change.
+		void Compact()
+		{
+			int j = 0;
+			for (int i = 0; i < (signed)this->slotArray->size(); i++)
+			{
+				Type* member = (*this->slotArray)[i];
+				if (member)
+				{
+					member->setIndex = j;
+					(*this->slotArray)[j++] = member;
+				}
+			}
+
+			this->slotArray->resize(j);
+		}
+
+		bool ForAll(std::function<bool(Type*)> iterationFunc) const
+		{
+			return this->ForAllInRange(0, (int)this->slotArray->size(), iterationFunc);
+		}
+
+		// Different threads can walk disjoint slot ranges at the same time,
+		// provided that nobody adds or removes members in the meantime.
+		bool ForAllInRange(int beginSlot, int endSlot, std::function<bool(Type*)> iterationFunc) const
+		{
+			beginSlot = MW_MAX(beginSlot, 0);
+			endSlot = MW_MIN(endSlot, (int)this->slotArray->size());
+
+			for (int i = beginSlot; i < endSlot; i++)
+			{
+				Type* member = (*this->slotArray)[i];
+				if (member && iterationFunc(member))
+					return true;
+			}
+
+			return false;
+		}
+
+	private:
+
+		std::vector<Type*>* slotArray;
+		int memberCount;
+	};
+}
\ No newline at end of file
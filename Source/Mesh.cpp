@@ -1,7 +1,21 @@
 #include "Mesh.h"
 #include "Polygon.h"
+#include "VectorKernels.h"
+#include "Transform.h"
+#include "TaskScheduler.h"
+#include "ConvexHullGenerator.h"
+#include "PolygonTriangulator.h"
 #include <sstream>
+#include <float.h>
+#include <limits.h>
 #include <set>
+#include <algorithm>
+
+// Vertices are transformed in parallel in runs of this many.
+#define MW_MESH_TRANSFORM_GRAIN_SIZE		4096
+
+// Faces are triangulated in parallel in runs of this many.
+#define MW_MESH_TRIANGULATE_GRAIN_SIZE		1024
 
 using namespace MeshWarrior;
 
@@ -108,23 +122,29 @@ bool Mesh::AddFace(const Face& face)
 	return true;
 }
 
-void Mesh::AddFace(const ConvexPolygon& convexPolygon, double eps /*= MW_EPS*/)
+void Mesh::AddFace(const ConvexPolygon& convexPolygon, double eps /*= MW_EPS*/, bool matchAttributes /*= false*/)
 {
 	Face face;
 	for (const Vertex& vertex : convexPolygon.vertexArray)
-		face.vertexArray.push_back(this->FindOrCreateVertex(vertex, true, eps));
+		face.vertexArray.push_back(this->FindOrCreateVertex(vertex, true, eps, matchAttributes));
 
 	this->faceArray->push_back(face);
 }
 
-int Mesh::FindOrCreateVertex(const Vertex& vertex, bool canCreate /*= true*/, double eps /*= MW_EPS*/)
+// When matching attributes, vertices in the same place are still kept apart if they differ
+// in normal, color or texture coordinates, as they would along a seam.
+int Mesh::FindOrCreateVertex(const Vertex& vertex, bool canCreate /*= true*/, double eps /*= MW_EPS*/, bool matchAttributes /*= false*/)
 {
-	if (this->index && eps == 0.0)
+	if (this->index && eps == 0.0 && !matchAttributes)
 		return index->FindOrCreateVertex(vertex, this, canCreate);
 
 	for (int i = 0; i < (int)this->vertexArray->size(); i++)
-		if (((*this->vertexArray)[i].point - vertex.point).Length() <= eps)
-			return i;
+	{
+		const Vertex& existingVertex = (*this->vertexArray)[i];
+		if ((existingVertex.point - vertex.point).Length() <= eps)
+			if (!matchAttributes || existingVertex.HasSameAttributes(vertex, eps))
+				return i;
+	}
 
 	if (!canCreate)
 		return -1;
@@ -159,55 +179,65 @@ void Mesh::FromPolygonArray(const std::vector<ConvexPolygon>& polygonArray)
 
 AxisAlignedBox Mesh::CalcBoundingBox() const
 {
-	AxisAlignedBox boundingBox;
-	
-	for (int i = 0; i < (int)this->vertexArray->size(); i++)
-		boundingBox.MinimallyExpandToContainPoint((*this->vertexArray)[i].point);
+	if (this->vertexArray->size() == 0)
+		return AxisAlignedBox();
 
-	return boundingBox;
+	return VectorKernels::CalcBoundingBox(&(*this->vertexArray)[0].point.x, (int)this->vertexArray->size(), MW_VERTEX_STRIDE);
 }
 
 // If this mesh already is a triangle mesh, then this just clones the mesh.
+// The vertices carry over as they are, and each face is cut up in terms of its own vertex indices, so
+// no vertex ever has to be looked up.  Since a face of N vertices always makes N - 2 triangles, where
+// each face's triangles go is known before any are made, and so the faces are cut up in parallel.
 Mesh* Mesh::GenerateTriangleMesh() const
 {
 	Mesh* triangleMesh = new Mesh();
+	*triangleMesh->vertexArray = *this->vertexArray;
 
-	std::vector<MeshWarrior::ConvexPolygon> basicTriangleArray;
+	int faceCount = (int)this->faceArray->size();
+	std::vector<int> offsetArray(faceCount + 1);
+	offsetArray[0] = 0;
+	for (int i = 0; i < faceCount; i++)
+		offsetArray[i + 1] = offsetArray[i] + MW_MAX(int((*this->faceArray)[i].vertexArray.size()) - 2, 0);
 
-	std::vector<ConvexPolygon> polygonArray;
-	this->ToPolygonArray(polygonArray);
-
-	for (ConvexPolygon& polygon : polygonArray)
-	{
-		MeshWarrior::ConvexPolygon basicPolygon;
-		polygon.ToBasicPolygon(basicPolygon);
-
-		std::vector<MeshWarrior::ConvexPolygon> basicPolygonArray;
-		basicPolygon.Tessellate(basicPolygonArray);
-
-		for (MeshWarrior::ConvexPolygon& basicTriangle : basicPolygonArray)
-			basicTriangleArray.push_back(basicTriangle);
-	}
+	triangleMesh->faceArray->resize(offsetArray[faceCount]);
 
-	this->RebuildIndexIfNeeded();
+	TaskScheduler::GetDefault()->ParallelFor(0, faceCount, [this, triangleMesh, &offsetArray](int begin, int end) {
+		PolygonTriangulator triangulator;
+		std::vector<Vector> pointArray;
+		std::vector<int> triangleArray;
 
-	for (const Vertex& vertex : *this->vertexArray)
-		triangleMesh->AddVertex(vertex);
-
-	triangleMesh->RebuildIndexIfNeeded();
-
-	for (MeshWarrior::ConvexPolygon& basicTriangle : basicTriangleArray)
-	{
-		ConvexPolygon triangle;
-		for (int i = 0; i < 3; i++)
+		for (int i = begin; i < end; i++)
 		{
-			int j = this->FindVertex((*basicTriangle.vertexArray)[i], 0.0);
-			const Vertex* vertex = this->GetVertex(j);
-			triangle.vertexArray.push_back(*vertex);
+			const std::vector<int>& vertexArray = (*this->faceArray)[i].vertexArray;
+			Face* triangleFaceArray = triangleMesh->faceArray->data() + offsetArray[i];
+
+			if (vertexArray.size() == 3)
+			{
+				triangleFaceArray->vertexArray = vertexArray;
+				continue;
+			}
+
+			if (vertexArray.size() < 3)
+				continue;
+
+			// Faces read from files aren't always convex, so this uses the general triangulator,
+			// which checks for that first, and just strips the ones that are.
+			pointArray.resize(vertexArray.size());
+			for (int j = 0; j < (int)vertexArray.size(); j++)
+				pointArray[j] = (*this->vertexArray)[vertexArray[j]].point;
+
+			triangulator.Triangulate(pointArray, triangleArray);
+
+			for (int j = 0; j < (int)triangleArray.size(); j += 3)
+			{
+				std::vector<int>& triangle = triangleFaceArray[j / 3].vertexArray;
+				triangle.resize(3);
+				for (int k = 0; k < 3; k++)
+					triangle[k] = vertexArray[triangleArray[j + k]];
+			}
 		}
-
-		triangleMesh->AddFace(triangle, 0.0);
-	}
+	}, MW_MESH_TRIANGULATE_GRAIN_SIZE);
 
 	return triangleMesh;
 }
@@ -262,6 +292,67 @@ bool Mesh::ConvexPolygon::HasVertex(const Vector& point, double eps /*= MW_EPS*/
 	return false;
 }
 
+Mesh::Vertex Mesh::ConvexPolygon::InterpolateVertex(const Vector& point) const
+{
+	Vertex result;
+	result.point = point;
+
+	if (this->vertexArray.size() < 3)
+		return result;
+
+	// Of the triangles fanning out from the first vertex, use the one the point is most inside of.
+	// Points near the shared edges of the fan get the same answer from either side of it.
+	const Vertex& vertexA = this->vertexArray[0];
+	const Vertex* vertexB = nullptr;
+	const Vertex* vertexC = nullptr;
+	double bestU = 0.0, bestV = 0.0, bestW = 0.0;
+	double bestMinimum = -DBL_MAX;
+
+	for (int i = 1; i < (int)this->vertexArray.size() - 1; i++)
+	{
+		Vector edgeB = this->vertexArray[i].point - vertexA.point;
+		Vector edgeC = this->vertexArray[i + 1].point - vertexA.point;
+		Vector delta = point - vertexA.point;
+
+		double dotBB = Vector::Dot(edgeB, edgeB);
+		double dotBC = Vector::Dot(edgeB, edgeC);
+		double dotCC = Vector::Dot(edgeC, edgeC);
+		double dotDB = Vector::Dot(delta, edgeB);
+		double dotDC = Vector::Dot(delta, edgeC);
+
+		double denominator = dotBB * dotCC - dotBC * dotBC;
+		if (denominator == 0.0)
+			continue;
+
+		double v = (dotCC * dotDB - dotBC * dotDC) / denominator;
+		double w = (dotBB * dotDC - dotBC * dotDB) / denominator;
+		double u = 1.0 - v - w;
+
+		double minimum = MW_MIN(u, MW_MIN(v, w));
+		if (minimum > bestMinimum)
+		{
+			bestMinimum = minimum;
+			bestU = u;
+			bestV = v;
+			bestW = w;
+			vertexB = &this->vertexArray[i];
+			vertexC = &this->vertexArray[i + 1];
+		}
+	}
+
+	if (!vertexB)
+		return result;
+
+	Vector normal = vertexA.normal * bestU + vertexB->normal * bestV + vertexC->normal * bestW;
+	result.color = vertexA.color * bestU + vertexB->color * bestV + vertexC->color * bestW;
+	result.texCoords = vertexA.texCoords * bestU + vertexB->texCoords * bestV + vertexC->texCoords * bestW;
+
+	bool divByZero = false;
+	result.normal = normal.Normalize(&divByZero);
+
+	return result;
+}
+
 Mesh::ConvexPolygon& Mesh::ConvexPolygon::ReverseWinding()
 {
 	for (int i = 0; i < (int)this->vertexArray.size() / 2; i++)
@@ -272,13 +363,148 @@ Mesh::ConvexPolygon& Mesh::ConvexPolygon::ReverseWinding()
 		this->vertexArray[j] = vertex;
 	}
 
+	for (Vertex& vertex : this->vertexArray)
+		vertex.normal = vertex.normal * -1.0;
+
 	return *this;
 }
 
+/*static*/ Mesh::Vertex Mesh::Vertex::Lerp(const Vertex& vertexA, const Vertex& vertexB, double lambda)
+{
+	Vertex vertex;
+	vertex.point = vertexA.point + (vertexB.point - vertexA.point) * lambda;
+	Vector normal = vertexA.normal + (vertexB.normal - vertexA.normal) * lambda;
+	vertex.color = vertexA.color + (vertexB.color - vertexA.color) * lambda;
+	vertex.texCoords = vertexA.texCoords + (vertexB.texCoords - vertexA.texCoords) * lambda;
+
+	bool divByZero = false;
+	vertex.normal = normal.Normalize(&divByZero);
+
+	return vertex;
+}
+
+bool Mesh::Vertex::HasSameAttributes(const Vertex& vertex, double eps /*= MW_EPS*/) const
+{
+	return
+		(this->normal - vertex.normal).Length() <= eps &&
+		(this->color - vertex.color).Length() <= eps &&
+		(this->texCoords - vertex.texCoords).Length() <= eps;
+}
+
+// Normals have to go through the inverse-transpose of the matrix to stay perpendicular to the surface under non-uniform scaling.
+static bool CalcNormalMatrix(const Transform& transform, Matrix3x3& normalMatrix)
+{
+	Matrix3x3 inverseMatrix;
+	if (!transform.matrix.GetInverse(inverseMatrix))
+		return false;
+
+	normalMatrix.SetTranspose(inverseMatrix);
+	return true;
+}
+
+static void TransformVertices(Mesh::Vertex* vertexArray, int count, const Transform& transform, const Matrix3x3& normalMatrix)
+{
+	VectorKernels::TransformPositions(transform, &vertexArray->point.x, &vertexArray->point.x, count, MW_VERTEX_STRIDE, MW_VERTEX_STRIDE);
+	VectorKernels::TransformVectors(normalMatrix, &vertexArray->normal.x, &vertexArray->normal.x, count, MW_VERTEX_STRIDE, MW_VERTEX_STRIDE);
+	VectorKernels::NormalizeVectors(&vertexArray->normal.x, count, MW_VERTEX_STRIDE);
+}
+
+// This runs things in parallel the same way mesh operations do, given a scheduler and concurrency of the same kind.
+static void ParallelFor(TaskScheduler* scheduler, int concurrency, int begin, int end, std::function<void(int, int)> rangeFunc, int grainSize)
+{
+	if (concurrency == 1)
+		rangeFunc(begin, end);
+	else
+		(scheduler ? scheduler : TaskScheduler::GetDefault())->ParallelFor(begin, end, rangeFunc, grainSize, concurrency);
+}
+
+// A transform that turns things inside-out (a reflection, say) would leave the faces wound the wrong way, so they get turned around to match.
+bool Mesh::ApplyTransform(const Transform& transform, TaskScheduler* scheduler /*= nullptr*/, int concurrency /*= 0*/)
+{
+	Matrix3x3 normalMatrix;
+	if (!CalcNormalMatrix(transform, normalMatrix))
+		return false;
+
+	ParallelFor(scheduler, concurrency, 0, (int)this->vertexArray->size(), [this, &transform, &normalMatrix](int begin, int end) {
+		TransformVertices(&(*this->vertexArray)[begin], end - begin, transform, normalMatrix);
+	}, MW_MESH_TRANSFORM_GRAIN_SIZE);
+
+	if (transform.matrix.Determinant() < 0.0)
+		for (Face& face : *this->faceArray)
+			std::reverse(face.vertexArray.begin(), face.vertexArray.end());
+
+	// The index is keyed by position, so it's no good anymore.
+	delete this->index;
+	this->index = nullptr;
+
+	return true;
+}
+
+// The work is divided up by vertex and by face across all the instances, rather than by instance,
+// so that a few big instances are spread over the threads as well as many small ones are.
+Mesh* Mesh::GenerateInstances(const std::vector<Transform>& transformArray, TaskScheduler* scheduler /*= nullptr*/, int concurrency /*= 0*/) const
+{
+	int instanceCount = (int)transformArray.size();
+	int vertexCount = (int)this->vertexArray->size();
+	int faceCount = (int)this->faceArray->size();
+
+	// All the vertices and faces have to be numbered with ints, and so do the ranges we divide the work up by.
+	if (size_t(instanceCount) * vertexCount > size_t(INT_MAX) || size_t(instanceCount) * faceCount > size_t(INT_MAX))
+		return nullptr;
+
+	std::vector<Matrix3x3> normalMatrixArray(instanceCount);
+	std::vector<bool> reverseArray(instanceCount);
+	for (int i = 0; i < instanceCount; i++)
+	{
+		if (!CalcNormalMatrix(transformArray[i], normalMatrixArray[i]))
+			return nullptr;
+
+		reverseArray[i] = (transformArray[i].matrix.Determinant() < 0.0);
+	}
+
+	Mesh* mesh = new Mesh();
+	mesh->vertexArray->resize(size_t(instanceCount) * vertexCount);
+	mesh->faceArray->resize(size_t(instanceCount) * faceCount);
+
+	ParallelFor(scheduler, concurrency, 0, instanceCount * vertexCount, [&](int begin, int end) {
+		while (begin < end)
+		{
+			// Take the part of the range belonging to one instance at a time.
+			int instance = begin / vertexCount;
+			int instanceEnd = MW_MIN(end, (instance + 1) * vertexCount);
+			int first = begin - instance * vertexCount;
+
+			Vertex* vertexArray = &(*mesh->vertexArray)[begin];
+			std::copy(this->vertexArray->begin() + first, this->vertexArray->begin() + first + (instanceEnd - begin), vertexArray);
+			TransformVertices(vertexArray, instanceEnd - begin, transformArray[instance], normalMatrixArray[instance]);
+
+			begin = instanceEnd;
+		}
+	}, MW_MESH_TRANSFORM_GRAIN_SIZE);
+
+	ParallelFor(scheduler, concurrency, 0, instanceCount * faceCount, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			int instance = i / faceCount;
+			int offset = instance * vertexCount;
+
+			std::vector<int>& vertexArray = (*mesh->faceArray)[i].vertexArray;
+			vertexArray = (*this->faceArray)[i - instance * faceCount].vertexArray;
+			for (int& j : vertexArray)
+				j += offset;
+
+			if (reverseArray[instance])
+				std::reverse(vertexArray.begin(), vertexArray.end());
+		}
+	}, MW_MESH_TRANSFORM_GRAIN_SIZE);
+
+	return mesh;
+}
+
 /*static*/ Mesh* Mesh::GenerateConvexHull(const std::vector<Vector>& pointArray)
 {
-	// TODO: Write this.
-	return nullptr;
+	ConvexHullGenerator generator;
+	return generator.Generate(pointArray);
 }
 
 void Mesh::RebuildIndexIfNeeded() const
@@ -3,6 +3,7 @@
 #include "FileObject.h"
 #include "Vector.h"
 #include "AxisAlignedBox.h"
+#include "Vector3.h"
 #include <vector>
 #include <map>
 #include <string>
@@ -10,22 +11,38 @@
 namespace MeshWarrior
 {
 	class ConvexPolygon;
+	class Transform;
+	class TaskScheduler;
 
-	// TODO: There should be a way to transform meshes and a way to fixup/calculate normals and UV coordinates.
+	// TODO: There should be a way to fixup/calculate normals and UV coordinates.
 	class MESH_WARRIOR_API Mesh : public FileObject
 	{
 		friend class Index;
+		friend class MeshGenerator;
+		friend class TriangleMesh;
 
 	public:
 		Mesh();
 		virtual ~Mesh();
 
+		// Vertex attributes are read and written as Vectors either way, but are stored as floats if so configured.
+#if MW_SINGLE_PRECISION_VERTICES
+		typedef Vector3f VertexVector;
+#else
+		typedef Vector VertexVector;
+#endif
+
 		struct Vertex
 		{
-			Vector point;
-			Vector normal;
-			Vector color;
-			Vector texCoords;
+			VertexVector point;
+			VertexVector normal;
+			VertexVector color;
+			VertexVector texCoords;
+
+			// Blend all the attributes of the given vertices, renormalizing the normal.
+			static Vertex Lerp(const Vertex& vertexA, const Vertex& vertexB, double lambda);
+
+			bool HasSameAttributes(const Vertex& vertex, double eps = MW_EPS) const;
 		};
 
 		struct ConvexPolygon;
@@ -49,6 +66,11 @@ namespace MeshWarrior
 
 			bool HasVertex(const Vector& point, double eps = MW_EPS) const;
 
+			// Make a vertex at the given point, which should be on this polygon, with attributes
+			// interpolated barycentrically from those of the corners of this polygon.
+			Vertex InterpolateVertex(const Vector& point) const;
+
+			// The vertex normals are turned around too, since what was the front is now the back.
 			ConvexPolygon& ReverseWinding();
 
 			std::vector<Vertex> vertexArray;
@@ -69,19 +91,30 @@ namespace MeshWarrior
 		void Clear();
 		int AddVertex(const Vertex& vertex);
 		bool AddFace(const Face& face);
-		void AddFace(const ConvexPolygon& convexPolygon, double eps = MW_EPS);
-		int FindOrCreateVertex(const Vertex& vertex, bool canCreate = true, double eps = MW_EPS);
+		void AddFace(const ConvexPolygon& convexPolygon, double eps = MW_EPS, bool matchAttributes = false);
+		int FindOrCreateVertex(const Vertex& vertex, bool canCreate = true, double eps = MW_EPS, bool matchAttributes = false);
 		int FindVertex(const Vector& vertexPoint, double eps = MW_EPS) const;
 
 		void ToPolygonArray(std::vector<ConvexPolygon>& polygonArray, bool appendOnly = false) const;
 		void FromPolygonArray(const std::vector<ConvexPolygon>& polygonArray);
 
 		AxisAlignedBox CalcBoundingBox() const;
+		// This gives null if the points are all coplanar.  See ConvexHullGenerator for more control.
 		static Mesh* GenerateConvexHull(const std::vector<Vector>& pointArray);
 		Mesh* GenerateTriangleMesh() const;
 		bool IsTriangleMesh() const;
 		void RebuildIndexIfNeeded() const;
 
+		// Points go through the given transform, and normals through the inverse-transpose of its matrix.
+		// This fails, leaving the mesh alone, if the transform can't be inverted.  The scheduler and
+		// concurrency work the same as they do for mesh operations.
+		bool ApplyTransform(const Transform& transform, TaskScheduler* scheduler = nullptr, int concurrency = 0);
+
+		// Make one mesh holding a transformed copy of this one for each of the given transforms, in order.
+		// This gives back null if any transform can't be inverted, or if there would be more vertices or
+		// faces all together than an int can count.
+		Mesh* GenerateInstances(const std::vector<Transform>& transformArray, TaskScheduler* scheduler = nullptr, int concurrency = 0) const;
+
 	private:
 
 		std::vector<Vertex>* vertexArray;
@@ -109,4 +142,7 @@ namespace MeshWarrior
 
 		mutable Index* index;
 	};
-}
\ No newline at end of file
+}
+
+// This is how many coordinates apart the points of consecutive mesh vertices are, for pointing the vector kernels at them.
+#define MW_VERTEX_STRIDE		int(sizeof(MeshWarrior::Mesh::Vertex) / sizeof(MeshWarrior::Mesh::VertexVector::x))
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include "MeshGenerator.h"
+#include "Mesh.h"
+#include "Shape.h"
+#include "TaskScheduler.h"
+#include <math.h>
+
+using namespace MeshWarrior;
+
+// Find two unit vectors perpendicular to the given unit axis and to each other, such that their cross product is the axis.
+static void MakeBasis(const Vector& unitAxis, Vector& unitVectorU, Vector& unitVectorV)
+{
+	Vector vector(1.0, 0.0, 0.0);
+	if (::fabs(unitAxis.y) < ::fabs(unitAxis.x) && ::fabs(unitAxis.y) <= ::fabs(unitAxis.z))
+		vector = Vector(0.0, 1.0, 0.0);
+	else if (::fabs(unitAxis.z) < ::fabs(unitAxis.x) && ::fabs(unitAxis.z) < ::fabs(unitAxis.y))
+		vector = Vector(0.0, 0.0, 1.0);
+
+	unitVectorU.Reject(vector, unitAxis).Normalize();
+	unitVectorV.Cross(unitAxis, unitVectorU);
+}
+
+// This is the SplitMix64 generator.  It is seeded per polygon, so that the soup doesn't depend on the order in which polygons get made.
+static uint64_t NextRandom(uint64_t& state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Give the cosine and sine of each of the given number of equal steps around a circle, so
+// that a grid of vertices needs only as many calls to the trig functions as it has rows.
+static void MakeCircleTable(int stepCount, std::vector<double>& cosineArray, std::vector<double>& sineArray)
+{
+	cosineArray.resize(stepCount);
+	sineArray.resize(stepCount);
+
+	for (int i = 0; i < stepCount; i++)
+	{
+		double angle = MW_TWO_PI * double(i) / double(stepCount);
+		cosineArray[i] = ::cos(angle);
+		sineArray[i] = ::sin(angle);
+	}
+}
+
+static double NextRandomDouble(uint64_t& state, double min, double max)
+{
+	return min + (max - min) * double(NextRandom(state) >> 11) / double(1ULL << 53);
+}
+
+MeshGenerator::MeshGenerator()
+{
+	this->triangulate = true;
+	this->concurrency = 0;
+	this->scheduler = nullptr;
+}
+
+/*virtual*/ MeshGenerator::~MeshGenerator()
+{
+}
+
+Mesh* MeshGenerator::GenerateSphere(const Sphere& sphere, int sliceCount, int stackCount)
+{
+	sliceCount = MW_MAX(sliceCount, 3);
+	stackCount = MW_MAX(stackCount, 2);
+
+	// The poles come first and last, with a ring of vertices for every stack boundary in between.
+	int ringCount = stackCount - 1;
+	int southPole = 1 + ringCount * sliceCount;
+	auto ringVertex = [sliceCount](int ring, int slice) -> int {
+		return 1 + ring * sliceCount + (slice % sliceCount);
+	};
+
+	std::vector<double> cosineArray, sineArray;
+	MakeCircleTable(sliceCount, cosineArray, sineArray);
+
+	Mesh* mesh = new Mesh();
+	mesh->vertexArray->resize(2 + ringCount * sliceCount);
+
+	this->ParallelFor(0, ringCount + 2, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			// Row zero is the north pole, and the last row is the south pole.
+			int ringSliceCount = (i == 0 || i == ringCount + 1) ? 1 : sliceCount;
+			double latitudeAngle = MW_PI * double(i) / double(stackCount);
+			double latitudeSine = ::sin(latitudeAngle);
+			double latitudeCosine = ::cos(latitudeAngle);
+
+			for (int j = 0; j < ringSliceCount; j++)
+			{
+				int k = (i == 0) ? 0 : ((i == ringCount + 1) ? southPole : ringVertex(i - 1, j));
+				Mesh::Vertex& vertex = (*mesh->vertexArray)[k];
+
+				Vector normal(latitudeSine * cosineArray[j], latitudeSine * sineArray[j], latitudeCosine);
+				vertex.normal = normal;
+				vertex.point = sphere.center + normal * sphere.radius;
+				vertex.texCoords = Vector(double(j) / double(sliceCount), 1.0 - double(i) / double(stackCount), 0.0);
+			}
+		}
+	});
+
+	int quadFaceCount = this->GetQuadFaceCount();
+	int bandFaceCount = sliceCount * quadFaceCount;
+	mesh->faceArray->resize(2 * sliceCount + (ringCount - 1) * bandFaceCount);
+
+	this->ParallelFor(0, stackCount, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			for (int j = 0; j < sliceCount; j++)
+			{
+				if (i == 0)
+					this->SetTriangle(mesh, j, 0, ringVertex(0, j), ringVertex(0, j + 1));
+				else if (i == stackCount - 1)
+					this->SetTriangle(mesh, sliceCount + j, ringVertex(ringCount - 1, j), southPole, ringVertex(ringCount - 1, j + 1));
+				else
+					this->SetQuad(mesh, 2 * sliceCount + (i - 1) * bandFaceCount + j * quadFaceCount, ringVertex(i - 1, j), ringVertex(i, j), ringVertex(i, j + 1), ringVertex(i - 1, j + 1));
+			}
+		}
+	});
+
+	return mesh;
+}
+
+// The vertices are the points of a lattice over the box that lie on its surface.  These are numbered a layer at
+// a time along the Z-axis, the top and bottom layers being whole grids, and the layers in between being rings.
+Mesh* MeshGenerator::GenerateBox(const AxisAlignedBox& box, int subdivisionCount)
+{
+	int n = MW_MAX(subdivisionCount, 1);
+	int gridCount = (n + 1) * (n + 1);
+	int ringCount = 4 * n;
+
+	auto latticeVertex = [n, gridCount, ringCount](int i, int j, int k) -> int {
+		if (k == 0)
+			return i + j * (n + 1);
+		if (k == n)
+			return gridCount + (n - 1) * ringCount + i + j * (n + 1);
+
+		int base = gridCount + (k - 1) * ringCount;
+		if (j == 0 && i < n)
+			return base + i;
+		if (i == n && j < n)
+			return base + n + j;
+		if (j == n && i > 0)
+			return base + 2 * n + (n - i);
+		return base + 3 * n + (n - j);
+	};
+
+	Mesh* mesh = new Mesh();
+	mesh->vertexArray->resize(2 * gridCount + (n - 1) * ringCount);
+
+	Vector boxSize = box.max - box.min;
+
+	this->ParallelFor(0, n + 1, [&](int begin, int end) {
+		for (int k = begin; k < end; k++)
+		{
+			for (int j = 0; j <= n; j++)
+			{
+				// Rows crossing the inside of the box only touch its surface at their ends.
+				bool wholeRow = (k == 0 || k == n || j == 0 || j == n);
+
+				for (int i = 0; i <= n; i += (wholeRow ? 1 : n))
+				{
+					int lattice[3] = { i, j, k };
+					Vector normal(0.0, 0.0, 0.0);
+					double* normalComponent[3] = { &normal.x, &normal.y, &normal.z };
+
+					for (int axis = 0; axis < 3; axis++)
+						if (lattice[axis] == 0 || lattice[axis] == n)
+							*normalComponent[axis] = (lattice[axis] == 0) ? -1.0 : 1.0;
+
+					// Where sides meet, the normal splits the difference.
+					Mesh::Vertex vertex;
+					vertex.normal = normal.Normalize();
+					vertex.point = Vector(
+						box.min.x + boxSize.x * double(i) / double(n),
+						box.min.y + boxSize.y * double(j) / double(n),
+						box.min.z + boxSize.z * double(k) / double(n));
+
+					(*mesh->vertexArray)[latticeVertex(i, j, k)] = vertex;
+				}
+			}
+		}
+	});
+
+	int quadFaceCount = this->GetQuadFaceCount();
+	int sideFaceCount = n * n * quadFaceCount;
+	mesh->faceArray->resize(6 * sideFaceCount);
+
+	// Each side is a grid over the two axes that follow its own axis in cyclic order.  The grid is wound
+	// CCW about the positive axis, so it gets turned around on the side facing the negative axis.
+	this->ParallelFor(0, 6 * n, [&](int begin, int end) {
+		for (int row = begin; row < end; row++)
+		{
+			int side = row / n;
+			int v = row % n;
+			int axis = side / 2;
+			bool positive = (side % 2) == 1;
+
+			auto sideVertex = [&](int gridU, int gridV) -> int {
+				int lattice[3];
+				lattice[axis] = positive ? n : 0;
+				lattice[(axis + 1) % 3] = gridU;
+				lattice[(axis + 2) % 3] = gridV;
+				return latticeVertex(lattice[0], lattice[1], lattice[2]);
+			};
+
+			for (int u = 0; u < n; u++)
+			{
+				int i = side * sideFaceCount + (v * n + u) * quadFaceCount;
+				if (positive)
+					this->SetQuad(mesh, i, sideVertex(u, v), sideVertex(u + 1, v), sideVertex(u + 1, v + 1), sideVertex(u, v + 1));
+				else
+					this->SetQuad(mesh, i, sideVertex(u, v + 1), sideVertex(u + 1, v + 1), sideVertex(u + 1, v), sideVertex(u, v));
+			}
+		}
+	});
+
+	return mesh;
+}
+
+Mesh* MeshGenerator::GenerateCylinder(const Cylinder& cylinder, double height, int sliceCount, int stackCount)
+{
+	sliceCount = MW_MAX(sliceCount, 3);
+	stackCount = MW_MAX(stackCount, 1);
+
+	Vector unitAxis = cylinder.unitNormal;
+	unitAxis.Normalize();
+
+	Vector unitVectorU, unitVectorV;
+	MakeBasis(unitAxis, unitVectorU, unitVectorV);
+
+	// There's a ring of vertices for every stack boundary, then the centers of the bottom and top caps.
+	int bottomCenter = (stackCount + 1) * sliceCount;
+	int topCenter = bottomCenter + 1;
+	auto ringVertex = [sliceCount](int ring, int slice) -> int {
+		return ring * sliceCount + (slice % sliceCount);
+	};
+
+	std::vector<double> cosineArray, sineArray;
+	MakeCircleTable(sliceCount, cosineArray, sineArray);
+
+	Mesh* mesh = new Mesh();
+	mesh->vertexArray->resize(topCenter + 1);
+
+	this->ParallelFor(0, stackCount + 1, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			Vector ringCenter = cylinder.center + unitAxis * (height * (double(i) / double(stackCount) - 0.5));
+
+			for (int j = 0; j < sliceCount; j++)
+			{
+				Mesh::Vertex& vertex = (*mesh->vertexArray)[ringVertex(i, j)];
+
+				Vector normal = unitVectorU * cosineArray[j] + unitVectorV * sineArray[j];
+				vertex.normal = normal;
+				vertex.point = ringCenter + normal * cylinder.radius;
+				vertex.texCoords = Vector(double(j) / double(sliceCount), double(i) / double(stackCount), 0.0);
+			}
+		}
+	});
+
+	Mesh::Vertex capVertex;
+	capVertex.normal = unitAxis * -1.0;
+	capVertex.point = cylinder.center - unitAxis * (height * 0.5);
+	(*mesh->vertexArray)[bottomCenter] = capVertex;
+
+	capVertex.normal = unitAxis;
+	capVertex.point = cylinder.center + unitAxis * (height * 0.5);
+	(*mesh->vertexArray)[topCenter] = capVertex;
+
+	// The caps are fans of triangles about their centers, and come first.
+	int quadFaceCount = this->GetQuadFaceCount();
+	int bandFaceCount = sliceCount * quadFaceCount;
+	mesh->faceArray->resize(2 * sliceCount + stackCount * bandFaceCount);
+
+	this->ParallelFor(0, stackCount + 1, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			for (int j = 0; j < sliceCount; j++)
+			{
+				if (i == stackCount)
+				{
+					this->SetTriangle(mesh, j, bottomCenter, ringVertex(0, j + 1), ringVertex(0, j));
+					this->SetTriangle(mesh, sliceCount + j, topCenter, ringVertex(stackCount, j), ringVertex(stackCount, j + 1));
+				}
+				else
+					this->SetQuad(mesh, 2 * sliceCount + i * bandFaceCount + j * quadFaceCount, ringVertex(i, j), ringVertex(i, j + 1), ringVertex(i + 1, j + 1), ringVertex(i + 1, j));
+			}
+		}
+	});
+
+	return mesh;
+}
+
+Mesh* MeshGenerator::GenerateTorus(const Vector& center, const Vector& axis, double majorRadius, double minorRadius, int majorSegmentCount, int minorSegmentCount)
+{
+	majorSegmentCount = MW_MAX(majorSegmentCount, 3);
+	minorSegmentCount = MW_MAX(minorSegmentCount, 3);
+
+	Vector unitAxis = axis;
+	unitAxis.Normalize();
+
+	Vector unitVectorU, unitVectorV;
+	MakeBasis(unitAxis, unitVectorU, unitVectorV);
+
+	auto gridVertex = [majorSegmentCount, minorSegmentCount](int i, int j) -> int {
+		return (i % majorSegmentCount) * minorSegmentCount + (j % minorSegmentCount);
+	};
+
+	std::vector<double> cosineArray, sineArray;
+	MakeCircleTable(minorSegmentCount, cosineArray, sineArray);
+
+	Mesh* mesh = new Mesh();
+	mesh->vertexArray->resize(majorSegmentCount * minorSegmentCount);
+
+	this->ParallelFor(0, majorSegmentCount, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			double majorAngle = MW_TWO_PI * double(i) / double(majorSegmentCount);
+			Vector radialVector = unitVectorU * ::cos(majorAngle) + unitVectorV * ::sin(majorAngle);
+			Vector tubeCenter = center + radialVector * majorRadius;
+
+			for (int j = 0; j < minorSegmentCount; j++)
+			{
+				Mesh::Vertex& vertex = (*mesh->vertexArray)[gridVertex(i, j)];
+
+				Vector normal = radialVector * cosineArray[j] + unitAxis * sineArray[j];
+				vertex.normal = normal;
+				vertex.point = tubeCenter + normal * minorRadius;
+				vertex.texCoords = Vector(double(i) / double(majorSegmentCount), double(j) / double(minorSegmentCount), 0.0);
+			}
+		}
+	});
+
+	int quadFaceCount = this->GetQuadFaceCount();
+	mesh->faceArray->resize(majorSegmentCount * minorSegmentCount * quadFaceCount);
+
+	this->ParallelFor(0, majorSegmentCount, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			for (int j = 0; j < minorSegmentCount; j++)
+				this->SetQuad(mesh, gridVertex(i, j) * quadFaceCount, gridVertex(i, j), gridVertex(i + 1, j), gridVertex(i + 1, j + 1), gridVertex(i, j + 1));
+	});
+
+	return mesh;
+}
+
+Mesh* MeshGenerator::GeneratePolygonSoup(const AxisAlignedBox& box, int polygonCount, int maxSideCount, double polygonRadius, uint64_t seed)
+{
+	polygonCount = MW_MAX(polygonCount, 0);
+	maxSideCount = MW_MAX(maxSideCount, 3);
+
+	// Each polygon draws its numbers from its own generator, so first find where each one's vertices go.
+	std::vector<int> firstVertexArray(polygonCount + 1);
+	firstVertexArray[0] = 0;
+	for (int i = 0; i < polygonCount; i++)
+	{
+		uint64_t state = seed ^ (uint64_t(i) * 0xD1B54A32D192ED03ULL);
+		int sideCount = 3 + int(NextRandom(state) % uint64_t(maxSideCount - 2));
+		firstVertexArray[i + 1] = firstVertexArray[i] + sideCount;
+	}
+
+	Mesh* mesh = new Mesh();
+	mesh->vertexArray->resize(firstVertexArray[polygonCount]);
+	mesh->faceArray->resize(polygonCount);
+
+	this->ParallelFor(0, polygonCount, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			uint64_t state = seed ^ (uint64_t(i) * 0xD1B54A32D192ED03ULL);
+			NextRandom(state);
+
+			Vector center(
+				NextRandomDouble(state, box.min.x, box.max.x),
+				NextRandomDouble(state, box.min.y, box.max.y),
+				NextRandomDouble(state, box.min.z, box.max.z));
+
+			// Picking a normal in the cube and throwing out those outside the ball makes them evenly spread.
+			Vector unitNormal;
+			double length = 0.0;
+			do
+			{
+				unitNormal = Vector(NextRandomDouble(state, -1.0, 1.0), NextRandomDouble(state, -1.0, 1.0), NextRandomDouble(state, -1.0, 1.0));
+				length = unitNormal.Length();
+			} while (length > 1.0 || length < 1e-3);
+			unitNormal /= length;
+
+			Vector unitVectorU, unitVectorV;
+			MakeBasis(unitNormal, unitVectorU, unitVectorV);
+
+			// Points on a circle in order of angle make a convex polygon.  Jittering each one within
+			// its own sector keeps them in order, and keeps any two from coming too close together.
+			int firstVertex = firstVertexArray[i];
+			int sideCount = firstVertexArray[i + 1] - firstVertex;
+			Mesh::Face& face = (*mesh->faceArray)[i];
+			face.vertexArray.resize(sideCount);
+
+			for (int j = 0; j < sideCount; j++)
+			{
+				double angle = MW_TWO_PI * (double(j) + NextRandomDouble(state, 0.0, 0.8)) / double(sideCount);
+
+				Mesh::Vertex vertex;
+				vertex.normal = unitNormal;
+				vertex.point = center + (unitVectorU * ::cos(angle) + unitVectorV * ::sin(angle)) * polygonRadius;
+
+				(*mesh->vertexArray)[firstVertex + j] = vertex;
+				face.vertexArray[j] = firstVertex + j;
+			}
+		}
+	});
+
+	return mesh;
+}
+
+void MeshGenerator::ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc)
+{
+	if (this->concurrency == 1)
+		rangeFunc(begin, end);
+	else
+		(this->scheduler ? this->scheduler : TaskScheduler::GetDefault())->ParallelFor(begin, end, rangeFunc, 0, this->concurrency);
+}
+
+// The given quad goes in at the given face index, as one face or two.
+void MeshGenerator::SetQuad(Mesh* mesh, int i, int vertexA, int vertexB, int vertexC, int vertexD) const
+{
+	if (this->triangulate)
+	{
+		this->SetTriangle(mesh, i, vertexA, vertexB, vertexC);
+		this->SetTriangle(mesh, i + 1, vertexA, vertexC, vertexD);
+	}
+	else
+	{
+		std::vector<int>& vertexArray = (*mesh->faceArray)[i].vertexArray;
+		vertexArray.resize(4);
+		vertexArray[0] = vertexA;
+		vertexArray[1] = vertexB;
+		vertexArray[2] = vertexC;
+		vertexArray[3] = vertexD;
+	}
+}
+
+void MeshGenerator::SetTriangle(Mesh* mesh, int i, int vertexA, int vertexB, int vertexC) const
+{
+	std::vector<int>& vertexArray = (*mesh->faceArray)[i].vertexArray;
+	vertexArray.resize(3);
+	vertexArray[0] = vertexA;
+	vertexArray[1] = vertexB;
+	vertexArray[2] = vertexC;
+}
+
+int MeshGenerator::GetQuadFaceCount() const
+{
+	return this->triangulate ? 2 : 1;
+}
\ No newline at end of file
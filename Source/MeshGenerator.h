@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Defines.h"
+#include "Vector.h"
+#include "AxisAlignedBox.h"
+#include <functional>
+#include <stdint.h>
+
+namespace MeshWarrior
+{
+	class Mesh;
+	class Sphere;
+	class Cylinder;
+	class TaskScheduler;
+
+	// This makes meshes of simple shapes at whatever resolution is asked for, mostly so that tests and
+	// benchmarks can have inputs of any size.  The number of vertices and faces is known up front, so
+	// the mesh arrays are sized once and then filled in parallel, each vertex and face at a known index,
+	// with no welding needed.  All the shapes are closed and wound CCW when seen from the outside.
+	class MESH_WARRIOR_API MeshGenerator
+	{
+	public:
+		MeshGenerator();
+		virtual ~MeshGenerator();
+
+		// The poles of the sphere are along the Z-axis.  There must be at least 3 slices and 2 stacks.
+		Mesh* GenerateSphere(const Sphere& sphere, int sliceCount, int stackCount);
+
+		// Each side of the box is divided into a grid of this many squares on a side.
+		Mesh* GenerateBox(const AxisAlignedBox& box, int subdivisionCount);
+
+		// The cylinder is centered on its center, and runs half the given height each way along its axis.
+		Mesh* GenerateCylinder(const Cylinder& cylinder, double height, int sliceCount, int stackCount);
+
+		// The torus goes around the given axis, with its tube centered at the major radius.
+		Mesh* GenerateTorus(const Vector& center, const Vector& axis, double majorRadius, double minorRadius, int majorSegmentCount, int minorSegmentCount);
+
+		// This is a pile of unrelated convex polygons in random places, with random orientations, none of
+		// which share any vertices.  They have from 3 to the given number of sides.  It is not closed, of
+		// course, but it comes out the same every time for the same seed, no matter how many threads made it.
+		Mesh* GeneratePolygonSoup(const AxisAlignedBox& box, int polygonCount, int maxSideCount, double polygonRadius, uint64_t seed);
+
+		// If set, which is the default, all quads are split into triangles.
+		bool triangulate;
+
+		// These work the same as they do for mesh operations.
+		int concurrency;
+		TaskScheduler* scheduler;
+
+	private:
+
+		void ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc);
+		void SetQuad(Mesh* mesh, int i, int vertexA, int vertexB, int vertexC, int vertexD) const;
+		void SetTriangle(Mesh* mesh, int i, int vertexA, int vertexB, int vertexC) const;
+		int GetQuadFaceCount() const;
+	};
+}
\ No newline at end of file
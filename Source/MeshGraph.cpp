@@ -1,7 +1,5 @@
 #include "MeshGraph.h"
-#include "Polygon.h"
-#include "Shape.h"
-#include "Compressor.h"
+#include <map>
 #include <assert.h>
 
 using namespace MeshWarrior;
@@ -20,110 +18,53 @@ MeshGraph::MeshGraph()
 	delete this->graphElementArray;
 }
 
+// Two faces are taken to be adjacent when they share an edge, meaning a pair of vertex indices,
+// so the given mesh should be welded.  (There was a time when we worked this out geometrically,
+// but that was slow, and it was only ever as good as the tolerances used.)
 void MeshGraph::Generate(const Mesh* mesh)
 {
 	this->Clear();
 
 	this->targetMesh = mesh;
 
-	BoundingBoxTree tree;
-	tree.SetRootBox(mesh->CalcBoundingBox());
+	std::map<std::pair<int, int>, Node*> edgeMap;
 
 	for (int i = 0; i < mesh->GetNumFaces(); i++)
 	{
 		Node* node = this->NodeFactory();
 		this->graphElementArray->push_back(node);
 		node->polygon = i;
-		tree.AddGuest(new Face(node));
-	}
-
-	std::list<BoundingBoxTree::Guest*> guestList;
-	tree.GatherAllGuests(guestList);
 
-	for (BoundingBoxTree::Guest* guest : guestList)
-	{
-		Face* face = (Face*)guest;
-		AxisAlignedBox boundingBox = face->CalcBoundingBox();
-		
-		// Fatten the box so that we're sure to overlap with the bounding
-		// boxes of all faces adjacent to this face.
-		boundingBox.AddMargin(0.5);
-		boundingBox.ScaleAboutCenter(2.0);
-
-		std::list<BoundingBoxTree::Guest*> foundGuestList;
-		tree.FindGuests(boundingBox, foundGuestList);
-
-		for (BoundingBoxTree::Guest* foundGuest : foundGuestList)
+		const Mesh::Face* face = mesh->GetFace(i);
+		for (int j = 0; j < (int)face->vertexArray.size(); j++)
 		{
-			Face* foundFace = (Face*)foundGuest;
-			if (face == foundFace || face->node->LinkedWith(foundFace->node))
-				continue;
+			int vertexA = face->vertexArray[j];
+			int vertexB = face->vertexArray[(j + 1) % face->vertexArray.size()];
+			std::pair<int, int> key(MW_MIN(vertexA, vertexB), MW_MAX(vertexA, vertexB));
 
-			Edge* edge = this->FindCommonEdge(face->node, foundFace->node);
-			if (edge)
+			std::map<std::pair<int, int>, Node*>::iterator iter = edgeMap.find(key);
+			if (iter == edgeMap.end())
 			{
-				face->node->edgeArray.push_back(edge);
-				foundFace->node->edgeArray.push_back(edge);
-
-				this->graphElementArray->push_back(edge);
+				edgeMap.insert(std::pair<std::pair<int, int>, Node*>(key, node));
+				continue;
 			}
-		}
-	}
-}
 
-MeshGraph::Edge* MeshGraph::FindCommonEdge(Node* nodeA, Node* nodeB)
-{
-	Edge* edge = nullptr;
-
-	const Mesh::Face* faceA = this->targetMesh->GetFace(nodeA->polygon);
-	const Mesh::Face* faceB = this->targetMesh->GetFace(nodeB->polygon);
-
-	ConvexPolygon polygon[2];
-
-	faceA->GeneratePolygon(this->targetMesh).ToBasicPolygon(polygon[0]);
-	faceB->GeneratePolygon(this->targetMesh).ToBasicPolygon(polygon[1]);
+			Node* adjacentNode = iter->second;
+			if (adjacentNode == node || node->LinkedWith(adjacentNode))
+				continue;
 
-	std::vector<Point*> pointArray;
+			Edge* edge = this->EdgeFactory();
+			edge->adjacentNode[0] = adjacentNode;
+			edge->adjacentNode[1] = node;
+			edge->vertex[0] = key.first;
+			edge->vertex[1] = key.second;
 
-	for (int i = 0; i < 2; i++)
-	{
-		ConvexPolygon* polygonA = &polygon[i];
-		ConvexPolygon* polygonB = &polygon[1 - i];
-
-		for (int j = 0; j < (int)polygonA->vertexArray->size(); j++)
-		{
-			const Vector& vertex = (*polygonA->vertexArray)[j];
-			if (polygonB->ContainsPoint(vertex))
-				pointArray.push_back(new Point(vertex));
-		}
-	}
+			adjacentNode->edgeArray.push_back(edge);
+			node->edgeArray.push_back(edge);
 
-	// Remove redundant points to see how many there really are.
-	CompressArray<Point>(pointArray, [](const Point* pointA, const Point* pointB) -> Point* {
-		if (pointA->ContainsPoint(pointB->center))
-		{
-			delete pointB;
-			return const_cast<Point*>(pointA);
+			this->graphElementArray->push_back(edge);
 		}
-		return nullptr;
-	});
-
-	// Do we have a shared edge?
-	if (pointArray.size() == 2)
-	{
-		edge = new Edge(this);
-
-		edge->adjacentNode[0] = nodeA;
-		edge->adjacentNode[1] = nodeB;
-
-		edge->vertex[0] = this->targetMesh->FindVertex(pointArray[0]->center);
-		edge->vertex[1] = this->targetMesh->FindVertex(pointArray[1]->center);
 	}
-
-	for (Point* point : pointArray)
-		delete point;
-
-	return edge;
 }
 
 void MeshGraph::Clear()
@@ -217,28 +158,4 @@ MeshGraph::Node* MeshGraph::Edge::GetOtherAdjacency(Node* adjacency)
 const MeshGraph::Node* MeshGraph::Edge::GetOtherAdjacency(const Node* adjacency) const
 {
 	return const_cast<Edge*>(this)->GetOtherAdjacency(const_cast<Node*>(adjacency));
-}
-
-//--------------------------------- Face ---------------------------------
-
-MeshGraph::Face::Face(Node* node)
-{
-	this->node = node;
-}
-
-/*virtual*/ MeshGraph::Face::~Face()
-{
-}
-
-/*virtual*/ AxisAlignedBox MeshGraph::Face::CalcBoundingBox() const
-{
-	AxisAlignedBox box;
-	
-	const Mesh::Face* face = this->node->meshGraph->targetMesh->GetFace(this->node->polygon);
-	MW_ASSERT(face);
-	Mesh::ConvexPolygon polygon = face->GeneratePolygon(this->node->meshGraph->targetMesh);
-	for (int i = 0; i < (int)polygon.vertexArray.size(); i++)
-		box.MinimallyExpandToContainPoint(polygon.vertexArray[i].point);
-
-	return box;
 }
\ No newline at end of file
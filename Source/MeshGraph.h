@@ -2,7 +2,6 @@
 
 #include "Defines.h"
 #include "Mesh.h"
-#include "BoundingBoxTree.h"
 #include <vector>
 #include <functional>
 
@@ -69,19 +68,6 @@ namespace MeshWarrior
 
 	private:
 
-		class Face : public BoundingBoxTree::Guest
-		{
-		public:
-			Face(Node* node);
-			virtual ~Face();
-
-			virtual AxisAlignedBox CalcBoundingBox() const override;
-
-			Node* node;
-		};
-
-		Edge* FindCommonEdge(Node* nodeA, Node* nodeB);
-
 		std::vector<GraphElement*>* graphElementArray;
 		const Mesh* targetMesh;
 	};
@@ -1,13 +1,231 @@
 #include "MeshOperation.h"
+#include "TaskScheduler.h"
+#include "Mesh.h"
+#include <fstream>
+#include <sstream>
 
 using namespace MeshWarrior;
 
+//--------------------------------- MeshOperation ---------------------------------
+
 MeshOperation::MeshOperation()
 {
 	this->error = new std::string();
+	this->concurrency = 0;
+	this->scheduler = nullptr;
+	this->statistics = nullptr;
+	this->progressCallback = new ProgressCallback();
+	this->cancelled = false;
 }
 
 /*virtual*/ MeshOperation::~MeshOperation()
 {
 	delete this->error;
+	delete this->progressCallback;
+}
+
+void MeshOperation::SetProgressCallback(ProgressCallback progressCallback)
+{
+	*this->progressCallback = progressCallback;
+}
+
+void MeshOperation::Cancel()
+{
+	this->cancelled = true;
+}
+
+void MeshOperation::ResetCancel()
+{
+	this->cancelled = false;
+}
+
+bool MeshOperation::IsCancelled() const
+{
+	return this->cancelled;
+}
+
+bool MeshOperation::ReportProgress(Phase phase, double fraction)
+{
+	if (this->cancelled)
+	{
+		*this->error = "Operation cancelled.";
+		return false;
+	}
+
+	if (this->statistics)
+		this->statistics->MarkPhase(phase);
+
+	if (*this->progressCallback)
+		(*this->progressCallback)(phase, MW_CLAMP(fraction, 0.0, 1.0));
+
+	return true;
+}
+
+void MeshOperation::BeginStatistics()
+{
+	if (this->statistics)
+		this->statistics->Reset();
+}
+
+MeshOperation::AsyncCalculation* MeshOperation::CalculateAsync(const std::vector<Mesh*>& inputMeshArray)
+{
+	this->ResetCancel();
+
+	return new AsyncCalculation(this, inputMeshArray);
+}
+
+TaskScheduler* MeshOperation::GetScheduler()
+{
+	return this->scheduler ? this->scheduler : TaskScheduler::GetDefault();
+}
+
+void MeshOperation::ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc, int grainSize /*= 0*/)
+{
+	if (this->concurrency == 1)
+		rangeFunc(begin, end);
+	else
+		this->GetScheduler()->ParallelFor(begin, end, rangeFunc, grainSize, this->concurrency);
+}
+
+//--------------------------------- MeshOperation::AsyncCalculation ---------------------------------
+
+MeshOperation::AsyncCalculation::AsyncCalculation(MeshOperation* operation, const std::vector<Mesh*>& inputMeshArray)
+{
+	this->operation = operation;
+	this->inputMeshArray = new std::vector<Mesh*>(inputMeshArray);
+	this->outputMeshArray = new std::vector<Mesh*>();
+	this->finished = false;
+	this->result = false;
+
+	this->thread = new std::thread([this]() {
+		this->result = this->operation->Calculate(*this->inputMeshArray, *this->outputMeshArray);
+		this->finished = true;
+	});
+}
+
+/*virtual*/ MeshOperation::AsyncCalculation::~AsyncCalculation()
+{
+	if (!this->finished)
+		this->Cancel();
+
+	this->Join();
+
+	for (Mesh* mesh : *this->outputMeshArray)
+		delete mesh;
+
+	delete this->inputMeshArray;
+	delete this->outputMeshArray;
+}
+
+bool MeshOperation::AsyncCalculation::IsFinished() const
+{
+	return this->finished;
+}
+
+void MeshOperation::AsyncCalculation::Cancel()
+{
+	this->operation->Cancel();
+}
+
+void MeshOperation::AsyncCalculation::Join()
+{
+	if (this->thread)
+	{
+		this->thread->join();
+		delete this->thread;
+		this->thread = nullptr;
+	}
+}
+
+bool MeshOperation::AsyncCalculation::Wait(std::vector<Mesh*>& outputMeshArray)
+{
+	this->Join();
+
+	outputMeshArray = *this->outputMeshArray;
+	this->outputMeshArray->clear();
+	return this->result;
+}
+
+//--------------------------------- MeshOperation::Statistics ---------------------------------
+
+MeshOperation::Statistics::Statistics()
+{
+	this->Reset();
+}
+
+/*virtual*/ MeshOperation::Statistics::~Statistics()
+{
+}
+
+void MeshOperation::Statistics::Reset()
+{
+	for (int i = 0; i < NUM_PHASES; i++)
+		this->phaseTime[i] = 0.0;
+
+	this->totalTime = 0.0;
+	this->collisionPairCount = 0;
+	this->splitCount = 0;
+	this->splitFaceCount = 0;
+	this->outputFaceCount = 0;
+	this->rayCastCount = 0;
+	this->graphEdgeCount = 0;
+	this->peakAllocation = 0;
+	this->markTime = std::chrono::steady_clock::now();
+}
+
+// Charge the time since the last mark to the given phase.
+void MeshOperation::Statistics::MarkPhase(Phase phase)
+{
+	std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+	double elapsedTime = std::chrono::duration<double>(time - this->markTime).count();
+	this->markTime = time;
+
+	this->phaseTime[phase] += elapsedTime;
+	this->totalTime += elapsedTime;
+}
+
+std::string MeshOperation::Statistics::ToJSON() const
+{
+	std::stringstream stream;
+	stream.precision(9);
+
+	stream << "{\n\t\"phase_time\": {";
+	for (int i = 0; i < NUM_PHASES; i++)
+		stream << (i > 0 ? ", " : "") << "\"" << GetPhaseName(Phase(i)) << "\": " << this->phaseTime[i];
+	stream << "},\n";
+
+	stream << "\t\"total_time\": " << this->totalTime << ",\n";
+	stream << "\t\"collision_pair_count\": " << this->collisionPairCount << ",\n";
+	stream << "\t\"split_count\": " << this->splitCount << ",\n";
+	stream << "\t\"split_face_count\": " << this->splitFaceCount << ",\n";
+	stream << "\t\"output_face_count\": " << this->outputFaceCount << ",\n";
+	stream << "\t\"ray_cast_count\": " << this->rayCastCount << ",\n";
+	stream << "\t\"graph_edge_count\": " << this->graphEdgeCount << ",\n";
+	stream << "\t\"peak_allocation\": " << this->peakAllocation << "\n";
+	stream << "}\n";
+
+	return stream.str();
+}
+
+bool MeshOperation::Statistics::SaveJSON(const std::string& filePath) const
+{
+	std::ofstream fileStream(filePath);
+	if (!fileStream.is_open())
+		return false;
+
+	fileStream << this->ToJSON();
+	return fileStream.good();
+}
+
+/*static*/ const char* MeshOperation::Statistics::GetPhaseName(Phase phase)
+{
+	switch (phase)
+	{
+		case PHASE_SETUP:				return "setup";
+		case PHASE_CUTTING:				return "cutting";
+		case PHASE_GRAPH_BUILD:			return "graph_build";
+		case PHASE_COLORING:			return "coloring";
+		case PHASE_OUTPUT_ASSEMBLY:		return "output_assembly";
+		default:						return "unknown";
+	}
 }
\ No newline at end of file
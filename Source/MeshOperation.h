@@ -3,10 +3,19 @@
 #include "Defines.h"
 #include <string>
 #include <vector>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdint.h>
+
+// Hot loops only check for progress and cancellation every this many iterations.
+#define MW_PROGRESS_CHECK_INTERVAL		64
 
 namespace MeshWarrior
 {
 	class Mesh;
+	class TaskScheduler;
 
 	class MESH_WARRIOR_API MeshOperation
 	{
@@ -16,6 +25,123 @@ namespace MeshWarrior
 
 		virtual bool Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray) = 0;
 
+		enum Phase
+		{
+			PHASE_SETUP,
+			PHASE_CUTTING,
+			PHASE_GRAPH_BUILD,
+			PHASE_COLORING,
+			PHASE_OUTPUT_ASSEMBLY,
+			NUM_PHASES
+		};
+
+		// The callback is given the current phase and roughly how far along it is, from zero to one.
+		// It may be called from whatever thread is doing the calculation, so it should be quick.
+		typedef std::function<void(Phase phase, double fraction)> ProgressCallback;
+
+		void SetProgressCallback(ProgressCallback progressCallback);
+
+		// Cancellation is cooperative: the calculation notices it at its next check-point
+		// and fails with an error.  This can be called from any
+		// thread.  An operation stays cancelled until its next asynchronous calculation
+		// is started, or until the flag is explicitly reset.
+		void Cancel();
+		void ResetCancel();
+		bool IsCancelled() const;
+
+		// This is a calculation running on its own thread.  The input meshes must outlive it,
+		// and its operation must not be used for anything else until it has been waited on.
+		// Deleting one that is still running cancels it and waits, and any output meshes
+		// that were never claimed get deleted along with it.
+		class MESH_WARRIOR_API AsyncCalculation
+		{
+			friend class MeshOperation;
+
+		public:
+			virtual ~AsyncCalculation();
+
+			bool IsFinished() const;
+			void Cancel();
+
+			// Block until the calculation is finished, then hand over its output.  The return
+			// value is that of Calculate, and on failure, the operation has the error.
+			bool Wait(std::vector<Mesh*>& outputMeshArray);
+
+		private:
+			AsyncCalculation(MeshOperation* operation, const std::vector<Mesh*>& inputMeshArray);
+
+			void Join();
+
+			MeshOperation* operation;
+			std::vector<Mesh*>* inputMeshArray;
+			std::vector<Mesh*>* outputMeshArray;
+			std::thread* thread;
+			std::atomic<bool> finished;
+			bool result;
+		};
+
+		// The caller owns the returned calculation.
+		AsyncCalculation* CalculateAsync(const std::vector<Mesh*>& inputMeshArray);
+
+		// This is where the time of a calculation went, and how much work of each kind it did.
+		// Each phase is charged with the time from one progress report to the next one for
+		// that phase, so it's only as fine-grained as the progress reports.  Counters that don't
+		// apply to a given operation are left at zero.
+		class MESH_WARRIOR_API Statistics
+		{
+		public:
+			Statistics();
+			virtual ~Statistics();
+
+			void Reset();
+			void MarkPhase(Phase phase);
+
+			std::string ToJSON() const;
+			bool SaveJSON(const std::string& filePath) const;
+
+			static const char* GetPhaseName(Phase phase);
+
+			double phaseTime[NUM_PHASES];		// In seconds.
+			double totalTime;
+			int64_t collisionPairCount;			// Pairs of faces tested against one another.
+			int64_t splitCount;					// Faces that had to be split.
+			int64_t splitFaceCount;				// Faces produced by splitting.
+			int64_t outputFaceCount;			// Faces in all the results together.
+			int64_t rayCastCount;				// Rays cast to tell inside from outside.
+			int64_t graphEdgeCount;
+			int64_t peakAllocation;				// The most bytes that the cutting had in use at once.
+
+		private:
+
+			std::chrono::steady_clock::time_point markTime;
+		};
+
+		// A null pointer here, which is the default, means no statistics are gathered, so that
+		// nothing is spent on them.  Otherwise, each calculation fills in the statistics given.
+		// The caller owns them.
+		Statistics* statistics;
+
 		std::string* error;
+
+		// This is the most threads the operation will use at once.  Zero means as many as the
+		// scheduler has, and one means do everything on the calling thread.  A null scheduler
+		// means use the default one.
+		int concurrency;
+		TaskScheduler* scheduler;
+
+	protected:
+
+		TaskScheduler* GetScheduler();
+		void ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc, int grainSize = 0);
+
+		// Implementations call this at check-points in their hot loops.  It passes the progress along,
+		// and returns false (with the error set) if the calculation should stop because it was cancelled.
+		bool ReportProgress(Phase phase, double fraction);
+
+		// Implementations call this once the input checks out, just before getting down to work.
+		void BeginStatistics();
+
+		ProgressCallback* progressCallback;
+		std::atomic<bool> cancelled;
 	};
 }
\ No newline at end of file
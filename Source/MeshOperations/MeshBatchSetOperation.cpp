@@ -0,0 +1,366 @@
+#include "MeshBatchSetOperation.h"
+#include "../MeshVolume.h"
+#include "../Shape.h"
+
+using namespace MeshWarrior;
+
+MeshBatchSetOperation::MeshBatchSetOperation(int flags)
+{
+	this->flags = flags;
+	this->faceArray = new std::vector<Face*>();
+	this->meshBoxArray = new std::vector<MeshBox*>();
+	this->volumeArray = new std::vector<MeshVolume*>();
+}
+
+/*virtual*/ MeshBatchSetOperation::~MeshBatchSetOperation()
+{
+	this->Clear();
+
+	delete this->faceArray;
+	delete this->meshBoxArray;
+	delete this->volumeArray;
+}
+
+void MeshBatchSetOperation::Clear()
+{
+	this->faceTree.Clear();
+	this->meshBoxTree.Clear();
+
+	for (Face* face : *this->faceArray)
+		delete face;
+
+	for (MeshBox* meshBox : *this->meshBoxArray)
+		delete meshBox;
+
+	for (MeshVolume* volume : *this->volumeArray)
+		delete volume;
+
+	this->faceArray->clear();
+	this->meshBoxArray->clear();
+	this->volumeArray->clear();
+}
+
+/*virtual*/ bool MeshBatchSetOperation::Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray)
+{
+	*this->error = "";
+
+	this->Clear();
+
+	if (inputMeshArray.size() == 0)
+	{
+		*this->error = "The batch set operation needs at least one mesh as input.";
+		return false;
+	}
+
+	if ((this->flags & MW_FLAG_ALL_SET_OP_RESULTS) == 0)
+	{
+		*this->error = "No flags given for batch set operation.";
+		return false;
+	}
+
+	for (const Mesh* mesh : inputMeshArray)
+	{
+		if (mesh == nullptr)
+		{
+			*this->error = "All given meshes must be non-null.";
+			return false;
+		}
+	}
+
+	this->BeginStatistics();
+
+	if (!this->ReportProgress(PHASE_SETUP, 0.0))
+		return false;
+
+	int meshCount = (int)inputMeshArray.size();
+
+	//
+	// Index all the faces of all the meshes in one tree, and all the meshes themselves in another.
+	// Each mesh also gets a volume that can tell us what's inside of it.
+	//
+
+	AxisAlignedBox rootBox;
+
+	for (int i = 0; i < meshCount; i++)
+	{
+		std::vector<Mesh::ConvexPolygon> polygonArray;
+		inputMeshArray[i]->ToPolygonArray(polygonArray);
+
+		for (const Mesh::ConvexPolygon& meshPolygon : polygonArray)
+		{
+			Face* face = new Face();
+			face->meshIndex = i;
+			face->meshPolygon = meshPolygon;
+			meshPolygon.ToBasicPolygon(face->polygon);
+			if (!face->polygon.CalcPlane(face->plane))
+			{
+				delete face;
+				continue;
+			}
+
+			for (const Vector& point : *face->polygon.vertexArray)
+				face->box.MinimallyExpandToContainPoint(point);
+
+			rootBox.MinimallyExpandToContainBox(face->box);
+			this->faceArray->push_back(face);
+		}
+
+		MeshBox* meshBox = new MeshBox();
+		meshBox->meshIndex = i;
+		meshBox->box = inputMeshArray[i]->CalcBoundingBox();
+		this->meshBoxArray->push_back(meshBox);
+
+		this->volumeArray->push_back(new MeshVolume());
+	}
+
+	this->ParallelFor(0, meshCount, [this, &inputMeshArray](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			(*this->volumeArray)[i]->Generate(inputMeshArray[i]);
+	}, 1);
+
+	this->faceTree.SetRootBox(rootBox);
+	for (Face* face : *this->faceArray)
+		this->faceTree.AddGuest(face);
+
+	this->meshBoxTree.SetRootBox(rootBox);
+	for (MeshBox* meshBox : *this->meshBoxArray)
+		this->meshBoxTree.AddGuest(meshBox);
+
+	if (!this->ReportProgress(PHASE_SETUP, 1.0))
+		return false;
+
+	//
+	// Cut up every face against the faces it touches.  Faces are independent of one another here.
+	//
+
+	int faceCount = (int)this->faceArray->size();
+	std::vector<std::vector<Fragment>> faceFragmentArray(faceCount);
+
+	this->ParallelFor(0, faceCount, [this, &faceFragmentArray](int begin, int end) {
+		for (int i = begin; i < end && !this->IsCancelled(); i++)
+			this->CutFace((*this->faceArray)[i], faceFragmentArray[i]);
+	});
+
+	if (!this->ReportProgress(PHASE_CUTTING, 1.0))
+		return false;
+
+	//
+	// Now decide which meshes contain each fragment.  This takes the place of graph coloring.
+	//
+
+	this->ParallelFor(0, faceCount, [this, &faceFragmentArray](int begin, int end) {
+		for (int i = begin; i < end && !this->IsCancelled(); i++)
+			for (Fragment& fragment : faceFragmentArray[i])
+				this->ClassifyFragment((*this->faceArray)[i]->meshIndex, fragment);
+	});
+
+	if (!this->ReportProgress(PHASE_COLORING, 1.0))
+		return false;
+
+	//
+	// Lastly, keep or throw away each fragment according to the flags.  A fragment that ends up
+	// bounding the result from the other side of its original surface gets reverse-wound.
+	//
+
+	struct Output
+	{
+		int flag;
+		const char* name;
+	};
+
+	static const Output outputArray[] =
+	{
+		{ MW_FLAG_UNION_SET_OP, "union" },
+		{ MW_FLAG_INTERSECTION_SETP_OP, "intersection" },
+		{ MW_FLAG_A_MINUS_B_SET_OP, "a_minus_b" },
+		{ MW_FLAG_B_MINUS_A_SET_OP, "b_minus_a" }
+	};
+
+	outputMeshArray.clear();
+
+	bool keepAttributes = (this->flags & MW_FLAG_SKIP_ATTRIBUTES_SET_OP) == 0;
+	bool matchAttributes = (this->flags & MW_FLAG_SPLIT_ATTRIBUTES_SET_OP) != 0;
+
+	for (const Output& output : outputArray)
+	{
+		if ((this->flags & output.flag) == 0)
+			continue;
+
+		Mesh* mesh = new Mesh();
+		*mesh->name = output.name;
+
+		MeshSetOperation::OutputBuilder outputBuilder(mesh, matchAttributes);
+
+		for (int i = 0; i < faceCount; i++)
+		{
+			const Face* face = (*this->faceArray)[i];
+			int meshIndex = face->meshIndex;
+
+			for (const Fragment& fragment : faceFragmentArray[i])
+			{
+				bool outsideRest = fragment.insideRestCount == 0;
+				bool keep = false, reverse = false;
+
+				switch (output.flag)
+				{
+					case MW_FLAG_UNION_SET_OP:
+					{
+						keep = !fragment.insideFirst && outsideRest;
+						break;
+					}
+					case MW_FLAG_INTERSECTION_SETP_OP:
+					{
+						keep = (fragment.insideFirst ? 1 : 0) + fragment.insideRestCount == meshCount - 1;
+						break;
+					}
+					case MW_FLAG_A_MINUS_B_SET_OP:
+					{
+						keep = (meshIndex == 0) ? outsideRest : (fragment.insideFirst && outsideRest);
+						reverse = meshIndex != 0;
+						break;
+					}
+					case MW_FLAG_B_MINUS_A_SET_OP:
+					{
+						keep = (meshIndex == 0) ? !outsideRest : (!fragment.insideFirst && outsideRest);
+						reverse = meshIndex == 0;
+						break;
+					}
+				}
+
+				if (!keep)
+					continue;
+
+				Mesh::ConvexPolygon polygon;
+				if (keepAttributes)
+				{
+					for (const Vector& point : *fragment.polygon.vertexArray)
+						polygon.vertexArray.push_back(face->meshPolygon.InterpolateVertex(point));
+				}
+				else
+					polygon.FromBasicPolygon(fragment.polygon);
+
+				if (reverse)
+					polygon.ReverseWinding();
+
+				outputBuilder.AddPolygon(polygon);
+			}
+		}
+
+		// Every face was cut on its own, so fragments of neighboring faces rarely have their vertices in the same places.
+		if (!matchAttributes)
+			outputBuilder.StitchSeams();
+
+		if (this->statistics)
+			this->statistics->outputFaceCount += mesh->GetNumFaces();
+
+		outputMeshArray.push_back(mesh);
+	}
+
+	this->Clear();
+
+	this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 1.0);
+
+	return true;
+}
+
+// Only faces of other meshes that actually intersect a fragment get to cut it.  As the fragments
+// get smaller, fewer of them are touched by each of the remaining cutting faces.
+void MeshBatchSetOperation::CutFace(const Face* face, std::vector<Fragment>& fragmentArray) const
+{
+	std::vector<ConvexPolygon> polygonArray, newPolygonArray, splitPolygonArray;
+	polygonArray.push_back(face->polygon);
+
+	std::list<BoundingBoxTree::Guest*> guestList;
+	this->faceTree.FindGuests(face->box, guestList);
+
+	for (BoundingBoxTree::Guest* guest : guestList)
+	{
+		const Face* cuttingFace = (Face*)guest;
+		if (cuttingFace->meshIndex == face->meshIndex)
+			continue;
+
+		newPolygonArray.clear();
+
+		for (const ConvexPolygon& polygon : polygonArray)
+		{
+			Shape* shape = polygon.IntersectWith(&cuttingFace->polygon);
+			if (shape)
+			{
+				delete shape;
+
+				splitPolygonArray.clear();
+				polygon.SplitAgainstPlane(cuttingFace->plane, splitPolygonArray);
+				if (splitPolygonArray.size() > 1)
+				{
+					for (const ConvexPolygon& splitPolygon : splitPolygonArray)
+						newPolygonArray.push_back(splitPolygon);
+
+					continue;
+				}
+			}
+
+			newPolygonArray.push_back(polygon);
+		}
+
+		polygonArray.swap(newPolygonArray);
+	}
+
+	fragmentArray.resize(polygonArray.size());
+	for (int i = 0; i < (int)polygonArray.size(); i++)
+		fragmentArray[i].polygon = polygonArray[i];
+}
+
+void MeshBatchSetOperation::ClassifyFragment(int meshIndex, Fragment& fragment) const
+{
+	fragment.insideFirst = false;
+	fragment.insideRestCount = 0;
+
+	Vector center = fragment.polygon.CalcCenter();
+
+	std::list<BoundingBoxTree::Guest*> guestList;
+	this->meshBoxTree.FindGuests(AxisAlignedBox(center), guestList);
+
+	for (BoundingBoxTree::Guest* guest : guestList)
+	{
+		int i = ((MeshBox*)guest)->meshIndex;
+		if (i == meshIndex || !(*this->volumeArray)[i]->ContainsPoint(center))
+			continue;
+
+		if (i == 0)
+			fragment.insideFirst = true;
+		else
+			fragment.insideRestCount++;
+	}
+}
+
+//--------------------------------- MeshBatchSetOperation::Face ---------------------------------
+
+MeshBatchSetOperation::Face::Face()
+{
+	this->meshIndex = -1;
+}
+
+/*virtual*/ MeshBatchSetOperation::Face::~Face()
+{
+}
+
+/*virtual*/ AxisAlignedBox MeshBatchSetOperation::Face::CalcBoundingBox() const
+{
+	return this->box;
+}
+
+//--------------------------------- MeshBatchSetOperation::MeshBox ---------------------------------
+
+MeshBatchSetOperation::MeshBox::MeshBox()
+{
+	this->meshIndex = -1;
+}
+
+/*virtual*/ MeshBatchSetOperation::MeshBox::~MeshBox()
+{
+}
+
+/*virtual*/ AxisAlignedBox MeshBatchSetOperation::MeshBox::CalcBoundingBox() const
+{
+	return this->box;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../MeshOperation.h"
+#include "../BoundingBoxTree.h"
+#include "../Mesh.h"
+#include "../Polygon.h"
+#include "MeshSetOperation.h"
+
+namespace MeshWarrior
+{
+	class MeshVolume;
+
+	// This performs a set operation on any number of meshes in a single pass, rather than
+	// as a chain of two-mesh operations.  The flags are those of the mesh set operation: union
+	// and intersection take in every mesh, while for the differences, the first mesh plays the
+	// part of A and the union of all the others plays the part of B.  So, for example, A minus B
+	// subtracts every other mesh from the first one, and intersection keeps only what's inside all
+	// of them.  Unless told to skip them, the vertex attributes of each fragment are interpolated
+	// from its original face.
+	//
+	// Every face is cut, independently of every other face, against all the faces of the other
+	// meshes that it actually touches, and every resulting fragment is then classified by asking
+	// the other meshes whether they contain its center.  There is no graph to walk, so both
+	// steps go wide.  As with the mesh set operation, the inputs should be closed and consistently
+	// wound, and faces of different meshes lying in the same plane are not handled gracefully.
+	class MESH_WARRIOR_API MeshBatchSetOperation : public MeshOperation
+	{
+	public:
+		MeshBatchSetOperation(int flags);
+		virtual ~MeshBatchSetOperation();
+
+		virtual bool Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray) override;
+
+	protected:
+
+		int flags;
+
+		class Face : public BoundingBoxTree::Guest
+		{
+		public:
+			Face();
+			virtual ~Face();
+
+			virtual AxisAlignedBox CalcBoundingBox() const override;
+
+			int meshIndex;
+			ConvexPolygon polygon;
+			Mesh::ConvexPolygon meshPolygon;
+			Plane plane;
+			AxisAlignedBox box;
+		};
+
+		class MeshBox : public BoundingBoxTree::Guest
+		{
+		public:
+			MeshBox();
+			virtual ~MeshBox();
+
+			virtual AxisAlignedBox CalcBoundingBox() const override;
+
+			int meshIndex;
+			AxisAlignedBox box;
+		};
+
+		// A fragment is a piece of an input face along with how many of the other meshes contain it.
+		struct Fragment
+		{
+			ConvexPolygon polygon;
+			bool insideFirst;
+			int insideRestCount;
+		};
+
+		void CutFace(const Face* face, std::vector<Fragment>& fragmentArray) const;
+		void ClassifyFragment(int meshIndex, Fragment& fragment) const;
+		void Clear();
+
+		std::vector<Face*>* faceArray;
+		std::vector<MeshBox*>* meshBoxArray;
+		std::vector<MeshVolume*>* volumeArray;
+		BoundingBoxTree faceTree;
+		BoundingBoxTree meshBoxTree;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "MeshIncrementalSetOperation.h"
+#include "../MeshVolume.h"
+#include <algorithm>
+
+using namespace MeshWarrior;
+
+MeshIncrementalSetOperation::MeshIncrementalSetOperation(int flags) : MeshSetOperation(flags)
+{
+	this->cachedMesh = nullptr;
+	this->cachedVertexCount = 0;
+	this->cachedFaceCount = 0;
+	this->cachedVolume = new MeshVolume();
+	this->neighborArray = new std::vector<std::vector<int>>();
+	this->faceBoxArray = new std::vector<FaceBox*>();
+	this->nearFaceArray = new std::vector<bool>();
+}
+
+/*virtual*/ MeshIncrementalSetOperation::~MeshIncrementalSetOperation()
+{
+	this->ClearCache();
+
+	delete this->cachedVolume;
+	delete this->neighborArray;
+	delete this->faceBoxArray;
+	delete this->nearFaceArray;
+}
+
+void MeshIncrementalSetOperation::Invalidate()
+{
+	this->ClearCache();
+}
+
+void MeshIncrementalSetOperation::ClearCache()
+{
+	this->cachedMesh = nullptr;
+	this->cachedVertexCount = 0;
+	this->cachedFaceCount = 0;
+	this->cachedBox = AxisAlignedBox();
+	this->cachedVolume->Clear();
+	this->neighborArray->clear();
+	this->faceBoxTree.Clear();
+
+	for (FaceBox* faceBox : *this->faceBoxArray)
+		delete faceBox;
+
+	this->faceBoxArray->clear();
+	this->nearFaceArray->clear();
+}
+
+bool MeshIncrementalSetOperation::IsCacheValid(const Mesh* mesh) const
+{
+	return mesh == this->cachedMesh && mesh->GetNumVertices() == this->cachedVertexCount && mesh->GetNumFaces() == this->cachedFaceCount;
+}
+
+void MeshIncrementalSetOperation::GenerateCache(const Mesh* mesh)
+{
+	this->ClearCache();
+
+	this->cachedMesh = mesh;
+	this->cachedVertexCount = mesh->GetNumVertices();
+	this->cachedFaceCount = mesh->GetNumFaces();
+	this->cachedBox = mesh->CalcBoundingBox();
+	this->cachedVolume->Generate(mesh);
+
+	this->faceBoxTree.SetRootBox(this->cachedBox);
+
+	for (int i = 0; i < this->cachedFaceCount; i++)
+	{
+		FaceBox* faceBox = new FaceBox();
+		faceBox->faceIndex = i;
+		for (int j : mesh->GetFace(i)->vertexArray)
+			faceBox->box.MinimallyExpandToContainPoint(mesh->GetVertex(j)->point);
+
+		this->faceBoxArray->push_back(faceBox);
+		this->faceBoxTree.AddGuest(faceBox);
+	}
+
+	// Faces are neighbors if one has an edge going the opposite way of an edge of the other.
+	std::map<std::pair<int, int>, int> edgeMap;
+	for (int i = 0; i < this->cachedFaceCount; i++)
+	{
+		const std::vector<int>& vertexArray = mesh->GetFace(i)->vertexArray;
+		for (int j = 0; j < (int)vertexArray.size(); j++)
+			edgeMap[std::pair<int, int>(vertexArray[j], vertexArray[(j + 1) % vertexArray.size()])] = i;
+	}
+
+	this->neighborArray->resize(this->cachedFaceCount);
+	for (int i = 0; i < this->cachedFaceCount; i++)
+	{
+		const std::vector<int>& vertexArray = mesh->GetFace(i)->vertexArray;
+		for (int j = 0; j < (int)vertexArray.size(); j++)
+		{
+			std::map<std::pair<int, int>, int>::iterator iter = edgeMap.find(std::pair<int, int>(vertexArray[(j + 1) % vertexArray.size()], vertexArray[j]));
+			if (iter != edgeMap.end() && iter->second != i)
+				(*this->neighborArray)[i].push_back(iter->second);
+		}
+	}
+}
+
+/*virtual*/ bool MeshIncrementalSetOperation::Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray)
+{
+	*this->error = "";
+
+	this->Clear();
+
+	if (inputMeshArray.size() != 2)
+	{
+		*this->error = "The mesh set operation needs exactly two meshes as input.";
+		return false;
+	}
+
+	if ((this->flags & MW_FLAG_ALL_SET_OP_RESULTS) == 0)
+	{
+		*this->error = "No flags given for mesh set operation.";
+		return false;
+	}
+
+	const Mesh* meshA = inputMeshArray[0];
+	const Mesh* meshB = inputMeshArray[1];
+
+	if (meshA == nullptr || meshB == nullptr)
+	{
+		*this->error = "Both given meshes must be non-null.";
+		return false;
+	}
+
+	this->BeginStatistics();
+
+	if (!this->IsCacheValid(meshA))
+		this->GenerateCache(meshA);
+
+	this->nearFaceArray->assign(this->cachedFaceCount, false);
+
+	// Only the part of A near B gets handed over to be cut.
+	AxisAlignedBox overlapBox;
+	bool boxesOverlap = overlapBox.Intersect(this->cachedBox, meshB->CalcBoundingBox());
+
+	Mesh nearMesh;
+	if (boxesOverlap)
+	{
+		overlapBox.AddMargin(MW_EPS);
+		this->MakeNearMesh(meshA, overlapBox, nearMesh);
+	}
+
+	// If no part of A is near B, then B is either entirely inside of A or entirely outside of it,
+	// and either way, all of A gets added back in as the output is assembled.
+	if (nearMesh.GetNumFaces() == 0)
+		return this->CalculateWithoutCutting(&nearMesh, meshB, boxesOverlap, outputMeshArray);
+
+	return this->CalculateSetOperation(&nearMesh, meshB, outputMeshArray);
+}
+
+// Copy the faces of the given mesh that touch the given region, along with their neighbors, into a mesh of their own.
+// The neighbors can't be cut, but they can have vertices put along the edges they share with faces that are.
+void MeshIncrementalSetOperation::MakeNearMesh(const Mesh* mesh, const AxisAlignedBox& overlapBox, Mesh& nearMesh)
+{
+	std::list<BoundingBoxTree::Guest*> guestList;
+	this->faceBoxTree.FindGuests(overlapBox, guestList);
+
+	std::vector<int> faceIndexArray;
+	for (BoundingBoxTree::Guest* guest : guestList)
+	{
+		int i = ((FaceBox*)guest)->faceIndex;
+		(*this->nearFaceArray)[i] = true;
+		faceIndexArray.push_back(i);
+	}
+
+	int touchingCount = (int)faceIndexArray.size();
+	for (int i = 0; i < touchingCount; i++)
+	{
+		for (int j : (*this->neighborArray)[faceIndexArray[i]])
+		{
+			if (!(*this->nearFaceArray)[j])
+			{
+				(*this->nearFaceArray)[j] = true;
+				faceIndexArray.push_back(j);
+			}
+		}
+	}
+
+	// Keeping the faces in their original order makes the cutting come out just as it would for the whole mesh.
+	std::sort(faceIndexArray.begin(), faceIndexArray.end());
+
+	std::vector<int> vertexMap(mesh->GetNumVertices(), -1);
+	for (int i : faceIndexArray)
+	{
+		Mesh::Face face = *mesh->GetFace(i);
+		for (int& j : face.vertexArray)
+		{
+			if (vertexMap[j] < 0)
+				vertexMap[j] = nearMesh.AddVertex(*mesh->GetVertex(j));
+
+			j = vertexMap[j];
+		}
+
+		nearMesh.AddFace(face);
+	}
+}
+
+// All the faces of A that weren't handed over to be cut are outside of B, since they don't even reach its bounding box.
+// They're picked straight out of A, and get welded to the rest of A where they meet the faces that were handed over.
+/*virtual*/ void MeshIncrementalSetOperation::AssembleOutput(const std::vector<SortedFaces>& sortedFacesArrayA, const std::vector<SortedFaces>& sortedFacesArrayB, std::vector<Mesh*>& outputMeshArray)
+{
+	std::vector<SortedFaces> allSortedFacesArrayA(sortedFacesArrayA);
+
+	SortedFaces farSortedFaces;
+	farSortedFaces.mesh = this->cachedMesh;
+	for (int i = 0; i < this->cachedFaceCount; i++)
+		if (!(*this->nearFaceArray)[i])
+			farSortedFaces.outsideFaceArray.push_back(i);
+
+	allSortedFacesArrayA.push_back(farSortedFaces);
+
+	MeshSetOperation::AssembleOutput(allSortedFacesArrayA, sortedFacesArrayB, outputMeshArray);
+}
+
+// What's inside of the part of A we were given is what's inside of all of A, which we already know.
+/*virtual*/ const MeshVolume* MeshIncrementalSetOperation::GenerateVolume(Face::Family family, const Mesh* mesh)
+{
+	if (family == Face::FAMILY_A)
+		return this->cachedVolume;
+
+	return MeshSetOperation::GenerateVolume(family, mesh);
+}
+
+// The region where things can happen is bounded by all of A, not just the part of it we were given.  Otherwise,
+// faces of B beyond that part would be taken to be far from A, and therefore outside of it, which they may not be.
+/*virtual*/ AxisAlignedBox MeshIncrementalSetOperation::CalcMeshBox(Face::Family family, const Mesh* mesh)
+{
+	if (family == Face::FAMILY_A)
+		return this->cachedBox;
+
+	return MeshSetOperation::CalcMeshBox(family, mesh);
+}
+
+//--------------------------------- MeshIncrementalSetOperation::FaceBox ---------------------------------
+
+MeshIncrementalSetOperation::FaceBox::FaceBox()
+{
+	this->faceIndex = -1;
+}
+
+/*virtual*/ MeshIncrementalSetOperation::FaceBox::~FaceBox()
+{
+}
+
+/*virtual*/ AxisAlignedBox MeshIncrementalSetOperation::FaceBox::CalcBoundingBox() const
+{
+	return this->box;
+}
\ No newline at end of file
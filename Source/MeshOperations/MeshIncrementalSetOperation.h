@@ -0,0 +1,62 @@
+#pragma once
+
+#include "MeshSetOperation.h"
+
+namespace MeshWarrior
+{
+	// This is a set operation between a mesh A that stays put from one calculation to the next,
+	// and a mesh B that keeps changing, as when the same big part is cut again and again by a small
+	// tool that moves a little each time.  Everything about A that doesn't depend on B (its volume,
+	// a tree of its faces, and which of its faces are next to which) is worked out once and kept.
+	// Each calculation then only cuts up the faces of A that lie where the bounding boxes of A and B
+	// overlap, along with their immediate neighbors, which may pick up vertices along shared edges.
+	// All other faces of A are certainly outside of B, and go straight into the results as they are.
+	// Since the kept data is never itself cut, whatever B cut up last time is simply whole again.
+	class MESH_WARRIOR_API MeshIncrementalSetOperation : public MeshSetOperation
+	{
+	public:
+		MeshIncrementalSetOperation(int flags);
+		virtual ~MeshIncrementalSetOperation();
+
+		virtual bool Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray) override;
+
+		// A different mesh A is noticed automatically, but if mesh A is changed in place, call this.
+		void Invalidate();
+
+	protected:
+
+		virtual void AssembleOutput(const std::vector<SortedFaces>& sortedFacesArrayA, const std::vector<SortedFaces>& sortedFacesArrayB, std::vector<Mesh*>& outputMeshArray) override;
+		virtual const MeshVolume* GenerateVolume(Face::Family family, const Mesh* mesh) override;
+		virtual AxisAlignedBox CalcMeshBox(Face::Family family, const Mesh* mesh) override;
+
+		class FaceBox : public BoundingBoxTree::Guest
+		{
+		public:
+			FaceBox();
+			virtual ~FaceBox();
+
+			virtual AxisAlignedBox CalcBoundingBox() const override;
+
+			int faceIndex;
+			AxisAlignedBox box;
+		};
+
+		bool IsCacheValid(const Mesh* mesh) const;
+		void GenerateCache(const Mesh* mesh);
+		void ClearCache();
+		void MakeNearMesh(const Mesh* mesh, const AxisAlignedBox& overlapBox, Mesh& nearMesh);
+
+		// This is all about mesh A.
+		const Mesh* cachedMesh;
+		int cachedVertexCount;
+		int cachedFaceCount;
+		AxisAlignedBox cachedBox;
+		MeshVolume* cachedVolume;
+		std::vector<std::vector<int>>* neighborArray;
+		std::vector<FaceBox*>* faceBoxArray;
+		BoundingBoxTree faceBoxTree;
+
+		// This tells which faces of A were handed over to be cut by the current calculation.
+		std::vector<bool>* nearFaceArray;
+	};
+}
\ No newline at end of file
@@ -1,37 +1,59 @@
 #include "MeshSetOperation.h"
 #include "../Mesh.h"
 #include "../Polyline.h"
-#include "../Ray.h"
+#include "../MeshVolume.h"
+#include "../Predicates.h"
+#include "../VectorKernels.h"
 #if MW_DEBUG_DUMP_REFINED_MESHES || MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES || MW_DEBUG_DUMP_CUT_CASE
 #	include "../FileFormats/OBJFormat.h"
 #endif
-#include <set>
 #include <assert.h>
+#include <math.h>
+#include <algorithm>
 
 using namespace MeshWarrior;
 
 MeshSetOperation::MeshSetOperation(int flags)
 {
 	this->flags = flags;
-	this->faceSet = new std::set<Face*>();
+	this->faceSet = new IndexedSet<Face>();
+	this->farFaceArray = new std::vector<Face*>();
+	this->cutMeshA = new CutMesh();
+	this->cutMeshB = new CutMesh();
 #if MW_DEBUG_USE_STACK_HEAP
 	this->faceHeap = new StackHeap<Face>(1024 * 1024);
 #else
-	this->faceHeap = new TypeHeap<Face>();
+	this->faceHeap = new SlabHeap<Face>();
 #endif
 	this->cutBoundarySegmentArray = new std::vector<LineSegment*>();
 	this->cutBoundaryPolylineArray = new std::vector<Polyline*>();
 	this->graphA = new Graph();
 	this->graphB = new Graph();
+	this->volumeA = new MeshVolume();
+	this->volumeB = new MeshVolume();
 }
 
 /*virtual*/ MeshSetOperation::~MeshSetOperation()
 {
-	for (Face* face : *this->faceSet)
-		this->faceHeap->Deallocate(face);
+	this->Clear();
 
 	delete this->faceSet;
+	delete this->farFaceArray;
+	delete this->cutMeshA;
+	delete this->cutMeshB;
 	delete this->faceHeap;
+	delete this->cutBoundarySegmentArray;
+	delete this->cutBoundaryPolylineArray;
+	delete this->graphA;
+	delete this->graphB;
+	delete this->volumeA;
+	delete this->volumeB;
+}
+
+// Throw away everything left over from any previous calculation.
+void MeshSetOperation::Clear()
+{
+	this->FreeFaces();
 
 	for (LineSegment* lineSegment : *this->cutBoundarySegmentArray)
 		delete lineSegment;
@@ -39,17 +61,47 @@ MeshSetOperation::MeshSetOperation(int flags)
 	for (Polyline* polyline : *this->cutBoundaryPolylineArray)
 		delete polyline;
 
-	delete this->cutBoundarySegmentArray;
-	delete this->cutBoundaryPolylineArray;
+	this->cutBoundarySegmentArray->clear();
+	this->cutBoundaryPolylineArray->clear();
+
+	this->graphA->Clear();
+	this->graphB->Clear();
+
+	this->volumeA->Clear();
+	this->volumeB->Clear();
 
-	this->graphA;
-	this->graphB;
+	this->refinedMeshA.Clear();
+	this->refinedMeshB.Clear();
+}
+
+void MeshSetOperation::FreeFaces()
+{
+	this->faceSet->ForAll([this](Face* face) -> bool {
+		this->faceHeap->Deallocate(face);
+		return false;
+	});
+
+	this->faceSet->Clear();
+
+	for (Face* face : *this->farFaceArray)
+		this->faceHeap->Deallocate(face);
+
+	this->farFaceArray->clear();
+
+	this->cutMeshA->Clear();
+	this->cutMeshB->Clear();
+
+#if !MW_DEBUG_USE_STACK_HEAP
+	this->faceHeap->Reset();
+#endif
 }
 
 /*virtual*/ bool MeshSetOperation::Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray)
 {
 	*this->error = "";
 
+	this->Clear();
+
 	//
 	// Make sure we were given the right number of arguments, and given some flags.
 	//
@@ -60,7 +112,7 @@ MeshSetOperation::MeshSetOperation(int flags)
 		return false;
 	}
 
-	if (this->flags == 0)
+	if ((this->flags & MW_FLAG_ALL_SET_OP_RESULTS) == 0)
 	{
 		*this->error = "No flags given for mesh set operation.";
 		return false;
@@ -75,31 +127,34 @@ MeshSetOperation::MeshSetOperation(int flags)
 		return false;
 	}
 
+	this->BeginStatistics();
+
+	return this->CalculateSetOperation(meshA, meshB, outputMeshArray);
+}
+
+// This is the calculation proper, once the input has been checked and anything left over from before cleared away.
+bool MeshSetOperation::CalculateSetOperation(const Mesh* meshA, const Mesh* meshB, std::vector<Mesh*>& outputMeshArray)
+{
+	if (!this->ReportProgress(PHASE_SETUP, 0.0))
+		return false;
+
 	//
-	// Throw all the polygons from each mesh into a single set.
-	// Label each polygon so that we can continue to differentiate between them.
+	// Throw all the faces from each mesh into a single set.
+	// Label each face so that we can continue to differentiate between them.
 	//
 
-	std::vector<Mesh::ConvexPolygon> polygonArrayA, polygonArrayB;
+	// If the meshes can't possibly touch, then there's no need to go any further.
+	AxisAlignedBox overlapBox;
+	if (!overlapBox.Intersect(this->CalcMeshBox(Face::FAMILY_A, meshA), this->CalcMeshBox(Face::FAMILY_B, meshB)))
+		return this->CalculateWithoutCutting(meshA, meshB, false, outputMeshArray);
 
-	meshA->ToPolygonArray(polygonArrayA);
-	meshB->ToPolygonArray(polygonArrayB);
+	// A face that doesn't touch the region where the two bounding boxes overlap can't touch
+	// the other mesh at all, so it is far away from all the action, and certainly outside of
+	// the other mesh.  Only the remaining faces, near the action, need to be cut up and colored.
+	overlapBox.AddMargin(MW_EPS);
 
-	for (Mesh::ConvexPolygon& polygon : polygonArrayA)
-	{
-		Face* face = this->faceHeap->Allocate();
-		face->family = Face::FAMILY_A;
-		face->polygon = polygon;
-		this->faceSet->insert(face);
-	}
-
-	for (Mesh::ConvexPolygon& polygon : polygonArrayB)
-	{
-		Face* face = this->faceHeap->Allocate();
-		face->family = Face::FAMILY_B;
-		face->polygon = polygon;
-		this->faceSet->insert(face);
-	}
+	this->AddFaces(meshA, Face::FAMILY_A, this->cutMeshA, overlapBox);
+	this->AddFaces(meshB, Face::FAMILY_B, this->cutMeshB, overlapBox);
 
 	//
 	// Throw all the faces into a spacial sorting data-structure.
@@ -108,73 +163,106 @@ MeshSetOperation::MeshSetOperation(int flags)
 
 	AxisAlignedBox rootBox;
 
-	for (Face* face : *this->faceSet)
+	this->faceSet->ForAll([&rootBox](Face* face) -> bool {
 		rootBox.MinimallyExpandToContainBox(face->CalcBoundingBox());
+		return false;
+	});
 
 	this->faceTree.Clear();
 	this->faceTree.SetRootBox(rootBox);
 
-	for (Face* face : *this->faceSet)
+	this->faceSet->ForAll([this](Face* face) -> bool {
 		this->faceTree.AddGuest(face);
+		return false;
+	});
 
 	int totalGuests = this->faceTree.TotalGuests();
-	MW_ASSERT(totalGuests == this->faceSet->size());
+	MW_ASSERT(totalGuests == this->faceSet->GetNumMembers());
 
 	//
 	// Find all the initial collision pairs.
 	//
 
-	std::list<CollisionPair> collisionPairQueue;
-	for (Face* faceA : *this->faceSet)
-	{
-		if (faceA->family == Face::FAMILY_A)
-		{
-			std::list<BoundingBoxTree::Guest*> guestList;
-			this->faceTree.FindGuests(faceA->CalcBoundingBox(), guestList);
-
-			for (BoundingBoxTree::Guest* guest : guestList)
+	// The tree queries are read-only, so they can go wide.  Each slot gets its own
+	// list of pairs, and these are stitched together in slot order afterward so
+	// that the queue comes out the same no matter how the work was divided up.
+	std::vector<std::list<CollisionPair>> slotPairListArray(this->faceSet->GetNumSlots());
+	this->ParallelFor(0, this->faceSet->GetNumSlots(), [this, &slotPairListArray](int beginSlot, int endSlot) {
+		std::list<BoundingBoxTree::Guest*> guestList;
+		this->faceSet->ForAllInRange(beginSlot, endSlot, [this, &slotPairListArray, &guestList](Face* faceA) -> bool {
+			if (this->IsCancelled())
+				return true;
+
+			if (faceA->family == Face::FAMILY_A)
 			{
-				Face* faceB = (Face*)guest;
-				if (faceB->family == Face::FAMILY_B)
+				this->faceTree.FindGuests(faceA->CalcBoundingBox(), guestList);
+
+				for (BoundingBoxTree::Guest* guest : guestList)
 				{
-					CollisionPair pair(faceA, faceB);
-					collisionPairQueue.push_back(pair);
+					Face* faceB = (Face*)guest;
+					if (faceB->family == Face::FAMILY_B)
+						slotPairListArray[faceA->GetSetIndex()].push_back(CollisionPair(faceA, faceB));
 				}
 			}
-		}
-	}
+			return false;
+		});
+	});
+
+	std::list<CollisionPair> collisionPairQueue;
+	for (std::list<CollisionPair>& slotPairList : slotPairListArray)
+		collisionPairQueue.splice(collisionPairQueue.end(), slotPairList);
+
+	if (!this->ReportProgress(PHASE_SETUP, 1.0))
+		return false;
+
+	if (collisionPairQueue.size() == 0)
+		return this->CalculateWithoutCutting(meshA, meshB, true, outputMeshArray);
 
 	//
 	// Process the collision pair queue, cutting polygons up, until it's empty.
 	// Proper termination of this algorithm depends on the correctness of the cutting algorithm.
 	//
 
+	int processedPairCount = 0;
 	while (collisionPairQueue.size() > 0)
 	{
+		// The queue grows as faces get split, so this is only a rough estimate of how far along we are.
+		if ((processedPairCount++ % MW_PROGRESS_CHECK_INTERVAL) == 0)
+			if (!this->ReportProgress(PHASE_CUTTING, double(processedPairCount) / double(processedPairCount + collisionPairQueue.size())))
+				return false;
+
 		std::list<CollisionPair>::iterator iter = collisionPairQueue.begin();
 		CollisionPair pair = *iter;
 		collisionPairQueue.erase(iter);
 
-		std::set<Face*> newFaceSetA, newFaceSetB;
-		this->ProcessCollisionPair(pair, newFaceSetA, newFaceSetB);
+		std::vector<Face*> newFaceArrayA, newFaceArrayB;
+		this->ProcessCollisionPair(pair, newFaceArrayA, newFaceArrayB);
 
-		if (newFaceSetA.size() > 0)
+		if (this->statistics)
 		{
-			this->faceSet->erase(pair.faceA);
-			for (Face* face : newFaceSetA)
-				this->faceSet->insert(face);
+			this->statistics->collisionPairCount++;
+			this->statistics->splitCount += (newFaceArrayA.size() > 0 ? 1 : 0) + (newFaceArrayB.size() > 0 ? 1 : 0);
+			this->statistics->splitFaceCount += newFaceArrayA.size() + newFaceArrayB.size();
 		}
 
-		if (newFaceSetB.size() > 0)
+		if (newFaceArrayA.size() > 0)
 		{
-			this->faceSet->erase(pair.faceB);
-			for (Face* face : newFaceSetB)
-				this->faceSet->insert(face);
+			this->faceSet->Remove(pair.faceA);
+			for (Face* face : newFaceArrayA)
+				this->faceSet->Add(face);
 		}
 
-		if (newFaceSetA.size() > 0 || newFaceSetB.size() > 0)
+		if (newFaceArrayB.size() > 0)
 		{
-			std::set<Face*> oldFaceSetA, oldFaceSetB;
+			this->faceSet->Remove(pair.faceB);
+			for (Face* face : newFaceArrayB)
+				this->faceSet->Add(face);
+		}
+
+		if (newFaceArrayA.size() > 0 || newFaceArrayB.size() > 0)
+		{
+			// Each face can only pair with a given face once, so there are no duplicates to worry about here.
+			std::vector<Face*> oldFaceArrayA, oldFaceArrayB;
 
 			iter = collisionPairQueue.begin();
 			while (iter != collisionPairQueue.end())
@@ -185,89 +273,91 @@ MeshSetOperation::MeshSetOperation(int flags)
 				CollisionPair& existingPair = *iter;
 				MW_ASSERT(!(existingPair.faceA == pair.faceA && existingPair.faceB == pair.faceB));
 
-				if (newFaceSetA.size() > 0 && existingPair.faceA == pair.faceA)
+				if (newFaceArrayA.size() > 0 && existingPair.faceA == pair.faceA)
 				{
-					oldFaceSetB.insert(existingPair.faceB);
+					oldFaceArrayB.push_back(existingPair.faceB);
 					collisionPairQueue.erase(iter);
 				}
-
-				if (newFaceSetB.size() > 0 && existingPair.faceB == pair.faceB)
+				else if (newFaceArrayB.size() > 0 && existingPair.faceB == pair.faceB)
 				{
-					oldFaceSetA.insert(existingPair.faceA);
+					oldFaceArrayA.push_back(existingPair.faceA);
 					collisionPairQueue.erase(iter);
 				}
 
 				iter = nextIter;
 			}
 
-			if (newFaceSetA.size() > 0)
+			if (newFaceArrayA.size() > 0)
 			{
 				this->faceHeap->Deallocate(pair.faceA);
-				for (Face* faceA : newFaceSetA)
-					for (Face* faceB : oldFaceSetB)
+				for (Face* faceA : newFaceArrayA)
+					for (Face* faceB : oldFaceArrayB)
 						collisionPairQueue.push_back(CollisionPair(faceA, faceB));
 			}
 
-			if (newFaceSetB.size() > 0)
+			if (newFaceArrayB.size() > 0)
 			{
 				this->faceHeap->Deallocate(pair.faceB);
-				for (Face* faceB : newFaceSetB)
-					for (Face* faceA : oldFaceSetA)
+				for (Face* faceB : newFaceArrayB)
+					for (Face* faceA : oldFaceArrayA)
 						collisionPairQueue.push_back(CollisionPair(faceA, faceB));
 			}
 		}
 	}
 
+	// Squeeze out the tombstones left behind by all the splitting.
+	this->faceSet->Compact();
+
+	if (!this->ReportProgress(PHASE_CUTTING, 1.0))
+		return false;
+
+	// Faces may have been close without actually crossing, in which case nothing was cut.
+	if (this->cutBoundarySegmentArray->size() == 0)
+		return this->CalculateWithoutCutting(meshA, meshB, true, outputMeshArray);
+
 	//
-	// Note that at this point, there does not have to be any cutting that
-	// was performed, and therefore, any cut boundary generated.  In the
-	// absense of any cutting, we can still generate a meaningful result.
-	// That said, any cut boundaries generated should be line-loops, so let's
-	// verify that now.
+	// Build the refined meshes straight from the indexed faces.  There's no welding to be done here,
+	// because any two faces meeting at a vertex already refer to it by the same index.
 	//
-	
-	// TODO: There is a problem here where the cut-boundaries are not coming together
-	//       and forming line-loops.  In theory, I believe that if the cutting process
-	//       is done correctly (and that by itself is very hard to do), then they
-	//       should form line-loops.  That said, this whole approach might not be very
-	//       good (e.g., not very numerically stable), because we're making the boundary
-	//       detection process dependant on the cutting process.  Rather, the cutting
-	//       process should probably be dependant upon an algorithm that performs the
-	//       boundary detection.  In any case, I wish there was an easy way to visualize
-	//       the cut-boundary being generated.  3DS Max won't do polylines in OBJ format,
-	//       but maybe I can just spit out a bunch of degenerate triangles; it seems to
-	//       draw those as line segments.
 
-	Polyline::GeneratePolylines(*this->cutBoundarySegmentArray, *this->cutBoundaryPolylineArray);
+	for (const Mesh::Vertex& vertex : *this->cutMeshA->vertexArray)
+		this->refinedMeshA.AddVertex(vertex);
 
-	/*for (Polyline* polyline : *this->cutBoundaryPolylineArray)
-	{
-		if (!polyline->IsLineLoop(1e-3))
-		{
-			*this->error = "Generated cut boundary did not form a line-loop.";
-			return false;
-		}
-	}*/
+	for (const Mesh::Vertex& vertex : *this->cutMeshB->vertexArray)
+		this->refinedMeshB.AddVertex(vertex);
 
-	// 
-	// Bucket sort the chopped-up polygons into their respective meshes.
-	//
+	this->faceSet->ForAll([this](Face* face) -> bool {
+		MW_ASSERT(face->family == Face::FAMILY_A || face->family == Face::FAMILY_B);
+
+		Mesh::Face meshFace;
+		meshFace.vertexArray = face->vertexArray;
+
+		if (face->family == Face::FAMILY_A)
+			this->refinedMeshA.AddFace(meshFace);
+		else if (face->family == Face::FAMILY_B)
+			this->refinedMeshB.AddFace(meshFace);
+
+		return false;
+	});
 
-	polygonArrayA.clear();
-	polygonArrayB.clear();
+	// The far faces may have picked up vertices along edges shared with cut faces, so we only copy them now.
+	// They go into the refined meshes too, but not until after the graphs are made, as they don't need coloring.
+	std::vector<Mesh::Face> farMeshFaceArrayA, farMeshFaceArrayB;
 
-	for (Face* face : *this->faceSet)
+	for (const Face* face : *this->farFaceArray)
 	{
-		MW_ASSERT(face->family == Face::FAMILY_A || face->family == Face::FAMILY_B);
+		Mesh::Face meshFace;
+		meshFace.vertexArray = face->vertexArray;
 
 		if (face->family == Face::FAMILY_A)
-			polygonArrayA.push_back(face->polygon);
+			farMeshFaceArrayA.push_back(meshFace);
 		else if (face->family == Face::FAMILY_B)
-			polygonArrayB.push_back(face->polygon);
+			farMeshFaceArrayB.push_back(meshFace);
 	}
 
-	this->refinedMeshA.FromPolygonArray(polygonArrayA);
-	this->refinedMeshB.FromPolygonArray(polygonArrayB);
+	// We're done with the faces now, so give all their memory back in one go.
+	this->RecordPeakAllocation();
+	this->FreeFaces();
 
 #if MW_DEBUG_DUMP_REFINED_MESHES
 	*refinedMeshA.name = "refined_mesh_A";
@@ -280,6 +370,8 @@ MeshSetOperation::MeshSetOperation(int flags)
 	fileObjectArray.push_back(&refinedMeshB);
 
 #if MW_DEBUG_DUMP_CUT_BOUNDARY
+	// The cut boundary is only stitched into polylines for looking at.
+	Polyline::GeneratePolylines(*this->cutBoundarySegmentArray, *this->cutBoundaryPolylineArray);
 	for (Polyline* polyline : *this->cutBoundaryPolylineArray)
 		fileObjectArray.push_back(polyline);
 #endif //MW_DEBUG_DUMP_CUT_BOUNDARY
@@ -289,13 +381,34 @@ MeshSetOperation::MeshSetOperation(int flags)
 
 	//
 	// Now generate a graph for each refined mesh.  This makes it easier for
-	// us to traverse over the surface of each refined mesh.  Also, use a
-	// polyline for the cut boundary since it's easier to work with.
+	// us to traverse over the surface of each refined mesh.
 	//
 
+	if (!this->ReportProgress(PHASE_GRAPH_BUILD, 0.0))
+		return false;
+
 	this->graphA->Generate(&this->refinedMeshA);
+
+	if (!this->ReportProgress(PHASE_GRAPH_BUILD, 0.5))
+		return false;
+
 	this->graphB->Generate(&this->refinedMeshB);
 
+	if (this->statistics)
+	{
+		for (Graph* graph : { this->graphA, this->graphB })
+		{
+			graph->ForAllElements([this](MeshGraph::GraphElement* element) -> bool {
+				if (dynamic_cast<Graph::Edge*>(element))
+					this->statistics->graphEdgeCount++;
+				return false;
+			});
+		}
+	}
+
+	if (!this->ReportProgress(PHASE_GRAPH_BUILD, 1.0))
+		return false;
+
 	//
 	// Gather the nodes from both graphs into one list.
 	//
@@ -318,117 +431,270 @@ MeshSetOperation::MeshSetOperation(int flags)
 
 	//
 	// Finally, color the graphs.  That is, in each graph, determine which faces are
-	// inside and which are oustide.  The trickiest part is determining the side for
-	// an initial face.  Once known, a BFS can be used to walk the graph.  Adjacent
-	// faces inherit the side of the face from which they came, unless a cut-boundary
-	// is crossed, in which case, we flip from outside to in, or vice-versa.
+	// inside and which are oustide.  A face none of whose edges touch the other mesh's
+	// surface can't cross that surface, so it is on the same side as any such neighbor.
+	// We therefore color a root face by asking the other mesh's volume, then BFS outward
+	// from it through faces that stay clear of the other surface.  Faces that do touch
+	// it (which ideally were cut exactly along it, but may not have been) are each asked
+	// about individually and never pass their side along.  Whatever is left over gets a
+	// root of its own, and so on.  (We used to flip sides across the cut boundary instead,
+	// but the cut boundary is only known approximately, and a single place where it went
+	// undetected would spoil the whole graph.)
 	//
 
-	if (!this->ColorGraph(this->graphA, nodeList) || !this->ColorGraph(this->graphB, nodeList))
+	const MeshVolume* volumeA = this->GenerateVolume(Face::FAMILY_A, meshA);
+	const MeshVolume* volumeB = this->GenerateVolume(Face::FAMILY_B, meshB);
+
+	if (!this->ColorGraph(this->graphA, nodeList, volumeB) || !this->ColorGraph(this->graphB, nodeList, volumeA))
 	{
-		*this->error = "Failed to color graph.";
+		if (!this->IsCancelled())
+			*this->error = "Failed to color graph.";
 		return false;
 	}
+
+	if (!this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 0.0))
+		return false;
 	
 	//
-	// Bucket sort the polygons by color (side).  Reverse-wind any inside polygons while we're at it.
+	// Bucket sort the faces by color (side).  Far faces are all outside.
 	//
 
-	std::vector<Mesh::ConvexPolygon> outsidePolygonArrayA, outsidePolygonArrayB;
-	std::vector<Mesh::ConvexPolygon> insidePolygonArrayA, insidePolygonArrayB;
+	std::vector<SortedFaces> sortedFacesArrayA(1), sortedFacesArrayB(1);
+	sortedFacesArrayA[0].mesh = &this->refinedMeshA;
+	sortedFacesArrayB[0].mesh = &this->refinedMeshB;
 
-	this->graphA->ForAllElements([&outsidePolygonArrayA, &insidePolygonArrayA](MeshGraph::GraphElement* element) -> bool {
-		Graph::Node* node = dynamic_cast<Graph::Node*>(element);
-		if (node)
-		{
-			if (node->side == Graph::Node::OUTSIDE)
-				outsidePolygonArrayA.push_back(node->MakePolygon());
-			else if (node->side == Graph::Node::INSIDE)
-				insidePolygonArrayA.push_back(node->MakePolygon().ReverseWinding());
-		}
-		return false;
-	});
+	for (const Mesh::Face& meshFace : farMeshFaceArrayA)
+	{
+		sortedFacesArrayA[0].outsideFaceArray.push_back(this->refinedMeshA.GetNumFaces());
+		this->refinedMeshA.AddFace(meshFace);
+	}
 
-	this->graphB->ForAllElements([&outsidePolygonArrayB, &insidePolygonArrayB](MeshGraph::GraphElement* element) -> bool {
-		Graph::Node* node = dynamic_cast<Graph::Node*>(element);
-		if (node)
-		{
-			if (node->side == Graph::Node::OUTSIDE)
-				outsidePolygonArrayB.push_back(node->MakePolygon());
-			else if (node->side == Graph::Node::INSIDE)
-				insidePolygonArrayB.push_back(node->MakePolygon().ReverseWinding());
-		}
-		return false;
-	});
+	for (const Mesh::Face& meshFace : farMeshFaceArrayB)
+	{
+		sortedFacesArrayB[0].outsideFaceArray.push_back(this->refinedMeshB.GetNumFaces());
+		this->refinedMeshB.AddFace(meshFace);
+	}
+
+	Graph* graphArray[2] = { this->graphA, this->graphB };
+	SortedFaces* sortedFacesArray[2] = { &sortedFacesArrayA[0], &sortedFacesArrayB[0] };
+	for (int i = 0; i < 2; i++)
+	{
+		SortedFaces* sortedFaces = sortedFacesArray[i];
+		graphArray[i]->ForAllElements([sortedFaces](MeshGraph::GraphElement* element) -> bool {
+			Graph::Node* node = dynamic_cast<Graph::Node*>(element);
+			if (node)
+			{
+				if (node->side == Graph::Node::OUTSIDE)
+					sortedFaces->outsideFaceArray.push_back(node->polygon);
+				else if (node->side == Graph::Node::INSIDE)
+					sortedFaces->insideFaceArray.push_back(node->polygon);
+			}
+			return false;
+		});
+	}
 
 	//
 	// Lastly, form the results called-for by the given flags.
 	//
 
-	outputMeshArray.clear();
+	this->AssembleOutput(sortedFacesArrayA, sortedFacesArrayB, outputMeshArray);
 
-	if ((this->flags & MW_FLAG_UNION_SET_OP) != 0)
+	this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 1.0);
+
+	return true;
+}
+
+// Each result is made of faces picked out of the sorted faces by index, so there's no welding to do, except
+// where faces from different meshes meet along the cut.  The results don't depend on one another, so they go wide.
+/*virtual*/ void MeshSetOperation::AssembleOutput(const std::vector<SortedFaces>& sortedFacesArrayA, const std::vector<SortedFaces>& sortedFacesArrayB, std::vector<Mesh*>& outputMeshArray)
+{
+	// A face inside the other mesh bounds a difference from the other side, so it gets reverse-wound.
+	// The intersection, on the other hand, is bounded by the inside faces just as they are.
+	struct Output
 	{
-		Mesh* mesh = new Mesh();
-		*mesh->name = "union";
-		for (Mesh::ConvexPolygon& polygon : outsidePolygonArrayA)
-			mesh->AddFace(polygon);
-		for (Mesh::ConvexPolygon& polygon : outsidePolygonArrayB)
-			mesh->AddFace(polygon);
-		outputMeshArray.push_back(mesh);
-	}
+		int flag;
+		const char* name;
+		bool insideA;
+		bool insideB;
+		bool reverseInside;
+	};
+
+	static const Output outputArray[] =
+	{
+		{ MW_FLAG_UNION_SET_OP, "union", false, false, false },
+		{ MW_FLAG_INTERSECTION_SETP_OP, "intersection", true, true, false },
+		{ MW_FLAG_A_MINUS_B_SET_OP, "a_minus_b", false, true, true },
+		{ MW_FLAG_B_MINUS_A_SET_OP, "b_minus_a", true, false, true }
+	};
+
+	std::vector<const Output*> requestedOutputArray;
+	for (const Output& output : outputArray)
+		if ((this->flags & output.flag) != 0)
+			requestedOutputArray.push_back(&output);
+
+	bool matchAttributes = (this->flags & MW_FLAG_SPLIT_ATTRIBUTES_SET_OP) != 0;
+
+	outputMeshArray.clear();
+	outputMeshArray.resize(requestedOutputArray.size());
+
+	this->ParallelFor(0, (int)requestedOutputArray.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			const Output* output = requestedOutputArray[i];
+
+			Mesh* mesh = new Mesh();
+			*mesh->name = output->name;
+
+			OutputBuilder outputBuilder(mesh, matchAttributes);
+
+			for (const SortedFaces& sortedFaces : sortedFacesArrayA)
+			{
+				if (output->insideA)
+					outputBuilder.AddFaces(sortedFaces.mesh, sortedFaces.insideFaceArray, output->reverseInside);
+				else
+					outputBuilder.AddFaces(sortedFaces.mesh, sortedFaces.outsideFaceArray, false);
+			}
+
+			for (const SortedFaces& sortedFaces : sortedFacesArrayB)
+			{
+				if (output->insideB)
+					outputBuilder.AddFaces(sortedFaces.mesh, sortedFaces.insideFaceArray, output->reverseInside);
+				else
+					outputBuilder.AddFaces(sortedFaces.mesh, sortedFaces.outsideFaceArray, false);
+			}
+
+			if (!matchAttributes)
+				outputBuilder.StitchSeams();
+
+			outputMeshArray[i] = mesh;
+		}
+	}, 1);
+
+	if (this->statistics)
+		for (const Mesh* mesh : outputMeshArray)
+			this->statistics->outputFaceCount += mesh->GetNumFaces();
+}
+
+// When the surfaces of the two meshes don't cross, each mesh is either entirely inside or entirely
+// outside of the other, and the results can be put together straight from the given meshes.
+// A handful of point-in-mesh queries take the place of cutting, graph building and coloring.
+bool MeshSetOperation::CalculateWithoutCutting(const Mesh* meshA, const Mesh* meshB, bool boxesOverlap, std::vector<Mesh*>& outputMeshArray)
+{
+	this->RecordPeakAllocation();
+	this->FreeFaces();
+
+	if (!this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 0.0))
+		return false;
+
+	bool insideA = false, insideB = false;
 
-	if ((this->flags & MW_FLAG_INTERSECTION_SETP_OP) != 0)
+	if (boxesOverlap)
 	{
-		Mesh* mesh = new Mesh();
-		*mesh->name = "intersection";
-		for (Mesh::ConvexPolygon& polygon : insidePolygonArrayA)
-			mesh->AddFace(polygon);
-		for (Mesh::ConvexPolygon& polygon : insidePolygonArrayB)
-			mesh->AddFace(polygon);
-		outputMeshArray.push_back(mesh);
+		insideA = this->SampleIsInside(meshA, *this->GenerateVolume(Face::FAMILY_B, meshB));
+		if (!insideA)
+			insideB = this->SampleIsInside(meshB, *this->GenerateVolume(Face::FAMILY_A, meshA));
 	}
 
-	if ((this->flags & MW_FLAG_A_MINUS_B_SET_OP) != 0)
+	std::vector<SortedFaces> sortedFacesArrayA(1), sortedFacesArrayB(1);
+	sortedFacesArrayA[0].mesh = meshA;
+	sortedFacesArrayB[0].mesh = meshB;
+
+	std::vector<int>& faceArrayA = insideA ? sortedFacesArrayA[0].insideFaceArray : sortedFacesArrayA[0].outsideFaceArray;
+	for (int i = 0; i < meshA->GetNumFaces(); i++)
+		faceArrayA.push_back(i);
+
+	std::vector<int>& faceArrayB = insideB ? sortedFacesArrayB[0].insideFaceArray : sortedFacesArrayB[0].outsideFaceArray;
+	for (int i = 0; i < meshB->GetNumFaces(); i++)
+		faceArrayB.push_back(i);
+
+	this->AssembleOutput(sortedFacesArrayA, sortedFacesArrayB, outputMeshArray);
+
+	this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 1.0);
+
+	return true;
+}
+
+// The faces and vertices made by cutting are all still around when this is called, so this is as big as things got.
+void MeshSetOperation::RecordPeakAllocation()
+{
+	if (!this->statistics)
+		return;
+
+	size_t bytes = this->faceHeap->GetPeakBytes();
+	bytes += (this->cutMeshA->vertexArray->size() + this->cutMeshB->vertexArray->size()) * sizeof(Mesh::Vertex);
+	bytes += (this->cutMeshA->planeArray->size() + this->cutMeshB->planeArray->size()) * sizeof(Plane);
+
+	this->statistics->peakAllocation = MW_MAX(this->statistics->peakAllocation, int64_t(bytes));
+}
+
+// Make the volume of the given input mesh, so that we can tell what's inside of it.
+/*virtual*/ const MeshVolume* MeshSetOperation::GenerateVolume(Face::Family family, const Mesh* mesh)
+{
+	MeshVolume* volume = (family == Face::FAMILY_A) ? this->volumeA : this->volumeB;
+	volume->Generate(mesh);
+	return volume;
+}
+
+/*virtual*/ AxisAlignedBox MeshSetOperation::CalcMeshBox(Face::Family /*family*/, const Mesh* mesh)
+{
+	return mesh->CalcBoundingBox();
+}
+
+// Take a vote among a few of the faces of the given mesh as to whether they're inside the given volume.
+// One vote isn't enough, because a face can touch the other surface without crossing it.
+bool MeshSetOperation::SampleIsInside(const Mesh* mesh, const MeshVolume& volume)
+{
+	int faceCount = mesh->GetNumFaces();
+	int sampleCount = MW_MIN(faceCount, MW_SET_OP_CLASSIFICATION_SAMPLES);
+	int insideCount = 0;
+
+	for (int i = 0; i < sampleCount; i++)
 	{
-		Mesh* mesh = new Mesh();
-		*mesh->name = "a_minus_b";
-		for (Mesh::ConvexPolygon& polygon : outsidePolygonArrayA)
-			mesh->AddFace(polygon);
-		for (Mesh::ConvexPolygon& polygon : insidePolygonArrayB)
-			mesh->AddFace(polygon);
-		outputMeshArray.push_back(mesh);
+		ConvexPolygon polygon;
+		mesh->GetFace((i * faceCount) / sampleCount)->GeneratePolygon(mesh).ToBasicPolygon(polygon);
+		if (volume.ContainsPoint(polygon.CalcCenter(), this->statistics ? &this->statistics->rayCastCount : nullptr))
+			insideCount++;
 	}
 
-	if ((this->flags & MW_FLAG_B_MINUS_A_SET_OP) != 0)
+	return 2 * insideCount > sampleCount;
+}
+
+// Make a face for each face of the given mesh, sorting them into those near the action and those far from it.
+void MeshSetOperation::AddFaces(const Mesh* mesh, Face::Family family, CutMesh* cutMesh, const AxisAlignedBox& overlapBox)
+{
+	cutMesh->Populate(mesh);
+
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
 	{
-		Mesh* mesh = new Mesh();
-		*mesh->name = "b_minus_a";
-		for (Mesh::ConvexPolygon& polygon : outsidePolygonArrayB)
-			mesh->AddFace(polygon);
-		for (Mesh::ConvexPolygon& polygon : insidePolygonArrayA)
-			mesh->AddFace(polygon);
-		outputMeshArray.push_back(mesh);
+		Face* face = this->faceHeap->Allocate();
+		face->family = family;
+		face->vertexArray = mesh->GetFace(i)->vertexArray;
+		face->planeIndex = i;
+		cutMesh->CalcFaceBox(face);
+		cutMesh->AddFace(face);
+
+		if (overlapBox.OverlapsWith(face->box))
+			this->faceSet->Add(face);
+		else
+			this->farFaceArray->push_back(face);
 	}
-
-	return true;
 }
 
-void MeshSetOperation::ProcessCollisionPair(const CollisionPair& pair, std::set<Face*>& newFaceSetA, std::set<Face*>& newFaceSetB)
+void MeshSetOperation::ProcessCollisionPair(const CollisionPair& pair, std::vector<Face*>& newFaceArrayA, std::vector<Face*>& newFaceArrayB)
 {
-	newFaceSetA.clear();
-	newFaceSetB.clear();
+	newFaceArrayA.clear();
+	newFaceArrayB.clear();
 
 	ConvexPolygon polygonA, polygonB;
-	pair.faceA->polygon.ToBasicPolygon(polygonA);
-	pair.faceB->polygon.ToBasicPolygon(polygonB);
+	this->cutMeshA->MakeBasicPolygon(pair.faceA, polygonA);
+	this->cutMeshB->MakeBasicPolygon(pair.faceB, polygonB);
 
 #if MW_DEBUG_DUMP_CUT_CASE
 	Mesh originalA, originalB, splitA, splitB;
 	*originalA.name = "original_A";
 	*originalB.name = "original_B";
-	originalA.AddFace(pair.faceA->polygon);
-	originalB.AddFace(pair.faceB->polygon);
+	originalA.AddFace(this->cutMeshA->MakePolygon(pair.faceA));
+	originalB.AddFace(this->cutMeshB->MakePolygon(pair.faceB));
 	*splitA.name = "split_A";
 	*splitB.name = "split_B";
 #endif //MW_DEBUG_DUMP_CUT_CASE
@@ -437,52 +703,27 @@ void MeshSetOperation::ProcessCollisionPair(const CollisionPair& pair, std::set<
 	Shape* shape = polygonA.IntersectWith(&polygonB);
 	if (shape)
 	{
-		Plane planeA, planeB;
-		polygonA.CalcPlane(planeA);
-		polygonB.CalcPlane(planeB);
+		const Plane& planeA = (*this->cutMeshA->planeArray)[pair.faceA->planeIndex];
+		const Plane& planeB = (*this->cutMeshB->planeArray)[pair.faceB->planeIndex];
 
-		std::vector<ConvexPolygon> polygonArrayA, polygonArrayB;
-		polygonA.SplitAgainstPlane(planeB, polygonArrayA);
-		polygonB.SplitAgainstPlane(planeA, polygonArrayB);
+		bool cutA = this->SplitFace(this->cutMeshA, pair.faceA, planeB, newFaceArrayA);
+		bool cutB = this->SplitFace(this->cutMeshB, pair.faceB, planeA, newFaceArrayB);
 
-		if (polygonArrayA.size() < 2 && polygonArrayB.size() < 2)
+		if (!cutA && !cutB)
 			delete shape;
 		else
 		{
-			// Store the intersection for later use.  We'll need it when coloring the graph.
+			// Store the intersection for later use.
 			LineSegment* lineSegment = dynamic_cast<LineSegment*>(shape);
 			MW_ASSERT(lineSegment);
 			this->cutBoundarySegmentArray->push_back(lineSegment);
 
-			if (polygonArrayA.size() > 1)
-			{
-				for (ConvexPolygon& newPolygonA : polygonArrayA)
-				{
-					Face* face = this->faceHeap->Allocate();
-					face->family = Face::FAMILY_A;
-					face->polygon.FromBasicPolygon(newPolygonA);
-					newFaceSetA.insert(face);
-
-#if MW_DEBUG_DUMP_CUT_CASE
-					splitA.AddFace(face->polygon);
-#endif //MW_DEBUG_DUMP_CUT_CASE
-				}
-			}
-
-			if (polygonArrayB.size() > 1)
-			{
-				for (ConvexPolygon& newPolygonB : polygonArrayB)
-				{
-					Face* face = this->faceHeap->Allocate();
-					face->family = Face::FAMILY_B;
-					face->polygon.FromBasicPolygon(newPolygonB);
-					newFaceSetB.insert(face);
-
 #if MW_DEBUG_DUMP_CUT_CASE
-					splitB.AddFace(face->polygon);
+			for (Face* face : newFaceArrayA)
+				splitA.AddFace(this->cutMeshA->MakePolygon(face));
+			for (Face* face : newFaceArrayB)
+				splitB.AddFace(this->cutMeshB->MakePolygon(face));
 #endif //MW_DEBUG_DUMP_CUT_CASE
-				}
-			}
 		}
 	}
 
@@ -497,7 +738,110 @@ void MeshSetOperation::ProcessCollisionPair(const CollisionPair& pair, std::set<
 #endif //MW_DEBUG_DUMP_CUT_CASE
 }
 
-bool MeshSetOperation::ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeList)
+// If the given face really crosses the given plane, cut it in two there, and replace it with its two halves in the cut mesh.
+// The given face is left for the caller to dispose of.  Each vertex is put on one side of the plane or the other (or on it)
+// exactly, and new vertices are only made on edges whose ends are strictly on opposite sides, so a neighbor sharing such an
+// edge would make the very same vertex if cut by the same plane.  Rather than wait for that, we give it the vertex right away.
+bool MeshSetOperation::SplitFace(CutMesh* cutMesh, Face* face, const Plane& plane, std::vector<Face*>& newFaceArray)
+{
+	int vertexCount = (int)face->vertexArray.size();
+
+	std::vector<int> sideArray(vertexCount);
+	Predicates::PlaneSideArray(plane, &(*cutMesh->vertexArray)[0].point.x, MW_VERTEX_STRIDE, &face->vertexArray[0], vertexCount, &sideArray[0]);
+
+	bool anyFront = false, anyBack = false;
+	for (int i = 0; i < vertexCount; i++)
+	{
+		anyFront |= (sideArray[i] > 0);
+		anyBack |= (sideArray[i] < 0);
+	}
+
+	if (!(anyFront && anyBack))
+		return false;
+
+	// New vertices don't go into the cut mesh until we know we're keeping the split,
+	// so in the meantime, we refer to them with negative indices.
+	std::vector<Mesh::Vertex> newVertexArray;
+	std::vector<int> newVertexEdgeArray;
+	std::vector<int> frontIndexArray, backIndexArray;
+	ConvexPolygon polygonFront, polygonBack;
+
+	for (int i = 0; i < vertexCount; i++)
+	{
+		int j = (i + 1) % vertexCount;
+		const Mesh::Vertex& vertexA = (*cutMesh->vertexArray)[face->vertexArray[i]];
+		const Mesh::Vertex& vertexB = (*cutMesh->vertexArray)[face->vertexArray[j]];
+
+		if (sideArray[i] >= 0)
+		{
+			frontIndexArray.push_back(face->vertexArray[i]);
+			polygonFront.vertexArray->push_back(vertexA.point);
+		}
+
+		if (sideArray[i] <= 0)
+		{
+			backIndexArray.push_back(face->vertexArray[i]);
+			polygonBack.vertexArray->push_back(vertexA.point);
+		}
+
+		if (sideArray[i] * sideArray[j] < 0)
+		{
+			double lambda = 0.0;
+			Vector point = ConvexPolygon::CalcPlaneCrossing(plane, vertexA.point, vertexB.point, &lambda);
+
+			Mesh::Vertex vertex;
+			if ((this->flags & MW_FLAG_SKIP_ATTRIBUTES_SET_OP) == 0)
+				vertex = Mesh::Vertex::Lerp(vertexA, vertexB, lambda);
+			vertex.point = point;
+
+			newVertexArray.push_back(vertex);
+			newVertexEdgeArray.push_back(i);
+
+			int k = -(int)newVertexArray.size();
+			frontIndexArray.push_back(k);
+			backIndexArray.push_back(k);
+			polygonFront.vertexArray->push_back(vertex.point);
+			polygonBack.vertexArray->push_back(vertex.point);
+		}
+	}
+
+	if (polygonFront.IsDegenerate() || polygonBack.IsDegenerate())
+		return false;
+
+	cutMesh->RemoveFace(face);
+
+	std::vector<int> newVertexIndexArray;
+	for (int i = 0; i < (int)newVertexArray.size(); i++)
+	{
+		int k = (int)cutMesh->vertexArray->size();
+		cutMesh->vertexArray->push_back(newVertexArray[i]);
+		newVertexIndexArray.push_back(k);
+
+		// The neighbor, if any, has this edge going the other way.
+		int j = newVertexEdgeArray[i];
+		cutMesh->InsertEdgeVertex(face->vertexArray[(j + 1) % vertexCount], face->vertexArray[j], k);
+	}
+
+	std::vector<int>* indexArrays[2] = { &frontIndexArray, &backIndexArray };
+	for (std::vector<int>* indexArray : indexArrays)
+	{
+		Face* newFace = this->faceHeap->Allocate();
+		newFace->family = face->family;
+		newFace->planeIndex = face->planeIndex;
+		newFace->vertexArray = *indexArray;
+		for (int& i : newFace->vertexArray)
+			if (i < 0)
+				i = newVertexIndexArray[-i - 1];
+
+		cutMesh->CalcFaceBox(newFace);
+		cutMesh->AddFace(newFace);
+		newFaceArray.push_back(newFace);
+	}
+
+	return true;
+}
+
+bool MeshSetOperation::ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeList, const MeshVolume* otherVolume)
 {
 #if MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES
 	Mesh outsideMesh, insideMesh;
@@ -505,22 +849,60 @@ bool MeshSetOperation::ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeLis
 	*insideMesh.name = "inside_mesh";
 #endif //MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES
 
+	int coloredCount = (graph == this->graphA) ? 0 : this->refinedMeshA.GetNumFaces();
+
+	std::vector<Graph::Node*> graphNodeArray;
+	for (Graph::Node* node : nodeList)
+		if (node->meshGraph == graph)
+			graphNodeArray.push_back(node);
+
+	this->ParallelFor(0, (int)graphNodeArray.size(), [&graphNodeArray, otherVolume](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			Graph::Node* node = graphNodeArray[i];
+			ConvexPolygon polygon;
+			node->MakePolygon().ToBasicPolygon(polygon);
+			int vertexCount = (int)polygon.vertexArray->size();
+			for (int j = 0; j < vertexCount && !node->touchesOtherSurface; j++)
+				if (otherVolume->TouchesLineSegment((*polygon.vertexArray)[j], (*polygon.vertexArray)[(j + 1) % vertexCount]))
+					node->touchesOtherSurface = true;
+		}
+	});
+
+	if (this->IsCancelled())
+		return false;
+
+	// The nodes touching the other surface each need a root of their own, since they never pass their side
+	// along, so put them first.  The rest only need one per region.  Sides only ever go from unknown to known,
+	// so a cursor that never backs up finds every root in one pass over the nodes, however many there are.
+	std::stable_partition(graphNodeArray.begin(), graphNodeArray.end(), [](const Graph::Node* node) -> bool {
+		return node->touchesOtherSurface;
+	});
+
+	int cursor = 0;
+	std::vector<Graph::Node*> nodeQueue;
+
 	while (true)
 	{
-		Graph::Node* rootNode = this->FindRootNodeForColoring(graph->GetTargetMesh(), nodeList);
+		Graph::Node* rootNode = this->FindRootNodeForColoring(graphNodeArray, cursor, otherVolume);
 		if (!rootNode)
 			break;
 
+		if (!this->ReportProgress(PHASE_COLORING, double(coloredCount) / double(nodeList.size())))
+			return false;
+
 		MW_ASSERT(rootNode->side != Graph::Node::UNKNOWN);
 
-		std::list<Graph::Node*> nodeQueue;
+		nodeQueue.clear();
 		nodeQueue.push_back(rootNode);
 
-		while (nodeQueue.size() > 0)
+		for (int j = 0; j < (int)nodeQueue.size(); j++)
 		{
-			std::list<Graph::Node*>::iterator iter = nodeQueue.begin();
-			Graph::Node* node = *iter;
-			nodeQueue.erase(iter);
+			Graph::Node* node = nodeQueue[j];
+
+			if ((coloredCount++ % MW_PROGRESS_CHECK_INTERVAL) == 0)
+				if (!this->ReportProgress(PHASE_COLORING, double(coloredCount) / double(nodeList.size())))
+					return false;
 
 #if MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES
 			Mesh::ConvexPolygon polygon = node->MakePolygon();
@@ -530,11 +912,14 @@ bool MeshSetOperation::ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeLis
 				outsideMesh.AddFace(polygon);
 #endif //MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES
 
+			if (node->touchesOtherSurface)
+				continue;
+
 			for (int i = 0; i < (int)node->edgeArray.size(); i++)
 			{
 				Graph::Edge* edge = node->edgeArray[i];
 				Graph::Node* adjacentNode = (Graph::Node*)edge->GetOtherAdjacency(node);
-				if (adjacentNode->side == Graph::Node::UNKNOWN)
+				if (adjacentNode->side == Graph::Node::UNKNOWN && !adjacentNode->touchesOtherSurface)
 				{
 #if MW_DEBUG_TRAP_GRAPH_COLORING
 					ConvexPolygon debugPolygon;
@@ -548,15 +933,7 @@ bool MeshSetOperation::ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeLis
 					}
 #endif //MW_DEBUG_TRAP_GRAPH_COLORING
 
-					Vector edgePointA = edge->GetVertex(0)->point;
-					Vector edgePointB = edge->GetVertex(1)->point;
-					Vector edgeMidPoint = (edgePointA + edgePointB) / 2.0;
-					bool onCutBoundary = this->PointIsOnCutBoundary(edgeMidPoint);
-					if (onCutBoundary)
-						adjacentNode->side = node->OppositeSide();
-					else
-						adjacentNode->side = node->side;
-
+					adjacentNode->side = node->side;
 					nodeQueue.push_back(adjacentNode);
 				}
 			}
@@ -574,122 +951,429 @@ bool MeshSetOperation::ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeLis
 		objFormat.Save("DebugMeshB.OBJ", fileObjectArray);
 #endif //MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES
 
-	return true;
+	// Finding no root node may just mean that we were cancelled in the middle of looking.
+	return this->ReportProgress(PHASE_COLORING, double(coloredCount) / double(nodeList.size()));
 }
 
-MeshSetOperation::Graph::Node* MeshSetOperation::FindRootNodeForColoring(const Mesh* targetMesh, std::list<Graph::Node*>& nodeList)
+// Find the first node at or past the cursor whose color we don't yet know, and color it by asking the volume
+// of the other mesh whether it contains the center of the node.  The center is a safer bet than
+// any vertex, since vertices of refined faces are often right on the cut boundary.  Note that
+// each connected component of the graph will need a root node of its own.
+MeshSetOperation::Graph::Node* MeshSetOperation::FindRootNodeForColoring(const std::vector<Graph::Node*>& nodeArray, int& cursor, const MeshVolume* otherVolume)
 {
-	// Perform a bunch of ray-casts against the given node-list to find the
-	// node that is hit by each ray.  If a ray hits a node for the target
-	// mesh, and we don't yet know its color, then return it as an outside
-	// node.  If we exhaust all rays, then find the first node of the target
-	// mesh without a known color and return it as an inside node.  Note that
-	// this algorithm still does not account for all possible cases.  It is still
-	// possible for there to exist an outside node that can't be hit by any ray.
-
-	AxisAlignedBox boundingBox;
-	for (Graph::Node* node : nodeList)
+	for (; cursor < (int)nodeArray.size(); cursor++)
 	{
-		Mesh::ConvexPolygon polygon = node->MakePolygon();
-		for (Mesh::Vertex& vertex : polygon.vertexArray)
-			boundingBox.MinimallyExpandToContainPoint(vertex.point);
+		Graph::Node* node = nodeArray[cursor];
+		if (node->side == Graph::Node::Side::UNKNOWN)
+		{
+			ConvexPolygon polygon;
+			node->MakePolygon().ToBasicPolygon(polygon);
+			node->side = otherVolume->ContainsPoint(polygon.CalcCenter(), this->statistics ? &this->statistics->rayCastCount : nullptr) ? Graph::Node::INSIDE : Graph::Node::OUTSIDE;
+			return node;
+		}
 	}
 
-	boundingBox.ScaleAboutCenter(1.5);
-	Vector center = boundingBox.CalcCenter();
-	double radius = boundingBox.CalcRadius();
+	return nullptr;
+}
+
+MeshSetOperation::Face::Face()
+{
+	this->planeIndex = -1;
+}
+
+/*virtual*/ MeshSetOperation::Face::~Face()
+{
+}
+
+/*virtual*/ AxisAlignedBox MeshSetOperation::Face::CalcBoundingBox() const
+{
+	return this->box;
+}
+
+MeshSetOperation::CutMesh::CutMesh()
+{
+	this->vertexArray = new std::vector<Mesh::Vertex>();
+	this->planeArray = new std::vector<Plane>();
+	this->edgeMap = new std::map<std::pair<int, int>, Face*>();
+}
+
+/*virtual*/ MeshSetOperation::CutMesh::~CutMesh()
+{
+	delete this->vertexArray;
+	delete this->planeArray;
+	delete this->edgeMap;
+}
+
+void MeshSetOperation::CutMesh::Clear()
+{
+	this->vertexArray->clear();
+	this->planeArray->clear();
+	this->edgeMap->clear();
+}
+
+void MeshSetOperation::CutMesh::Populate(const Mesh* mesh)
+{
+	this->Clear();
 
-	int lattitudeCount = 20;
-	int longitudeCount = 40;
+	for (int i = 0; i < mesh->GetNumVertices(); i++)
+		this->vertexArray->push_back(*mesh->GetVertex(i));
 
-	Vector xAxis(1.0, 0.0, 0.0);
-	Vector yAxis(0.0, 1.0, 0.0);
-	Vector zAxis(0.0, 0.0, 1.0);
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+	{
+		ConvexPolygon polygon;
+		mesh->GetFace(i)->GeneratePolygon(mesh).ToBasicPolygon(polygon);
 
-	for (int i = 0; i <= longitudeCount; i++)
+		Plane plane;
+		polygon.CalcPlane(plane);
+		this->planeArray->push_back(plane);
+	}
+}
+
+void MeshSetOperation::CutMesh::AddFace(Face* face)
+{
+	for (int i = 0; i < (int)face->vertexArray.size(); i++)
 	{
-		double theta = (double(i) / double(longitudeCount)) * MW_TWO_PI;
-		Vector vectorA = xAxis * cos(theta) + yAxis * sin(theta);
+		int j = (i + 1) % face->vertexArray.size();
+		(*this->edgeMap)[std::pair<int, int>(face->vertexArray[i], face->vertexArray[j])] = face;
+	}
+}
 
-		for (int j = 0; j <= lattitudeCount; j++)
+void MeshSetOperation::CutMesh::RemoveFace(Face* face)
+{
+	for (int i = 0; i < (int)face->vertexArray.size(); i++)
+	{
+		int j = (i + 1) % face->vertexArray.size();
+		std::map<std::pair<int, int>, Face*>::iterator iter = this->edgeMap->find(std::pair<int, int>(face->vertexArray[i], face->vertexArray[j]));
+		if (iter != this->edgeMap->end() && iter->second == face)
+			this->edgeMap->erase(iter);
+	}
+}
+
+// Put vertex k between vertices i and j of whatever face has the edge going from i to j.
+// Vertex k must lie on that edge, so the face's shape (and bounding box) don't change.
+void MeshSetOperation::CutMesh::InsertEdgeVertex(int i, int j, int k)
+{
+	std::map<std::pair<int, int>, Face*>::iterator iter = this->edgeMap->find(std::pair<int, int>(i, j));
+	if (iter == this->edgeMap->end())
+		return;
+
+	Face* face = iter->second;
+	this->edgeMap->erase(iter);
+
+	for (int l = 0; l < (int)face->vertexArray.size(); l++)
+	{
+		if (face->vertexArray[l] == i && face->vertexArray[(l + 1) % face->vertexArray.size()] == j)
 		{
-			double phi = (double(j) / double(lattitudeCount)) * MW_PI;
-			Vector vectorB = zAxis * cos(phi) + vectorA * sin(phi);
+			face->vertexArray.insert(face->vertexArray.begin() + l + 1, k);
+			break;
+		}
+	}
+
+	(*this->edgeMap)[std::pair<int, int>(i, k)] = face;
+	(*this->edgeMap)[std::pair<int, int>(k, j)] = face;
+}
 
-			Vector rayOrigin = center + vectorB * radius;
-			Vector rayDirection = center - rayOrigin;
-			Ray ray(rayOrigin, rayDirection);
+void MeshSetOperation::CutMesh::CalcFaceBox(Face* face) const
+{
+	face->box = AxisAlignedBox();
 
-			Graph::Node* node = this->RayCast(ray, nodeList);
-			if (node && node->meshGraph->GetTargetMesh() == targetMesh && node->side == Graph::Node::Side::UNKNOWN)
+	for (int i : face->vertexArray)
+		face->box.MinimallyExpandToContainPoint((*this->vertexArray)[i].point);
+}
+
+void MeshSetOperation::CutMesh::MakeBasicPolygon(const Face* face, ConvexPolygon& polygon) const
+{
+	polygon.vertexArray->clear();
+
+	for (int i : face->vertexArray)
+		polygon.vertexArray->push_back((*this->vertexArray)[i].point);
+}
+
+Mesh::ConvexPolygon MeshSetOperation::CutMesh::MakePolygon(const Face* face) const
+{
+	Mesh::ConvexPolygon polygon;
+
+	for (int i : face->vertexArray)
+		polygon.vertexArray.push_back((*this->vertexArray)[i]);
+
+	return polygon;
+}
+
+MeshSetOperation::OutputBuilder::OutputBuilder(Mesh* mesh, bool matchAttributes)
+{
+	this->mesh = mesh;
+	this->matchAttributes = matchAttributes;
+	this->cellMap = new std::unordered_map<uint64_t, std::vector<int>>();
+}
+
+/*virtual*/ MeshSetOperation::OutputBuilder::~OutputBuilder()
+{
+	delete this->cellMap;
+}
+
+// Copy the given faces of the given mesh into ours.  Their vertices may be welded to those of
+// meshes added before, but never to one another, since that's been taken care of already.
+void MeshSetOperation::OutputBuilder::AddFaces(const Mesh* sourceMesh, const std::vector<int>& faceIndexArray, bool reverse)
+{
+	std::vector<int> vertexMap(sourceMesh->GetNumVertices(), -1);
+	std::vector<int> newVertexArray;
+
+	for (int i : faceIndexArray)
+	{
+		Mesh::Face face = *sourceMesh->GetFace(i);
+
+		for (int& j : face.vertexArray)
+		{
+			if (vertexMap[j] < 0)
 			{
-				node->side = Graph::Node::OUTSIDE;
-				return node;
+				Mesh::Vertex vertex = *sourceMesh->GetVertex(j);
+				if (reverse)
+					vertex.normal = vertex.normal * -1.0;
+
+				vertexMap[j] = this->FindVertex(vertex);
+				if (vertexMap[j] < 0)
+				{
+					vertexMap[j] = this->mesh->AddVertex(vertex);
+					newVertexArray.push_back(vertexMap[j]);
+				}
 			}
+
+			j = vertexMap[j];
 		}
+
+		if (reverse)
+			std::reverse(face.vertexArray.begin(), face.vertexArray.end());
+
+		this->mesh->AddFace(face);
 	}
 
-	for (Graph::Node* node : nodeList)
+	for (int i : newVertexArray)
+		this->AddToCell(i);
+}
+
+// Unlike faces of a mesh, each polygon comes with its own vertices, so every one of them is welded as it's added.
+void MeshSetOperation::OutputBuilder::AddPolygon(const Mesh::ConvexPolygon& polygon)
+{
+	Mesh::Face face;
+
+	for (const Mesh::Vertex& vertex : polygon.vertexArray)
 	{
-		if (node->meshGraph->GetTargetMesh() == targetMesh && node->side == Graph::Node::Side::UNKNOWN)
+		int i = this->FindVertex(vertex);
+		if (i < 0)
 		{
-			node->side = Graph::Node::INSIDE;
-			return node;
+			i = this->mesh->AddVertex(vertex);
+			this->AddToCell(i);
 		}
+
+		// A tiny edge can collapse when welded.
+		if (face.vertexArray.size() == 0 || (face.vertexArray.back() != i && face.vertexArray[0] != i))
+			face.vertexArray.push_back(i);
 	}
 
-	return nullptr;
+	if (face.vertexArray.size() >= 3)
+		this->mesh->AddFace(face);
 }
 
-MeshSetOperation::Graph::Node* MeshSetOperation::RayCast(const Ray& ray, std::list<Graph::Node*>& nodeList)
+void MeshSetOperation::OutputBuilder::AddToCell(int i)
 {
-	double smallestRayAlpha = FLT_MAX;
-	Graph::Node* hitNode = nullptr;
+	const Vector& point = this->mesh->GetVertex(i)->point;
+	(*this->cellMap)[this->MakeKey(this->CellCoordinate(point.x), this->CellCoordinate(point.y), this->CellCoordinate(point.z))].push_back(i);
+}
 
-	for (Graph::Node* node : nodeList)
-	{
-		ConvexPolygon polygon;
-		node->MakePolygon().ToBasicPolygon(polygon);
+// Find the first vertex we already have within MW_EPS of the given one, if any.  The cells are
+// twice that size, so there are never more than two of them to look in along each axis.
+int MeshSetOperation::OutputBuilder::FindVertex(const Mesh::Vertex& vertex) const
+{
+	if (this->cellMap->size() == 0)
+		return -1;
+
+	const Vector& point = vertex.point;
+	int64_t minX = this->CellCoordinate(point.x - MW_EPS), maxX = this->CellCoordinate(point.x + MW_EPS);
+	int64_t minY = this->CellCoordinate(point.y - MW_EPS), maxY = this->CellCoordinate(point.y + MW_EPS);
+	int64_t minZ = this->CellCoordinate(point.z - MW_EPS), maxZ = this->CellCoordinate(point.z + MW_EPS);
 
-		double rayAlpha = 0.0;
-		if (polygon.RayCast(ray, rayAlpha))
+	int foundIndex = -1;
+
+	for (int64_t x = minX; x <= maxX; x++)
+	{
+		for (int64_t y = minY; y <= maxY; y++)
 		{
-			if (rayAlpha < smallestRayAlpha)
+			for (int64_t z = minZ; z <= maxZ; z++)
 			{
-				smallestRayAlpha = rayAlpha;
-				hitNode = node;
+				std::unordered_map<uint64_t, std::vector<int>>::const_iterator iter = this->cellMap->find(this->MakeKey(x, y, z));
+				if (iter == this->cellMap->end())
+					continue;
+
+				// Different cells can hash the same, but that just means a few extra comparisons.
+				for (int i : iter->second)
+				{
+					if (foundIndex >= 0 && i >= foundIndex)
+						continue;
+
+					const Mesh::Vertex* existingVertex = this->mesh->GetVertex(i);
+					if ((existingVertex->point - point).Length() <= MW_EPS)
+						if (!this->matchAttributes || existingVertex->HasSameAttributes(vertex))
+							foundIndex = i;
+				}
 			}
 		}
 	}
 
-	return hitNode;
+	return foundIndex;
 }
 
-bool MeshSetOperation::PointIsOnCutBoundary(const Vector& point, double eps /*= MW_EPS*/) const
+// Each mesh was only given vertices where its own edges crossed the other surface, so along the cut,
+// a vertex of one piece often lands in the middle of an edge of the other, where there's nothing to
+// weld it to.  Here we find the edges that no face has going the other way, and split each of them
+// at whatever ends of such edges lie along it.
+void MeshSetOperation::OutputBuilder::StitchSeams()
 {
-	for (int i = 0; i < (int)this->cutBoundaryPolylineArray->size(); i++)
-		if ((*this->cutBoundaryPolylineArray)[i]->ContainsPoint(point, 2.0 * eps))	// Why two?  I don't know.
-			return true;
+	std::vector<uint64_t> edgeKeyArray;
+	for (int i = 0; i < this->mesh->GetNumFaces(); i++)
+	{
+		const Mesh::Face* face = this->mesh->GetFace(i);
+		for (int j = 0; j < (signed)face->vertexArray.size(); j++)
+			edgeKeyArray.push_back(this->MakeEdgeKey(face->vertexArray[j], face->vertexArray[(j + 1) % face->vertexArray.size()]));
+	}
+
+	std::sort(edgeKeyArray.begin(), edgeKeyArray.end());
 
-	return false;
+	struct Split
+	{
+		int faceIndex;
+		int cornerIndex;
+		double lambda;
+		int vertexIndex;
+	};
+
+	std::vector<Split> openEdgeArray;
+	std::vector<bool> isSeamVertex(this->mesh->GetNumVertices(), false);
+	double totalLength = 0.0;
+
+	for (int i = 0; i < this->mesh->GetNumFaces(); i++)
+	{
+		const Mesh::Face* face = this->mesh->GetFace(i);
+		for (int j = 0; j < (signed)face->vertexArray.size(); j++)
+		{
+			int vertexA = face->vertexArray[j];
+			int vertexB = face->vertexArray[(j + 1) % face->vertexArray.size()];
+			if (!std::binary_search(edgeKeyArray.begin(), edgeKeyArray.end(), this->MakeEdgeKey(vertexB, vertexA)))
+			{
+				openEdgeArray.push_back(Split{ i, j, 0.0, -1 });
+				isSeamVertex[vertexA] = true;
+				isSeamVertex[vertexB] = true;
+				totalLength += (this->mesh->GetVertex(vertexB)->point - this->mesh->GetVertex(vertexA)->point).Length();
+			}
+		}
+	}
+
+	if (openEdgeArray.size() == 0)
+		return;
+
+	// Cells about as big as the open edges are long keep the number of them under each edge small.
+	double cellSize = MW_MAX(totalLength / double(openEdgeArray.size()), 2.0 * MW_EPS);
+	std::unordered_map<uint64_t, std::vector<int>> seamCellMap;
+	for (int i = 0; i < this->mesh->GetNumVertices(); i++)
+	{
+		if (isSeamVertex[i])
+		{
+			const Vector& point = this->mesh->GetVertex(i)->point;
+			seamCellMap[this->MakeKey(int64_t(::floor(point.x / cellSize)), int64_t(::floor(point.y / cellSize)), int64_t(::floor(point.z / cellSize)))].push_back(i);
+		}
+	}
+
+	std::vector<Split> splitArray;
+	for (const Split& openEdge : openEdgeArray)
+	{
+		const Mesh::Face* face = this->mesh->GetFace(openEdge.faceIndex);
+		int vertexA = face->vertexArray[openEdge.cornerIndex];
+		int vertexB = face->vertexArray[(openEdge.cornerIndex + 1) % face->vertexArray.size()];
+		const Vector& pointA = this->mesh->GetVertex(vertexA)->point;
+		const Vector& pointB = this->mesh->GetVertex(vertexB)->point;
+		Vector edgeVector = pointB - pointA;
+		double length = edgeVector.Length();
+		if (length <= MW_EPS)
+			continue;
+
+		int64_t minX = int64_t(::floor((MW_MIN(pointA.x, pointB.x) - MW_EPS) / cellSize)), maxX = int64_t(::floor((MW_MAX(pointA.x, pointB.x) + MW_EPS) / cellSize));
+		int64_t minY = int64_t(::floor((MW_MIN(pointA.y, pointB.y) - MW_EPS) / cellSize)), maxY = int64_t(::floor((MW_MAX(pointA.y, pointB.y) + MW_EPS) / cellSize));
+		int64_t minZ = int64_t(::floor((MW_MIN(pointA.z, pointB.z) - MW_EPS) / cellSize)), maxZ = int64_t(::floor((MW_MAX(pointA.z, pointB.z) + MW_EPS) / cellSize));
+
+		std::vector<int> visitedArray;
+		for (int64_t x = minX; x <= maxX; x++)
+		{
+			for (int64_t y = minY; y <= maxY; y++)
+			{
+				for (int64_t z = minZ; z <= maxZ; z++)
+				{
+					std::unordered_map<uint64_t, std::vector<int>>::const_iterator iter = seamCellMap.find(this->MakeKey(x, y, z));
+					if (iter == seamCellMap.end())
+						continue;
+
+					for (int i : iter->second)
+					{
+						// Different cells can hash the same, so the same vertex might come up twice.
+						if (i == vertexA || i == vertexB || std::find(visitedArray.begin(), visitedArray.end(), i) != visitedArray.end())
+							continue;
+
+						visitedArray.push_back(i);
+
+						const Vector& point = this->mesh->GetVertex(i)->point;
+						double distance = Vector::Dot(point - pointA, edgeVector) / length;
+						if (distance <= MW_EPS || distance >= length - MW_EPS)
+							continue;
+
+						// The vertex and the edge were each put where they are by cutting, so each is only good to about MW_EPS.
+						double lambda = distance / length;
+						if ((pointA + edgeVector * lambda - point).Length() <= 2.0 * MW_EPS)
+							splitArray.push_back(Split{ openEdge.faceIndex, openEdge.cornerIndex, lambda, i });
+					}
+				}
+			}
+		}
+	}
+
+	std::sort(splitArray.begin(), splitArray.end(), [](const Split& splitA, const Split& splitB) {
+		if (splitA.faceIndex != splitB.faceIndex)
+			return splitA.faceIndex < splitB.faceIndex;
+		if (splitA.cornerIndex != splitB.cornerIndex)
+			return splitA.cornerIndex < splitB.cornerIndex;
+		return splitA.lambda < splitB.lambda;
+	});
+
+	// Put the new vertices into each face right after the corner their edge starts at.
+	int i = 0;
+	while (i < (signed)splitArray.size())
+	{
+		int faceIndex = splitArray[i].faceIndex;
+		Mesh::Face* face = this->mesh->GetFace(faceIndex);
+		std::vector<int> vertexArray;
+
+		for (int j = 0; j < (signed)face->vertexArray.size(); j++)
+		{
+			vertexArray.push_back(face->vertexArray[j]);
+
+			while (i < (signed)splitArray.size() && splitArray[i].faceIndex == faceIndex && splitArray[i].cornerIndex == j)
+				vertexArray.push_back(splitArray[i++].vertexIndex);
+		}
+
+		face->vertexArray = vertexArray;
+	}
 }
 
-MeshSetOperation::Face::Face()
+uint64_t MeshSetOperation::OutputBuilder::MakeEdgeKey(int vertexA, int vertexB) const
 {
+	return (uint64_t(uint32_t(vertexA)) << 32) | uint64_t(uint32_t(vertexB));
 }
 
-/*virtual*/ MeshSetOperation::Face::~Face()
+int64_t MeshSetOperation::OutputBuilder::CellCoordinate(double coordinate) const
 {
+	return (int64_t)::floor(coordinate / (2.0 * MW_EPS));
 }
 
-/*virtual*/ AxisAlignedBox MeshSetOperation::Face::CalcBoundingBox() const
+uint64_t MeshSetOperation::OutputBuilder::MakeKey(int64_t x, int64_t y, int64_t z) const
 {
-	AxisAlignedBox box;
-
-	for (int i = 0; i < (signed)this->polygon.vertexArray.size(); i++)
-		box.MinimallyExpandToContainPoint(this->polygon.vertexArray[i].point);
-
-	return box;
+	return (uint64_t)x * 73856093ULL ^ (uint64_t)y * 19349663ULL ^ (uint64_t)z * 83492791ULL;
 }
 
 MeshSetOperation::Graph::Graph()
@@ -708,22 +1392,13 @@ MeshSetOperation::Graph::Graph()
 MeshSetOperation::Graph::Node::Node(MeshGraph* meshGraph) : MeshGraph::Node(meshGraph)
 {
 	this->side = Side::UNKNOWN;
+	this->touchesOtherSurface = false;
 }
 
 /*virtual*/ MeshSetOperation::Graph::Node::~Node()
 {
 }
 
-MeshSetOperation::Graph::Node::Side MeshSetOperation::Graph::Node::OppositeSide() const
-{
-	if (this->side == Side::OUTSIDE)
-		return Side::INSIDE;
-	else if (this->side == Side::INSIDE)
-		return Side::OUTSIDE;
-
-	return Side::UNKNOWN;
-}
-
 Mesh::ConvexPolygon MeshSetOperation::Graph::Node::MakePolygon() const
 {
 	const Mesh* targetMesh = this->meshGraph->GetTargetMesh();
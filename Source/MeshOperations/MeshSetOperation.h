@@ -7,12 +7,15 @@
 #include "../Polyline.h"
 #include "../TypeHeap.h"
 #include "../MeshGraph.h"
-#include <set>
+#include "../IndexedSet.h"
+#include <map>
+#include <unordered_map>
+#include <stdint.h>
 
 #define MW_DEBUG_DUMP_REFINED_MESHES			0
 #define MW_DEBUG_DUMP_INSIDE_OUTSIDE_MESHES		0
 #define MW_DEBUG_DUMP_CUT_BOUNDARY				0
-#define MW_DEBUG_USE_STACK_HEAP					1
+#define MW_DEBUG_USE_STACK_HEAP					0
 #define MW_DEBUG_TRAP_GRAPH_COLORING			0
 #define MW_DEBUG_DUMP_CUT_CASE					0
 
@@ -20,12 +23,28 @@
 #define MW_FLAG_INTERSECTION_SETP_OP		0x00000002
 #define MW_FLAG_A_MINUS_B_SET_OP			0x00000004
 #define MW_FLAG_B_MINUS_A_SET_OP			0x00000008
+#define MW_FLAG_ALL_SET_OP_RESULTS			0x0000000F
+
+// Normally, vertices made by cutting get normals, colors and texture coordinates interpolated
+// from the faces they were cut from.  With this flag, they get only a position, which is a bit
+// cheaper if nobody will look at the rest.
+#define MW_FLAG_SKIP_ATTRIBUTES_SET_OP		0x00000010
+
+// Where the surfaces were cut, the pieces from either side meet at the same points, but usually not
+// with the same normals, etc.  Normally those vertices are welded anyway, keeping the attributes of
+// the piece added first, so that the result is one closed surface.  With this flag, they're only
+// welded where their attributes agree, which keeps the crease along the cut, but leaves the result
+// in pieces there as far as its faces are concerned.
+#define MW_FLAG_SPLIT_ATTRIBUTES_SET_OP		0x00000020
+
+// This many faces vote on whether a mesh is inside the other when their surfaces don't cross.
+#define MW_SET_OP_CLASSIFICATION_SAMPLES	5
 
 namespace MeshWarrior
 {
 	class LineSegment;
 	class Sphere;
-	class Ray;
+	class MeshVolume;
 
 	// Note that the algorithm used here won't work with surfaces
 	// of certain topologies (e.g., non-orientable surfaces.)  This
@@ -37,13 +56,43 @@ namespace MeshWarrior
 		MeshSetOperation(int flags);
 		virtual ~MeshSetOperation();
 
+		// This puts a result together out of faces picked from other meshes, or out of loose polygons.
+		// Faces from the same mesh already share vertices as they should, so those are just copied over
+		// and renumbered.  Other vertices that land in the same place (and agree in their attributes, if
+		// asked) are welded together by way of a spatial hash, which stitches the pieces together along
+		// the cut.  What's left open after that is where a vertex of one piece lies along an edge of another.
+		class OutputBuilder
+		{
+		public:
+			OutputBuilder(Mesh* mesh, bool matchAttributes);
+			virtual ~OutputBuilder();
+
+			void AddFaces(const Mesh* sourceMesh, const std::vector<int>& faceIndexArray, bool reverse);
+			void AddPolygon(const Mesh::ConvexPolygon& polygon);
+
+			// Call this once all the faces are in to close the cracks that welding can't.
+			void StitchSeams();
+
+		private:
+
+			int FindVertex(const Mesh::Vertex& vertex) const;
+			void AddToCell(int i);
+			uint64_t MakeEdgeKey(int vertexA, int vertexB) const;
+			int64_t CellCoordinate(double coordinate) const;
+			uint64_t MakeKey(int64_t x, int64_t y, int64_t z) const;
+
+			Mesh* mesh;
+			bool matchAttributes;
+			std::unordered_map<uint64_t, std::vector<int>>* cellMap;
+		};
+
 	protected:
 
 		int flags;
 
 		virtual bool Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray) override;
 
-		class Face : public BoundingBoxTree::Guest
+		class Face : public BoundingBoxTree::Guest, public IndexedSetMember
 		{
 		public:
 			enum Family
@@ -58,7 +107,39 @@ namespace MeshWarrior
 			virtual AxisAlignedBox CalcBoundingBox() const override;
 
 			Family family;
-			Mesh::ConvexPolygon polygon;
+			std::vector<int> vertexArray;
+			int planeIndex;
+			AxisAlignedBox box;
+		};
+
+		// While cutting, each mesh is kept in indexed form, so that a vertex made where an edge
+		// crosses a plane is made just once, and is shared by both halves of the face that was cut
+		// as well as by the neighbor on the other side of that edge.  This way the refined meshes
+		// come out already welded, and their adjacency can be read straight off the indices.
+		class CutMesh
+		{
+		public:
+			CutMesh();
+			virtual ~CutMesh();
+
+			void Clear();
+			void Populate(const Mesh* mesh);
+			void AddFace(Face* face);
+			void RemoveFace(Face* face);
+			void InsertEdgeVertex(int i, int j, int k);
+			void CalcFaceBox(Face* face) const;
+			void MakeBasicPolygon(const Face* face, ConvexPolygon& polygon) const;
+			Mesh::ConvexPolygon MakePolygon(const Face* face) const;
+
+			std::vector<Mesh::Vertex>* vertexArray;
+
+			// These are the planes of the original faces.  A face is always cut against the plane
+			// of the original face from which the other face came, so that all pieces of that
+			// original face cut things the same way.
+			std::vector<Plane>* planeArray;
+
+			// This maps each directed edge to the face having it.
+			std::map<std::pair<int, int>, Face*>* edgeMap;
 		};
 
 		struct CollisionPair
@@ -95,23 +176,47 @@ namespace MeshWarrior
 				};
 
 				Mesh::ConvexPolygon MakePolygon() const;
-				Side OppositeSide() const;
 
 				Side side;
+				bool touchesOtherSurface;
 			};
 		};
 
-		void ProcessCollisionPair(const CollisionPair& pair, std::set<Face*>& newFaceSetA, std::set<Face*>& newFaceSetB);
-		bool ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeList);
-		bool PointIsOnCutBoundary(const Vector& point, double eps = MW_EPS) const;
-		Graph::Node* FindRootNodeForColoring(const Mesh* targetMesh, std::list<Graph::Node*>& nodeList);
-		Graph::Node* RayCast(const Ray& ray, std::list<Graph::Node*>& nodeList);
+		// These are the faces of a mesh, by index, sorted by which side of the other mesh they're on.
+		struct SortedFaces
+		{
+			const Mesh* mesh;
+			std::vector<int> outsideFaceArray;
+			std::vector<int> insideFaceArray;
+		};
 
-		std::set<Face*>* faceSet;
-		TypeHeap<Face>* faceHeap;
+		void AddFaces(const Mesh* mesh, Face::Family family, CutMesh* cutMesh, const AxisAlignedBox& overlapBox);
+		void ProcessCollisionPair(const CollisionPair& pair, std::vector<Face*>& newFaceArrayA, std::vector<Face*>& newFaceArrayB);
+		bool SplitFace(CutMesh* cutMesh, Face* face, const Plane& plane, std::vector<Face*>& newFaceArray);
+		bool ColorGraph(Graph* graph, std::list<Graph::Node*>& nodeList, const MeshVolume* otherVolume);
+		Graph::Node* FindRootNodeForColoring(const std::vector<Graph::Node*>& nodeArray, int& cursor, const MeshVolume* otherVolume);
+		void Clear();
+		void FreeFaces();
+		virtual void AssembleOutput(const std::vector<SortedFaces>& sortedFacesArrayA, const std::vector<SortedFaces>& sortedFacesArrayB, std::vector<Mesh*>& outputMeshArray);
+		virtual const MeshVolume* GenerateVolume(Face::Family family, const Mesh* mesh);
+		virtual AxisAlignedBox CalcMeshBox(Face::Family family, const Mesh* mesh);
+		bool CalculateSetOperation(const Mesh* meshA, const Mesh* meshB, std::vector<Mesh*>& outputMeshArray);
+		bool CalculateWithoutCutting(const Mesh* meshA, const Mesh* meshB, bool boxesOverlap, std::vector<Mesh*>& outputMeshArray);
+		bool SampleIsInside(const Mesh* mesh, const MeshVolume& volume);
+		void RecordPeakAllocation();
+
+		IndexedSet<Face>* faceSet;
+		std::vector<Face*>* farFaceArray;
+		CutMesh* cutMeshA, *cutMeshB;
+#if MW_DEBUG_USE_STACK_HEAP
+		StackHeap<Face>* faceHeap;
+#else
+		SlabHeap<Face>* faceHeap;
+#endif
 		BoundingBoxTree faceTree;
 		Mesh refinedMeshA, refinedMeshB;
 		Graph* graphA, *graphB;
+		MeshVolume* volumeA, *volumeB;
 		std::vector<LineSegment*>* cutBoundarySegmentArray;
 		std::vector<Polyline*>* cutBoundaryPolylineArray;
 	};
@@ -0,0 +1,322 @@
+#include "MeshUnionOperation.h"
+#include "MeshSetOperation.h"
+#include "MeshMergeOperation.h"
+#include "../Mesh.h"
+#include <mutex>
+
+using namespace MeshWarrior;
+
+MeshUnionOperation::MeshUnionOperation()
+{
+}
+
+/*virtual*/ MeshUnionOperation::~MeshUnionOperation()
+{
+}
+
+/*virtual*/ bool MeshUnionOperation::Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray)
+{
+	*this->error = "";
+
+	if (inputMeshArray.size() == 0)
+	{
+		*this->error = "The union operation needs at least one mesh as input.";
+		return false;
+	}
+
+	std::vector<Item> itemArray;
+	for (Mesh* mesh : inputMeshArray)
+	{
+		if (mesh == nullptr)
+		{
+			*this->error = "All given meshes must be non-null.";
+			return false;
+		}
+
+		itemArray.push_back(Item{ mesh, mesh->CalcBoundingBox(), false });
+	}
+
+	this->BeginStatistics();
+
+	if (!this->ReportProgress(PHASE_SETUP, 0.0))
+		return false;
+
+	std::vector<std::vector<Item>> groupArray;
+	this->GroupByOverlap(itemArray, groupArray);
+
+	// The number of levels in the tree is set by the largest group.
+	int levelCount = 0, totalLevelCount = 0;
+	for (const std::vector<Item>& group : groupArray)
+	{
+		int groupLevelCount = 0;
+		for (int i = (int)group.size(); i > 1; i = (i + 1) / 2)
+			groupLevelCount++;
+		totalLevelCount = MW_MAX(totalLevelCount, groupLevelCount);
+	}
+
+	auto freeItems = [](std::vector<Item>& givenItemArray) {
+		for (Item& item : givenItemArray)
+			if (item.owned)
+				delete item.mesh;
+		givenItemArray.clear();
+	};
+
+	//
+	// Reduce each group down to a single mesh, a level at a time.  All the pairs
+	// of all the groups at a given level are independent, so they all go at once.
+	//
+
+	while (true)
+	{
+		struct Pair
+		{
+			int groupIndex;
+			int itemIndex;
+		};
+
+		std::vector<Pair> pairArray;
+		for (int i = 0; i < (int)groupArray.size(); i++)
+		{
+			this->PairUp(groupArray[i]);
+			for (int j = 0; j + 1 < (int)groupArray[i].size(); j += 2)
+				pairArray.push_back(Pair{ i, j });
+		}
+
+		if (pairArray.size() == 0)
+			break;
+
+		if (!this->ReportProgress(PHASE_CUTTING, double(levelCount) / double(totalLevelCount)))
+		{
+			for (std::vector<Item>& group : groupArray)
+				freeItems(group);
+			return false;
+		}
+
+		std::vector<Item> combinedItemArray(pairArray.size());
+		std::vector<int> combinedArray(pairArray.size(), 0);
+		std::vector<Statistics> pairStatisticsArray(this->statistics ? pairArray.size() : 0);
+		std::mutex errorMutex;
+
+		this->ParallelFor(0, (int)pairArray.size(), [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				const Pair& pair = pairArray[i];
+				const std::vector<Item>& group = groupArray[pair.groupIndex];
+
+				std::string pairError;
+				Statistics* pairStatistics = this->statistics ? &pairStatisticsArray[i] : nullptr;
+				combinedArray[i] = (int)this->CombinePair(group[pair.itemIndex], group[pair.itemIndex + 1], combinedItemArray[i], pairStatistics, pairError);
+				if (!combinedArray[i])
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (this->error->length() == 0)
+						*this->error = pairError;
+				}
+			}
+		}, 1);
+
+		// The work of each pair adds up, but the intermediate meshes it made aren't part of the output.
+		for (const Statistics& pairStatistics : pairStatisticsArray)
+		{
+			this->statistics->collisionPairCount += pairStatistics.collisionPairCount;
+			this->statistics->splitCount += pairStatistics.splitCount;
+			this->statistics->splitFaceCount += pairStatistics.splitFaceCount;
+			this->statistics->rayCastCount += pairStatistics.rayCastCount;
+			this->statistics->graphEdgeCount += pairStatistics.graphEdgeCount;
+			this->statistics->peakAllocation = MW_MAX(this->statistics->peakAllocation, pairStatistics.peakAllocation);
+		}
+
+		// Replace each pair with its combination.  An odd item out just carries over to the next level.
+		// If a pair failed, its items carry over too, just so that they get cleaned up below.
+		bool succeeded = true;
+		int pairCursor = 0;
+		for (std::vector<Item>& group : groupArray)
+		{
+			std::vector<Item> nextGroup;
+			for (int j = 0; j + 1 < (int)group.size(); j += 2, pairCursor++)
+			{
+				if (!combinedArray[pairCursor])
+				{
+					succeeded = false;
+					nextGroup.push_back(group[j]);
+					nextGroup.push_back(group[j + 1]);
+					continue;
+				}
+
+				for (int k = j; k < j + 2; k++)
+					if (group[k].owned)
+						delete group[k].mesh;
+
+				nextGroup.push_back(combinedItemArray[pairCursor]);
+			}
+
+			if (group.size() % 2 == 1)
+				nextGroup.push_back(group.back());
+
+			group.swap(nextGroup);
+		}
+
+		levelCount++;
+
+		if (!succeeded)
+		{
+			for (std::vector<Item>& group : groupArray)
+				freeItems(group);
+			return false;
+		}
+	}
+
+	//
+	// The groups are now one mesh each, and since they don't overlap, they can just be merged.
+	//
+
+	if (!this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 0.0))
+	{
+		for (std::vector<Item>& group : groupArray)
+			freeItems(group);
+		return false;
+	}
+
+	Mesh* unionMesh = nullptr;
+
+	if (groupArray.size() == 1 && groupArray[0][0].owned)
+		unionMesh = groupArray[0][0].mesh;
+	else
+	{
+		std::vector<Mesh*> groupMeshArray, mergedMeshArray;
+		for (std::vector<Item>& group : groupArray)
+			groupMeshArray.push_back(group[0].mesh);
+
+		MeshMergeOperation mergeOp;
+		mergeOp.Calculate(groupMeshArray, mergedMeshArray);
+		unionMesh = mergedMeshArray[0];
+
+		for (std::vector<Item>& group : groupArray)
+			freeItems(group);
+	}
+
+	*unionMesh->name = "union";
+
+	outputMeshArray.clear();
+	outputMeshArray.push_back(unionMesh);
+
+	if (this->statistics)
+		this->statistics->outputFaceCount = unionMesh->GetNumFaces();
+
+	this->ReportProgress(PHASE_OUTPUT_ASSEMBLY, 1.0);
+
+	return true;
+}
+
+// Two items go in the same group if there is any chain of overlapping bounding boxes between them.
+void MeshUnionOperation::GroupByOverlap(const std::vector<Item>& itemArray, std::vector<std::vector<Item>>& groupArray) const
+{
+	std::vector<int> parentArray(itemArray.size());
+	for (int i = 0; i < (int)itemArray.size(); i++)
+		parentArray[i] = i;
+
+	auto findRoot = [&parentArray](int i) -> int {
+		while (parentArray[i] != i)
+		{
+			parentArray[i] = parentArray[parentArray[i]];
+			i = parentArray[i];
+		}
+		return i;
+	};
+
+	for (int i = 0; i < (int)itemArray.size(); i++)
+		for (int j = i + 1; j < (int)itemArray.size(); j++)
+			if (itemArray[i].box.OverlapsWith(itemArray[j].box))
+				parentArray[findRoot(j)] = findRoot(i);
+
+	std::vector<int> groupIndexArray(itemArray.size(), -1);
+	groupArray.clear();
+
+	for (int i = 0; i < (int)itemArray.size(); i++)
+	{
+		int root = findRoot(i);
+		if (groupIndexArray[root] < 0)
+		{
+			groupIndexArray[root] = (int)groupArray.size();
+			groupArray.push_back(std::vector<Item>());
+		}
+
+		groupArray[groupIndexArray[root]].push_back(itemArray[i]);
+	}
+}
+
+// Reorder the given items so that consecutive pairs overlap one another wherever possible.
+// Pairing items that overlap keeps each set operation small, since the combined mesh only
+// has to be cut where the two actually meet.
+void MeshUnionOperation::PairUp(std::vector<Item>& itemArray) const
+{
+	std::vector<Item> pairedItemArray;
+	std::vector<bool> usedArray(itemArray.size(), false);
+
+	for (int i = 0; i < (int)itemArray.size(); i++)
+	{
+		if (usedArray[i])
+			continue;
+
+		usedArray[i] = true;
+		pairedItemArray.push_back(itemArray[i]);
+
+		int partner = -1;
+		for (int j = i + 1; j < (int)itemArray.size() && partner < 0; j++)
+			if (!usedArray[j] && itemArray[i].box.OverlapsWith(itemArray[j].box))
+				partner = j;
+
+		for (int j = i + 1; j < (int)itemArray.size() && partner < 0; j++)
+			if (!usedArray[j])
+				partner = j;
+
+		if (partner >= 0)
+		{
+			usedArray[partner] = true;
+			pairedItemArray.push_back(itemArray[partner]);
+		}
+	}
+
+	itemArray.swap(pairedItemArray);
+}
+
+bool MeshUnionOperation::CombinePair(const Item& itemA, const Item& itemB, Item& combinedItem, Statistics* pairStatistics, std::string& pairError)
+{
+	MeshOperation* meshOp = nullptr;
+	if (itemA.box.OverlapsWith(itemB.box))
+		meshOp = new MeshSetOperation(MW_FLAG_UNION_SET_OP);
+	else
+		meshOp = new MeshMergeOperation();
+
+	meshOp->concurrency = this->concurrency;
+	meshOp->scheduler = this->scheduler;
+	meshOp->statistics = pairStatistics;
+
+	// Pass any cancellation of ours along to the sub-operation.  Its phases are its own, so its progress isn't ours to report.
+	meshOp->SetProgressCallback([this, meshOp](Phase /*phase*/, double /*fraction*/) {
+		if (this->IsCancelled())
+			meshOp->Cancel();
+	});
+
+	std::vector<Mesh*> inputMeshArray, outputMeshArray;
+	inputMeshArray.push_back(itemA.mesh);
+	inputMeshArray.push_back(itemB.mesh);
+
+	bool success = meshOp->Calculate(inputMeshArray, outputMeshArray) && outputMeshArray.size() == 1;
+	if (success)
+	{
+		combinedItem.mesh = outputMeshArray[0];
+		combinedItem.box.Combine(itemA.box, itemB.box);
+		combinedItem.owned = true;
+	}
+	else
+	{
+		pairError = *meshOp->error;
+
+		for (Mesh* mesh : outputMeshArray)
+			delete mesh;
+	}
+
+	delete meshOp;
+	return success;
+}
\ No newline at end of file
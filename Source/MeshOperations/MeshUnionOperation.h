@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../MeshOperation.h"
+#include "../AxisAlignedBox.h"
+
+namespace MeshWarrior
+{
+	// This unions any number of meshes by way of two-mesh set operations arranged in a balanced
+	// tree, rather than in a chain, so that no one step has to cut up an ever-growing accumulation
+	// of everything before it, and so that all the steps at a given level of the tree can be done
+	// at the same time.  Inputs are first grouped by bounding-box overlap.  Groups can't touch one
+	// another, so they're just merged together at the end, and so are any two meshes that get
+	// paired up within a group but don't overlap one another.
+	class MESH_WARRIOR_API MeshUnionOperation : public MeshOperation
+	{
+	public:
+		MeshUnionOperation();
+		virtual ~MeshUnionOperation();
+
+		virtual bool Calculate(const std::vector<Mesh*>& inputMeshArray, std::vector<Mesh*>& outputMeshArray) override;
+
+	protected:
+
+		struct Item
+		{
+			Mesh* mesh;
+			AxisAlignedBox box;
+			bool owned;
+		};
+
+		void GroupByOverlap(const std::vector<Item>& itemArray, std::vector<std::vector<Item>>& groupArray) const;
+		void PairUp(std::vector<Item>& itemArray) const;
+		bool CombinePair(const Item& itemA, const Item& itemB, Item& combinedItem, Statistics* pairStatistics, std::string& pairError);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include "MeshVolume.h"
+#include "Mesh.h"
+#include "Ray.h"
+#include "Predicates.h"
+#include <float.h>
+
+using namespace MeshWarrior;
+
+//--------------------------------- MeshVolume ---------------------------------
+
+MeshVolume::MeshVolume()
+{
+	this->faceArray = new std::vector<Face*>();
+}
+
+/*virtual*/ MeshVolume::~MeshVolume()
+{
+	this->Clear();
+
+	delete this->faceArray;
+}
+
+void MeshVolume::Clear()
+{
+	this->faceTree.Clear();
+
+	for (Face* face : *this->faceArray)
+		delete face;
+
+	this->faceArray->clear();
+	this->boundingBox = AxisAlignedBox();
+}
+
+void MeshVolume::Generate(const Mesh* mesh)
+{
+	this->Clear();
+
+	std::vector<Mesh::ConvexPolygon> polygonArray;
+	mesh->ToPolygonArray(polygonArray);
+
+	for (const Mesh::ConvexPolygon& meshPolygon : polygonArray)
+	{
+		Face* face = new Face();
+		meshPolygon.ToBasicPolygon(face->polygon);
+		if (!face->polygon.CalcPlane(face->plane) || !face->polygon.GenerateEdgePlaneArray(face->edgePlaneArray))
+		{
+			delete face;
+			continue;
+		}
+
+		for (const Vector& point : *face->polygon.vertexArray)
+			face->box.MinimallyExpandToContainPoint(point);
+
+		face->index = (int)this->faceArray->size();
+		this->faceArray->push_back(face);
+		this->boundingBox.MinimallyExpandToContainBox(face->box);
+	}
+
+	this->faceTree.SetRootBox(this->boundingBox);
+
+	for (Face* face : *this->faceArray)
+		this->faceTree.AddGuest(face);
+}
+
+// We cast a few rays in different directions, count how many times each crosses the surface,
+// and go with the majority.  A ray can get unlucky by grazing an edge or vertex, but it is
+// unlikely that two of them will.  The directions are slightly tilted off the axes so that
+// they don't run along the faces of axis-aligned geometry, while still being close enough
+// to the axes that the box enclosing each ray stays thin.
+bool MeshVolume::ContainsPoint(const Vector& point, int64_t* rayCount /*= nullptr*/) const
+{
+	if (this->faceArray->size() == 0 || !this->boundingBox.ContainsPoint(point))
+		return false;
+
+	static const Vector rayDirectionArray[] =
+	{
+		Vector(1.0, 0.0137, 0.0071),
+		Vector(-0.0089, 1.0, 0.0123),
+		Vector(0.0111, -0.0063, 1.0)
+	};
+
+	int oddCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		if (this->CountCrossingsIsOdd(point, rayDirectionArray[i]))
+			oddCount++;
+
+		if (rayCount)
+			(*rayCount)++;
+
+		// Stop as soon as the vote is decided.
+		if (oddCount >= 2 || (oddCount == 0 && i == 1))
+			break;
+	}
+
+	return oddCount >= 2;
+}
+
+bool MeshVolume::CountCrossingsIsOdd(const Vector& point, const Vector& rayDirection) const
+{
+	Ray ray(point, rayDirection);
+
+	AxisAlignedBox rayBox;
+	if (!this->CalcRayBox(ray, rayBox))
+		return false;
+
+	std::list<BoundingBoxTree::Guest*> guestList;
+	this->faceTree.FindGuests(rayBox, guestList);
+
+	int crossingCount = 0;
+	for (BoundingBoxTree::Guest* guest : guestList)
+	{
+		double rayAlpha = 0.0;
+		if (((Face*)guest)->RayCast(ray, rayAlpha))
+			crossingCount++;
+	}
+
+	return (crossingCount % 2) == 1;
+}
+
+bool MeshVolume::RayCast(const Ray& ray, double& rayAlpha, int* faceIndex /*= nullptr*/) const
+{
+	AxisAlignedBox rayBox;
+	if (this->faceArray->size() == 0 || !this->CalcRayBox(ray, rayBox))
+		return false;
+
+	std::list<BoundingBoxTree::Guest*> guestList;
+	this->faceTree.FindGuests(rayBox, guestList);
+
+	const Face* hitFace = nullptr;
+	for (BoundingBoxTree::Guest* guest : guestList)
+	{
+		const Face* face = (Face*)guest;
+		double faceRayAlpha = 0.0;
+		if (face->RayCast(ray, faceRayAlpha) && (!hitFace || faceRayAlpha < rayAlpha))
+		{
+			hitFace = face;
+			rayAlpha = faceRayAlpha;
+		}
+	}
+
+	if (hitFace && faceIndex)
+		*faceIndex = hitFace->index;
+
+	return hitFace != nullptr;
+}
+
+bool MeshVolume::TouchesLineSegment(const Vector& pointA, const Vector& pointB, double eps /*= MW_EPS*/) const
+{
+	AxisAlignedBox segmentBox(pointA);
+	segmentBox.MinimallyExpandToContainPoint(pointB);
+	segmentBox.AddMargin(eps);
+
+	std::list<BoundingBoxTree::Guest*> guestList;
+	this->faceTree.FindGuests(segmentBox, guestList);
+
+	for (BoundingBoxTree::Guest* guest : guestList)
+		if (((Face*)guest)->TouchesLineSegment(pointA, pointB, eps))
+			return true;
+
+	return false;
+}
+
+// Calculate the box bounding the part of the given ray that lies within our bounding box.
+// False is returned if the ray misses our bounding box entirely.
+bool MeshVolume::CalcRayBox(const Ray& ray, AxisAlignedBox& rayBox) const
+{
+	double minAlpha = 0.0;
+	double maxAlpha = DBL_MAX;
+
+	const double* origin = &ray.origin.x;
+	const double* direction = &ray.direction.x;
+	const double* boxMin = &this->boundingBox.min.x;
+	const double* boxMax = &this->boundingBox.max.x;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (direction[i] == 0.0)
+		{
+			if (origin[i] < boxMin[i] || origin[i] > boxMax[i])
+				return false;
+			continue;
+		}
+
+		double alphaA = (boxMin[i] - origin[i]) / direction[i];
+		double alphaB = (boxMax[i] - origin[i]) / direction[i];
+		minAlpha = MW_MAX(minAlpha, MW_MIN(alphaA, alphaB));
+		maxAlpha = MW_MIN(maxAlpha, MW_MAX(alphaA, alphaB));
+	}
+
+	if (minAlpha > maxAlpha)
+		return false;
+
+	rayBox = AxisAlignedBox(ray.CalcRayPoint(minAlpha));
+	rayBox.MinimallyExpandToContainPoint(ray.CalcRayPoint(maxAlpha));
+	rayBox.AddMargin(MW_EPS);
+	return true;
+}
+
+//--------------------------------- MeshVolume::Face ---------------------------------
+
+MeshVolume::Face::Face()
+{
+	this->index = -1;
+}
+
+/*virtual*/ MeshVolume::Face::~Face()
+{
+}
+
+/*virtual*/ AxisAlignedBox MeshVolume::Face::CalcBoundingBox() const
+{
+	return this->box;
+}
+
+// Which side of each edge the ray passes is decided exactly, so that two faces sharing an edge always agree on it.
+// A ray passing right through the edge is given to just one of them, which keeps the crossing count honest: the
+// faces wind the edge opposite ways, so the edge is counted as part of a face only when it runs one way along
+// a fixed order of points, and the sense in which the ray crosses the face picks which way that is.  Where the
+// ray only grazes the two faces, they're crossed in opposite senses, so they both take the edge, or neither does.
+bool MeshVolume::Face::RayCast(const Ray& ray, double& rayAlpha) const
+{
+	if (!this->plane.RayCast(ray, rayAlpha) || rayAlpha <= 0.0)
+		return false;
+
+	Vector rayPoint = ray.origin + ray.direction;
+	const std::vector<Vector>& vertexArray = *this->polygon.vertexArray;
+
+	int crossingSide = 0;
+	std::vector<int> sideArray(vertexArray.size());
+	for (int i = 0; i < (signed)vertexArray.size(); i++)
+	{
+		sideArray[i] = Predicates::Orient3D(ray.origin, rayPoint, vertexArray[i], vertexArray[(i + 1) % vertexArray.size()]);
+		if (sideArray[i] == 0)
+			continue;
+
+		if (crossingSide == 0)
+			crossingSide = sideArray[i];
+		else if (sideArray[i] != crossingSide)
+			return false;
+	}
+
+	if (crossingSide == 0)
+		return false;
+
+	for (int i = 0; i < (signed)vertexArray.size(); i++)
+	{
+		if (sideArray[i] != 0)
+			continue;
+
+		// An edge with no length has no direction, and no say.
+		const Vector& pointA = vertexArray[i];
+		const Vector& pointB = vertexArray[(i + 1) % vertexArray.size()];
+		bool forward = IsLexicographicallyLess(pointA, pointB);
+		if (!forward && !IsLexicographicallyLess(pointB, pointA))
+			continue;
+
+		if (forward != (crossingSide > 0))
+			return false;
+	}
+
+	return true;
+}
+
+/*static*/ bool MeshVolume::Face::IsLexicographicallyLess(const Vector& pointA, const Vector& pointB)
+{
+	if (pointA.x != pointB.x)
+		return pointA.x < pointB.x;
+
+	if (pointA.y != pointB.y)
+		return pointA.y < pointB.y;
+
+	return pointA.z < pointB.z;
+}
+
+// Clip the segment, parameterized from zero to one, against the slab around the face's plane
+// and against each of its edge planes, all thickened by the given distance.  Whatever is left
+// of the segment is close enough to the face to be touching it.
+bool MeshVolume::Face::TouchesLineSegment(const Vector& pointA, const Vector& pointB, double eps) const
+{
+	double minAlpha = 0.0;
+	double maxAlpha = 1.0;
+
+	auto clip = [&minAlpha, &maxAlpha, eps](double distanceA, double distanceB) -> bool {
+		// Keep the part of the segment where the distance is at most eps.
+		if (distanceA > eps && distanceB > eps)
+			return false;
+
+		if (distanceA != distanceB)
+		{
+			double alpha = (eps - distanceA) / (distanceB - distanceA);
+			if (distanceA > eps)
+				minAlpha = MW_MAX(minAlpha, alpha);
+			else if (distanceB > eps)
+				maxAlpha = MW_MIN(maxAlpha, alpha);
+		}
+
+		return minAlpha <= maxAlpha;
+	};
+
+	double planeDistanceA = this->plane.ShortestSignedDistanceToPoint(pointA);
+	double planeDistanceB = this->plane.ShortestSignedDistanceToPoint(pointB);
+
+	if (!clip(planeDistanceA, planeDistanceB) || !clip(-planeDistanceA, -planeDistanceB))
+		return false;
+
+	for (const Plane& edgePlane : this->edgePlaneArray)
+		if (!clip(edgePlane.ShortestSignedDistanceToPoint(pointA), edgePlane.ShortestSignedDistanceToPoint(pointB)))
+			return false;
+
+	return true;
+}
\ No newline at end of file
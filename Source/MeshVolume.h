@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Defines.h"
+#include "BoundingBoxTree.h"
+#include "Polygon.h"
+#include "Shape.h"
+#include <vector>
+#include <stdint.h>
+
+namespace MeshWarrior
+{
+	class Mesh;
+	class Ray;
+
+	// This answers inside/outside questions about the volume enclosed by a closed,
+	// consistently wound mesh.  Once generated, it no longer refers to the mesh, and
+	// since all queries are read-only, any number of threads can query it at once.
+	class MESH_WARRIOR_API MeshVolume
+	{
+	public:
+		MeshVolume();
+		virtual ~MeshVolume();
+
+		void Generate(const Mesh* mesh);
+		void Clear();
+
+		// Points on (or very near) the surface can go either way.  If given, the ray count is increased by the number of rays cast.
+		bool ContainsPoint(const Vector& point, int64_t* rayCount = nullptr) const;
+
+		// Find the nearest face hit in front of the ray origin, if any.
+		bool RayCast(const Ray& ray, double& rayAlpha, int* faceIndex = nullptr) const;
+
+		// Tell us if the given line segment comes within the given distance of the surface.
+		bool TouchesLineSegment(const Vector& pointA, const Vector& pointB, double eps = MW_EPS) const;
+
+		const AxisAlignedBox& GetBoundingBox() const { return this->boundingBox; }
+		int GetNumFaces() const { return (int)this->faceArray->size(); }
+
+	private:
+
+		class Face : public BoundingBoxTree::Guest
+		{
+		public:
+			Face();
+			virtual ~Face();
+
+			virtual AxisAlignedBox CalcBoundingBox() const override;
+
+			bool RayCast(const Ray& ray, double& rayAlpha) const;
+			bool TouchesLineSegment(const Vector& pointA, const Vector& pointB, double eps) const;
+
+			static bool IsLexicographicallyLess(const Vector& pointA, const Vector& pointB);
+
+			ConvexPolygon polygon;
+			Plane plane;
+			std::vector<Plane> edgePlaneArray;
+			AxisAlignedBox box;
+			int index;
+		};
+
+		bool CountCrossingsIsOdd(const Vector& point, const Vector& rayDirection) const;
+		bool CalcRayBox(const Ray& ray, AxisAlignedBox& rayBox) const;
+
+		std::vector<Face*>* faceArray;
+		BoundingBoxTree faceTree;
+		AxisAlignedBox boundingBox;
+	};
+}
\ No newline at end of file
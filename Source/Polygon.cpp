@@ -1,9 +1,79 @@
 #include "Polygon.h"
 #include "Compressor.h"
 #include "Ray.h"
+#include "Predicates.h"
+#include "VectorKernels.h"
+#include "Vector3.h"
+#include "PolygonTriangulator.h"
+#include <float.h>
 
 using namespace MeshWarrior;
 
+static double CalcDistanceToBoundary(const std::vector<Vector>& vertexArray, const Vector& point)
+{
+	Vector3 compactPoint(point);
+	double shortestDistance = DBL_MAX;
+	for (int i = 0; i < (int)vertexArray.size(); i++)
+	{
+		Vector3 vertexA(vertexArray[i]);
+		Vector3 edgeVector = Vector3(vertexArray[(i + 1) % vertexArray.size()]) - vertexA;
+
+		double lengthSquared = Vector3::Dot(edgeVector, edgeVector);
+		double lambda = (lengthSquared > 0.0) ? Vector3::Dot(compactPoint - vertexA, edgeVector) / lengthSquared : 0.0;
+		lambda = MW_MAX(0.0, MW_MIN(lambda, 1.0));
+
+		double distance = (vertexA + edgeVector * lambda - compactPoint).Length();
+		shortestDistance = MW_MIN(shortestDistance, distance);
+	}
+
+	return shortestDistance;
+}
+
+// Count how many edges a ray from the given point crosses, in the coordinate plane the polygon is most nearly parallel to.
+// The point should already be in the plane of the polygon.  An odd count means it's inside, concave polygon or not.
+static bool ProjectionContainsPoint(const std::vector<Vector>& vertexArray, const Vector& normal, const Vector& point)
+{
+	int axisU = 0, axisV = 0;
+	PolygonTriangulator::ChooseProjectionAxes(normal, axisU, axisV);
+
+	double pointU = (&point.x)[axisU];
+	double pointV = (&point.x)[axisV];
+
+	bool inside = false;
+	for (int i = 0; i < (int)vertexArray.size(); i++)
+	{
+		const Vector& vertexA = vertexArray[i];
+		const Vector& vertexB = vertexArray[(i + 1) % vertexArray.size()];
+		double vertexAU = (&vertexA.x)[axisU], vertexAV = (&vertexA.x)[axisV];
+		double vertexBU = (&vertexB.x)[axisU], vertexBV = (&vertexB.x)[axisV];
+
+		if ((vertexAV > pointV) != (vertexBV > pointV))
+		{
+			double crossingU = vertexAU + (pointV - vertexAV) * (vertexBU - vertexAU) / (vertexBV - vertexAV);
+			if (pointU < crossingU)
+				inside = !inside;
+		}
+	}
+
+	return inside;
+}
+
+// Turn triangles given as triples of indices into the given vertices into polygons of their own.
+static void MakeTriangles(const std::vector<Vector>& vertexArray, const std::vector<int>& triangleArray, std::vector<ConvexPolygon>& polygonArray)
+{
+	polygonArray.clear();
+
+	ConvexPolygon triangle;
+	for (int i = 0; i < (int)triangleArray.size(); i += 3)
+	{
+		triangle.vertexArray->clear();
+		for (int j = 0; j < 3; j++)
+			triangle.vertexArray->push_back(vertexArray[triangleArray[i + j]]);
+
+		polygonArray.push_back(triangle);
+	}
+}
+
 //--------------------------------- Polygon ---------------------------------
 
 Polygon::Polygon()
@@ -38,8 +108,9 @@ void Polygon::operator=(const Polygon& polygon)
 		return false;
 
 	// Make sure they're all approximately co-planar.
+	Plane3 compactPlane(plane);
 	for (const Vector& vertex : *this->vertexArray)
-		if (!plane.ContainsPoint(vertex, 10.0 * eps))	// Why ten?  I don't know.
+		if (::fabs(compactPlane.ShortestSignedDistanceToPoint(Vector3(vertex))) > 10.0 * eps)	// Why ten?  I don't know.
 			return false;
 
 	return true;
@@ -53,15 +124,14 @@ void Polygon::operator=(const Polygon& polygon)
 	if (this->vertexArray->size() < 3)
 		return true;
 
-	Vector vertexA, vertexB;
 	int chosen_i = -1, chosen_j = -1;
 	double largestDistance = FLT_MIN;
 	for (int i = 0; i < (int)this->vertexArray->size(); i++)
 	{
-		vertexA = (*this->vertexArray)[i];
+		Vector3 vertexA((*this->vertexArray)[i]);
 		for (int j = i + 1; j < (int)this->vertexArray->size(); j++)
 		{
-			vertexB = (*this->vertexArray)[j];
+			Vector3 vertexB((*this->vertexArray)[j]);
 			double distance = (vertexA - vertexB).Length();
 			if (distance > largestDistance)
 			{
@@ -75,9 +145,7 @@ void Polygon::operator=(const Polygon& polygon)
 	if (largestDistance < MW_EPS)
 		return true;
 
-	vertexA = (*this->vertexArray)[chosen_i];
-	vertexB = (*this->vertexArray)[chosen_j];
-	LineSegment lineSegment(vertexA, vertexB);
+	LineSegment lineSegment((*this->vertexArray)[chosen_i], (*this->vertexArray)[chosen_j]);
 	for (int i = 0; i < (int)this->vertexArray->size(); i++)
 		if (!lineSegment.ContainsPoint((*this->vertexArray)[i], eps))
 			return false;
@@ -85,22 +153,36 @@ void Polygon::operator=(const Polygon& polygon)
 	return true;
 }
 
+// As with a disk, this is the signed distance to the plane if the point is right in front of or behind
+// the polygon, and otherwise the (unsigned) distance to the nearest point on its boundary.
 /*virtual*/ double Polygon::ShortestSignedDistanceToPoint(const Vector& point) const
 {
-	// TODO: This is non-trivial as it requires tessellation.
-	return 0.0;
+	Plane plane;
+	if (!this->CalcPlane(plane))
+		return CalcDistanceToBoundary(*this->vertexArray, point);
+
+	double distance = plane.ShortestSignedDistanceToPoint(point);
+	if (ProjectionContainsPoint(*this->vertexArray, plane.unitNormal, point - plane.unitNormal * distance))
+		return distance;
+
+	return CalcDistanceToBoundary(*this->vertexArray, point);
 }
 
 /*virtual*/ bool Polygon::ContainsPoint(const Vector& point, double eps /*= MW_EPS*/) const
 {
-	// TODO: This is non-trivial as it requires tessellation.
-	return false;
+	Plane plane;
+	if (!this->CalcPlane(plane) || !plane.ContainsPoint(point, eps))
+		return false;
+
+	if (CalcDistanceToBoundary(*this->vertexArray, point) <= eps)
+		return true;
+
+	return ProjectionContainsPoint(*this->vertexArray, plane.unitNormal, point);
 }
 
 /*virtual*/ double Polygon::CalcArea() const
 {
-	// TODO: This is non-trivial as it requires tessellation.
-	return 0.0f;
+	return CalcAreaNormal(*this->vertexArray).Length() / 2.0;
 }
 
 void Polygon::ReverseWinding()
@@ -118,25 +200,42 @@ bool Polygon::CalcPlane(Plane& plane) const
 {
 	if (this->vertexArray->size() < 3)
 		return false;
-	
-	// TODO: This might not be the most numerically stable choice.
-	//       If the cross product length is too low, maybe just
-	//       run a plane fit algorithm on the points?
-	Vector vertexA = (*this->vertexArray)[0];
-	Vector vertexB = (*this->vertexArray)[1];
-	Vector vertexC = (*this->vertexArray)[2];
 
-	plane.unitNormal.Cross(vertexB - vertexA, vertexC - vertexA);
+	plane.unitNormal = CalcAreaNormal(*this->vertexArray);
 
 	bool divByZero = false;
 	plane.unitNormal.Normalize(&divByZero);
 	if (divByZero)
 		return false;
 
-	plane.center = vertexA;
+	plane.center = (*this->vertexArray)[0];
 	return true;
 }
 
+// Newell's method takes every edge into account, so unlike the cross product of two
+// edges, it doesn't mind if some of the vertices are collinear, which happens when an
+// edge has picked up a vertex where a neighboring polygon was cut.  Working relative
+// to the first vertex keeps us from losing precision far from the origin.
+/*static*/ Vector Polygon::CalcAreaNormal(const std::vector<Vector>& pointArray)
+{
+	Vector3 normal(0.0, 0.0, 0.0);
+	if (pointArray.size() == 0)
+		return normal.ToVector();
+
+	Vector3 origin(pointArray[0]);
+	for (int i = 0; i < (int)pointArray.size(); i++)
+	{
+		Vector3 vertexA = Vector3(pointArray[i]) - origin;
+		Vector3 vertexB = Vector3(pointArray[(i + 1) % pointArray.size()]) - origin;
+
+		normal.x += (vertexA.y - vertexB.y) * (vertexA.z + vertexB.z);
+		normal.y += (vertexA.z - vertexB.z) * (vertexA.x + vertexB.x);
+		normal.z += (vertexA.x - vertexB.x) * (vertexA.y + vertexB.y);
+	}
+
+	return normal.ToVector();
+}
+
 // Find the plane that best fits our points.  This is convenient if the
 // points in our array aren't really all coplanar.
 bool Polygon::FitPlane(Plane& plane) const
@@ -168,20 +267,22 @@ bool Polygon::SnapToNearestPlane()
 
 Vector Polygon::CalcCenter() const
 {
-	Vector center(0.0, 0.0, 0.0);
+	Vector3 center(0.0, 0.0, 0.0);
 	for (const Vector& vertex : *this->vertexArray)
-		center += vertex;
+		center = center + Vector3(vertex);
 
 	if (this->vertexArray->size() > 0)
-		center.Scale(1.0 / double(this->vertexArray->size()));
+		center = center * (1.0 / double(this->vertexArray->size()));
 
-	return center;
+	return center.ToVector();
 }
 
 /*virtual*/ void Polygon::Tessellate(std::vector<ConvexPolygon>& polygonArray) const
 {
-	// TODO: Return a bunch of triangles that, together, form this polygon.
-	//       This is non-trivial in the concave case.
+	PolygonTriangulator triangulator;
+	std::vector<int> triangleArray;
+	triangulator.Triangulate(*this->vertexArray, triangleArray);
+	MakeTriangles(*this->vertexArray, triangleArray, polygonArray);
 }
 
 //--------------------------------- ConvexPolygon ---------------------------------
@@ -204,10 +305,10 @@ ConvexPolygon::ConvexPolygon()
 
 	for (int i = 0; i < (signed)edgePlaneArray.size(); i++)
 	{
-		Plane& edgePlane = edgePlaneArray[i];
+		Plane3 edgePlane(edgePlaneArray[i]);
 		for (int j = 0; j < (signed)this->vertexArray->size(); j++)
 		{
-			double distance = edgePlane.ShortestSignedDistanceToPoint((*this->vertexArray)[j]);
+			double distance = edgePlane.ShortestSignedDistanceToPoint(Vector3((*this->vertexArray)[j]));
 			if (distance > eps)
 				return false;
 		}
@@ -248,61 +349,9 @@ bool ConvexPolygon::GenerateEdgePlaneArray(std::vector<Plane>& edgePlaneArray) c
 // we override it here, because we can do it faster knowing we're convex.
 /*virtual*/ void ConvexPolygon::Tessellate(std::vector<ConvexPolygon>& polygonArray) const
 {
-	polygonArray.clear();
-
-	ConvexPolygon polygon;
-
-	std::vector<Vector> workingVertexArray = *this->vertexArray;
-	while (workingVertexArray.size() > 3)
-	{
-		polygon.vertexArray->clear();
-
-		int bestVertex = -1;
-		double maxTriangleArea = FLT_MIN;
-		for (int i = 0; i < (int)workingVertexArray.size(); i++)
-		{
-			int j = (i + 1) % workingVertexArray.size();
-			int k = (i + 2) % workingVertexArray.size();
-
-			const Vector& vertexA = workingVertexArray[i];
-			const Vector& vertexB = workingVertexArray[j];
-			const Vector& vertexC = workingVertexArray[k];
-
-			Vector vector;
-			vector.Cross(vertexB - vertexA, vertexC - vertexA);
-			double triangleArea = vector.Length() / 2.0;
-
-			if (triangleArea > maxTriangleArea)
-			{
-				maxTriangleArea = triangleArea;
-				bestVertex = i;
-			}
-		}
-
-		int i = bestVertex;
-		int j = (i + 1) % workingVertexArray.size();
-		int k = (i + 2) % workingVertexArray.size();
-
-		const Vector& vertexA = workingVertexArray[i];
-		const Vector& vertexB = workingVertexArray[j];
-		const Vector& vertexC = workingVertexArray[k];
-
-		polygon.vertexArray->push_back(vertexA);
-		polygon.vertexArray->push_back(vertexB);
-		polygon.vertexArray->push_back(vertexC);
-
-		polygonArray.push_back(polygon);
-		workingVertexArray.erase(workingVertexArray.begin() + j);
-	}
-
-	*polygon.vertexArray = workingVertexArray;
-	polygonArray.push_back(polygon);
-}
-
-/*virtual*/ double ConvexPolygon::ShortestSignedDistanceToPoint(const Vector& point) const
-{
-	// TODO: Write this.  Shouldn't be too hard.
-	return 0.0;
+	std::vector<int> triangleArray;
+	PolygonTriangulator::TriangulateConvex(*this->vertexArray, triangleArray);
+	MakeTriangles(*this->vertexArray, triangleArray, polygonArray);
 }
 
 /*virtual*/ bool ConvexPolygon::ContainsPoint(const Vector& point, double eps /*= MW_EPS*/) const
@@ -315,9 +364,10 @@ bool ConvexPolygon::GenerateEdgePlaneArray(std::vector<Plane>& edgePlaneArray) c
 	std::vector<Plane> edgePlaneArray;
 	this->GenerateEdgePlaneArray(edgePlaneArray);
 
-	for (Plane& edgePlane : edgePlaneArray)
+	Vector3 compactPoint(point);
+	for (const Plane& edgePlane : edgePlaneArray)
 	{
-		double distance = edgePlane.ShortestSignedDistanceToPoint(point);
+		double distance = Plane3(edgePlane).ShortestSignedDistanceToPoint(compactPoint);
 		if (distance > eps)
 			return false;
 	}
@@ -336,12 +386,6 @@ bool ConvexPolygon::GenerateEdgePlaneArray(std::vector<Plane>& edgePlaneArray) c
 	return this->ContainsPoint(rayPoint);
 }
 
-/*virtual*/ double ConvexPolygon::CalcArea() const
-{
-	// TODO: Write this.  Should be easy.  Just add up area of triangles made from center with edges.
-	return 0.0f;
-}
-
 /*virtual*/ Shape* ConvexPolygon::IntersectWith(const Shape* shape) const
 {
 	Shape* intersection = nullptr;
@@ -355,27 +399,38 @@ bool ConvexPolygon::GenerateEdgePlaneArray(std::vector<Plane>& edgePlaneArray) c
 		// We just care about a non-trivial intersection case.
 
 		std::vector<Point*> pointList;
-		const Polygon* polygons[2] = { this, polygon };
+		const ConvexPolygon* polygons[2] = { this, polygon };
 
 		for (int i = 0; i < 2; i++)
 		{
-			const Polygon* polygonA = polygons[i];
-			const Polygon* polygonB = polygons[1 - i];
+			const ConvexPolygon* polygonA = polygons[i];
+			const ConvexPolygon* polygonB = polygons[1 - i];
 
 			Plane plane;
 			polygonB->CalcPlane(plane);
 
+			std::vector<int> sideArray;
+			if (!polygonA->ClassifyAgainstPlane(plane, sideArray))
+			{
+				// Polygon A is entirely on one side of polygon B's plane, so there's nothing to find.
+				for (Point* point : pointList)
+					delete point;
+				return nullptr;
+			}
+
 			for (int j = 0; j < (signed)polygonA->vertexArray->size(); j++)
 			{
 				int k = (j + 1) % polygonA->vertexArray->size();
-				LineSegment edge((*polygonA->vertexArray)[j], (*polygonA->vertexArray)[k]);
-				Point* point = (Point*)plane.IntersectWith(&edge);
-				if (point)
+				const Vector& vertexA = (*polygonA->vertexArray)[j];
+				const Vector& vertexB = (*polygonA->vertexArray)[k];
+
+				if (sideArray[j] == 0 && polygonB->ContainsPoint(vertexA))
+					pointList.push_back(new Point(vertexA));
+				else if (sideArray[j] * sideArray[k] < 0)
 				{
-					if (polygonB->ContainsPoint(point->center))
-						pointList.push_back(point);
-					else
-						delete point;
+					Vector point = CalcPlaneCrossing(plane, vertexA, vertexB);
+					if (polygonB->ContainsPoint(point))
+						pointList.push_back(new Point(point));
 				}
 			}
 		}
@@ -390,8 +445,29 @@ bool ConvexPolygon::GenerateEdgePlaneArray(std::vector<Plane>& edgePlaneArray) c
 			return nullptr;
 		});
 
-		if (pointList.size() == 2)
-			intersection = new LineSegment(pointList[0]->center, pointList[1]->center);
+		// Every point we found lies on the line where the two planes meet, and the intersection
+		// is the stretch of that line between the two points furthest apart.  There can be more
+		// than two points when a vertex of one polygon lies in the plane of the other.
+		if (pointList.size() >= 2)
+		{
+			int bestI = 0, bestJ = 1;
+			double largestDistance = 0.0;
+			for (int i = 0; i < (int)pointList.size(); i++)
+			{
+				for (int j = i + 1; j < (int)pointList.size(); j++)
+				{
+					double distance = (Vector3(pointList[i]->center) - Vector3(pointList[j]->center)).Length();
+					if (distance > largestDistance)
+					{
+						largestDistance = distance;
+						bestI = i;
+						bestJ = j;
+					}
+				}
+			}
+
+			intersection = new LineSegment(pointList[bestI]->center, pointList[bestJ]->center);
+		}
 	
 		for (Point* point : pointList)
 			delete point;
@@ -421,38 +497,28 @@ void ConvexPolygon::AddMeshPolygon(std::vector<Mesh::ConvexPolygon>& polygonList
 
 bool ConvexPolygon::SplitAgainstPlane(const Plane& plane, std::vector<ConvexPolygon>& polygonArray) const
 {
-	std::vector<Vector> pointArray;
+	std::vector<int> sideArray;
+	if (!this->ClassifyAgainstPlane(plane, sideArray))
+		return false;
+
+	ConvexPolygon polygonFront, polygonBack;
 
 	for (int i = 0; i < (signed)this->vertexArray->size(); i++)
 	{
-		pointArray.push_back((*this->vertexArray)[i]);
-
 		int j = (i + 1) % this->vertexArray->size();
-		LineSegment edge((*this->vertexArray)[i], (*this->vertexArray)[j]);
-		Point* point = (Point*)plane.IntersectWith(&edge);
-		if (point)
-		{
-			if (!point->ContainsPoint(edge.GetPoint(0)) && !point->ContainsPoint(edge.GetPoint(1)))
-				pointArray.push_back(point->center);
-			delete point;
-		}
-	}
+		const Vector& vertex = (*this->vertexArray)[i];
 
-	ConvexPolygon polygonFront, polygonBack;
+		if (sideArray[i] >= 0)
+			polygonFront.vertexArray->push_back(vertex);
+		if (sideArray[i] <= 0)
+			polygonBack.vertexArray->push_back(vertex);
 
-	for (int i = 0; i < (signed)pointArray.size(); i++)
-	{
-		Vector& point = pointArray[i];
-		double distance = plane.ShortestSignedDistanceToPoint(point);
-		if (::fabs(distance) <= MW_EPS)
+		if (sideArray[i] * sideArray[j] < 0)
 		{
+			Vector point = CalcPlaneCrossing(plane, vertex, (*this->vertexArray)[j]);
 			polygonFront.vertexArray->push_back(point);
 			polygonBack.vertexArray->push_back(point);
 		}
-		else if (distance > 0.0)
-			polygonFront.vertexArray->push_back(point);
-		else if (distance < 0.0)
-			polygonBack.vertexArray->push_back(point);
 	}
 
 	bool polygonFrontDegenerate = polygonFront.IsDegenerate();
@@ -465,4 +531,47 @@ bool ConvexPolygon::SplitAgainstPlane(const Plane& plane, std::vector<ConvexPoly
 	}
 
 	return polygonArray.size() > 0;
+}
+
+// Each vertex gets +1, -1 or 0 according as it is in front of, behind, or within MW_EPS of the
+// given plane.  These are decided exactly, and everything else in the cutting follows from them,
+// so the two halves of a split can't disagree about a vertex, and neither can two polygons that
+// share it.  We return false if all vertices are strictly on the same side, since then nothing
+// about the polygon touches the plane.
+bool ConvexPolygon::ClassifyAgainstPlane(const Plane& plane, std::vector<int>& sideArray) const
+{
+	sideArray.resize(this->vertexArray->size());
+	if (sideArray.size() > 0)
+		Predicates::PlaneSideArray(plane, &(*this->vertexArray)[0].x, MW_DOUBLE_STRIDE(Vector), nullptr, (int)sideArray.size(), &sideArray[0]);
+
+	bool anyFront = false, anyBack = false, anyOn = false;
+	for (int i = 0; i < (signed)this->vertexArray->size(); i++)
+	{
+		anyFront |= (sideArray[i] > 0);
+		anyBack |= (sideArray[i] < 0);
+		anyOn |= (sideArray[i] == 0);
+	}
+
+	return anyOn || (anyFront && anyBack);
+}
+
+// Find where the given edge crosses the given plane.  The edge is always walked in the same direction
+// no matter which way around it was given, so that the polygons on either side of it find the same point.
+// If asked, we also say how far along the edge from vertex A to vertex B the point is, as a fraction.
+/*static*/ Vector ConvexPolygon::CalcPlaneCrossing(const Plane& plane, const Vector& vertexA, const Vector& vertexB, double* lambda /*= nullptr*/)
+{
+	bool swap = (vertexB.x < vertexA.x) || (vertexB.x == vertexA.x && (vertexB.y < vertexA.y || (vertexB.y == vertexA.y && vertexB.z < vertexA.z)));
+	const Vector& pointA = swap ? vertexB : vertexA;
+	const Vector& pointB = swap ? vertexA : vertexB;
+
+	Plane3 compactPlane(plane);
+	Vector3 compactPointA(pointA), compactPointB(pointB);
+	double distanceA = compactPlane.ShortestSignedDistanceToPoint(compactPointA);
+	double distanceB = compactPlane.ShortestSignedDistanceToPoint(compactPointB);
+	double alpha = distanceA / (distanceA - distanceB);
+
+	if (lambda)
+		*lambda = swap ? (1.0 - alpha) : alpha;
+
+	return (compactPointA + (compactPointB - compactPointA) * alpha).ToVector();
 }
\ No newline at end of file
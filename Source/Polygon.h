@@ -24,6 +24,8 @@ namespace MeshWarrior
 
 		virtual bool IsValid(double eps = MW_EPS) const;
 		virtual bool IsDegenerate(double eps = MW_EPS) const;
+
+		// These work for concave polygons as well, but assume the polygon is planar and doesn't cross itself.
 		virtual void Tessellate(std::vector<ConvexPolygon>& polygonArray) const;
 		virtual double CalcArea() const;
 
@@ -34,6 +36,10 @@ namespace MeshWarrior
 		bool SnapToNearestPlane();
 		Vector CalcCenter() const;
 
+		// This is perpendicular to the polygon through the given points, on the side they wind CCW about,
+		// and its length is twice the polygon's area, concave or not.  It's zero if they're all collinear.
+		static Vector CalcAreaNormal(const std::vector<Vector>& pointArray);
+
 		std::vector<Vector>* vertexArray;
 	};
 
@@ -46,17 +52,18 @@ namespace MeshWarrior
 		ConvexPolygon();
 		virtual ~ConvexPolygon();
 
-		virtual double ShortestSignedDistanceToPoint(const Vector& point) const override;
 		virtual bool ContainsPoint(const Vector& point, double eps = MW_EPS) const override;
 		virtual Shape* IntersectWith(const Shape* shape) const override;
 		virtual bool RayCast(const Ray& ray, double& rayAlpha) const override;
 
 		virtual bool IsValid(double eps = MW_EPS) const override;
 		virtual void Tessellate(std::vector<ConvexPolygon>& polygonArray) const override;
-		virtual double CalcArea() const override;
 
 		bool GenerateEdgePlaneArray(std::vector<Plane>& edgePlaneArray) const;
 		void AddMeshPolygon(std::vector<Mesh::ConvexPolygon>& polygonList, const Vector& color) const;
 		bool SplitAgainstPlane(const Plane& plane, std::vector<ConvexPolygon>& polygonArray) const;
+		bool ClassifyAgainstPlane(const Plane& plane, std::vector<int>& sideArray) const;
+
+		static Vector CalcPlaneCrossing(const Plane& plane, const Vector& vertexA, const Vector& vertexB, double* lambda = nullptr);
 	};
 }
\ No newline at end of file
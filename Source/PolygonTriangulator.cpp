@@ -0,0 +1,535 @@
+#include "PolygonTriangulator.h"
+#include "Polygon.h"
+#include "Predicates.h"
+#include "Vector3.h"
+#include <algorithm>
+#include <set>
+#include <math.h>
+
+using namespace MeshWarrior;
+
+PolygonTriangulator::PolygonTriangulator()
+{
+	this->uArray = new std::vector<double>();
+	this->vArray = new std::vector<double>();
+	this->sweepArray = new std::vector<int>();
+	this->diagonalArray = new std::vector<int>();
+	this->helperArray = new std::vector<int>();
+	this->halfEdgeArray = new std::vector<HalfEdge>();
+	this->slotArray = new std::vector<int>();
+	this->slotOffsetArray = new std::vector<int>();
+	this->chainArray = new std::vector<int>();
+	this->pieceArray = new std::vector<int>();
+	this->stackArray = new std::vector<int>();
+	this->vertexCount = 0;
+	this->queryVertex = -1;
+}
+
+/*virtual*/ PolygonTriangulator::~PolygonTriangulator()
+{
+	delete this->uArray;
+	delete this->vArray;
+	delete this->sweepArray;
+	delete this->diagonalArray;
+	delete this->helperArray;
+	delete this->halfEdgeArray;
+	delete this->slotArray;
+	delete this->slotOffsetArray;
+	delete this->chainArray;
+	delete this->pieceArray;
+	delete this->stackArray;
+}
+
+// Drop the coordinate the normal is biggest in, and order the other two so that looking down the normal, U cross V points at us.
+/*static*/ void PolygonTriangulator::ChooseProjectionAxes(const Vector& normal, int& axisU, int& axisV)
+{
+	int axis = 2;
+	if (::fabs(normal.x) >= ::fabs(normal.y) && ::fabs(normal.x) >= ::fabs(normal.z))
+		axis = 0;
+	else if (::fabs(normal.y) >= ::fabs(normal.z))
+		axis = 1;
+
+	axisU = (axis + 1) % 3;
+	axisV = (axis + 2) % 3;
+	if ((&normal.x)[axis] < 0.0)
+		std::swap(axisU, axisV);
+}
+
+bool PolygonTriangulator::Triangulate(const std::vector<Vector>& pointArray, std::vector<int>& triangleArray)
+{
+	triangleArray.clear();
+
+	this->vertexCount = (int)pointArray.size();
+	if (this->vertexCount < 3)
+		return false;
+
+	Vector normal = Polygon::CalcAreaNormal(pointArray);
+	bool degenerate = (normal.x == 0.0 && normal.y == 0.0 && normal.z == 0.0);
+
+	if (!degenerate && this->vertexCount > 3)
+	{
+		int axisU = 0, axisV = 0;
+		ChooseProjectionAxes(normal, axisU, axisV);
+
+		this->uArray->resize(this->vertexCount);
+		this->vArray->resize(this->vertexCount);
+		for (int i = 0; i < this->vertexCount; i++)
+		{
+			(*this->uArray)[i] = (&pointArray[i].x)[axisU];
+			(*this->vArray)[i] = (&pointArray[i].x)[axisV];
+		}
+
+		if (this->TurnsLeftOnly())
+		{
+			// Turning only left, the polygon is convex if it goes around just once, and a star crossing itself if it goes around more.
+			// Going around once turns the edges back on themselves exactly twice in U and twice in V, which we can count exactly.
+			if (CountReversals(*this->uArray) == 2 && CountReversals(*this->vArray) == 2)
+			{
+				TriangulateConvex(pointArray, triangleArray);
+				return true;
+			}
+
+			degenerate = true;
+		}
+		else
+		{
+			if (this->FindDiagonals() && this->TriangulatePieces(triangleArray) && (int)triangleArray.size() == 3 * (this->vertexCount - 2))
+				return true;
+
+			degenerate = true;
+			triangleArray.clear();
+		}
+	}
+
+	for (int i = 1; i < this->vertexCount - 1; i++)
+	{
+		triangleArray.push_back(0);
+		triangleArray.push_back(i);
+		triangleArray.push_back(i + 1);
+	}
+
+	return !degenerate;
+}
+
+/*static*/ void PolygonTriangulator::TriangulateConvex(const std::vector<Vector>& pointArray, std::vector<int>& triangleArray)
+{
+	triangleArray.clear();
+
+	int count = (int)pointArray.size();
+	if (count < 3)
+		return;
+
+	int low = 1;
+	int high = count - 1;
+
+	triangleArray.push_back(0);
+	triangleArray.push_back(low);
+	triangleArray.push_back(high);
+
+	while (high - low > 1)
+	{
+		Vector3 lowDiagonal = Vector3(pointArray[low + 1]) - Vector3(pointArray[high]);
+		Vector3 highDiagonal = Vector3(pointArray[low]) - Vector3(pointArray[high - 1]);
+
+		if (Vector3::Dot(lowDiagonal, lowDiagonal) <= Vector3::Dot(highDiagonal, highDiagonal))
+		{
+			triangleArray.push_back(low);
+			triangleArray.push_back(low + 1);
+			triangleArray.push_back(high);
+			low++;
+		}
+		else
+		{
+			triangleArray.push_back(low);
+			triangleArray.push_back(high - 1);
+			triangleArray.push_back(high);
+			high--;
+		}
+	}
+}
+
+int PolygonTriangulator::Orient(int vertexA, int vertexB, int vertexC) const
+{
+	const std::vector<double>& uArray = *this->uArray;
+	const std::vector<double>& vArray = *this->vArray;
+	return Predicates::Orient2D(uArray[vertexA], vArray[vertexA], uArray[vertexB], vArray[vertexB], uArray[vertexC], vArray[vertexC]);
+}
+
+// The sweep goes down V, and across U for ties, so that no two vertices are ever level with one another.
+bool PolygonTriangulator::IsAbove(int vertexA, int vertexB) const
+{
+	const std::vector<double>& uArray = *this->uArray;
+	const std::vector<double>& vArray = *this->vArray;
+	if (vArray[vertexA] != vArray[vertexB])
+		return vArray[vertexA] > vArray[vertexB];
+	if (uArray[vertexA] != uArray[vertexB])
+		return uArray[vertexA] < uArray[vertexB];
+	return vertexA < vertexB;
+}
+
+bool PolygonTriangulator::TurnsLeftOnly() const
+{
+	for (int i = 0; i < this->vertexCount; i++)
+		if (this->Orient((i + this->vertexCount - 1) % this->vertexCount, i, (i + 1) % this->vertexCount) < 0)
+			return false;
+
+	return true;
+}
+
+// Count the times the polygon's edges go from increasing to decreasing in the given coordinate, or back, all the way around.
+/*static*/ int PolygonTriangulator::CountReversals(const std::vector<double>& coordArray)
+{
+	int count = (int)coordArray.size();
+	int lastSign = 0;
+	for (int i = count - 1; i >= 0 && lastSign == 0; i--)
+		lastSign = (coordArray[(i + 1) % count] > coordArray[i]) - (coordArray[(i + 1) % count] < coordArray[i]);
+
+	int reversalCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int sign = (coordArray[(i + 1) % count] > coordArray[i]) - (coordArray[(i + 1) % count] < coordArray[i]);
+		if (sign != 0 && sign != lastSign)
+		{
+			reversalCount++;
+			lastSign = sign;
+		}
+	}
+
+	return reversalCount;
+}
+
+// A merge vertex is a reflex vertex with both of its neighbors above it.
+bool PolygonTriangulator::IsMerge(int vertex) const
+{
+	if (vertex < 0)
+		return false;
+
+	int prevVertex = (vertex + this->vertexCount - 1) % this->vertexCount;
+	int nextVertex = (vertex + 1) % this->vertexCount;
+	return this->IsAbove(prevVertex, vertex) && this->IsAbove(nextVertex, vertex) && this->Orient(prevVertex, vertex, nextVertex) < 0;
+}
+
+// Edge i goes from vertex i down to vertex i + 1, and the sweep line only ever holds edges going down, which are the ones with
+// the inside of the polygon to their right.  No two of them cross, so we can always tell which of two is to the left by seeing
+// which side of the one that came into the sweep first the top of the other is on.  An edge of -1 stands for the query vertex.
+bool PolygonTriangulator::EdgeLess::operator()(int edgeA, int edgeB) const
+{
+	const PolygonTriangulator* triangulator = this->triangulator;
+	int vertexCount = triangulator->vertexCount;
+
+	if (edgeA == edgeB)
+		return false;
+
+	if (edgeA < 0)
+		return triangulator->Orient(edgeB, (edgeB + 1) % vertexCount, triangulator->queryVertex) < 0;
+
+	if (edgeB < 0)
+		return triangulator->Orient(edgeA, (edgeA + 1) % vertexCount, triangulator->queryVertex) > 0;
+
+	if (triangulator->IsAbove(edgeA, edgeB))
+	{
+		int side = triangulator->Orient(edgeA, (edgeA + 1) % vertexCount, edgeB);
+		if (side == 0)
+			side = triangulator->Orient(edgeA, (edgeA + 1) % vertexCount, (edgeB + 1) % vertexCount);
+		return side > 0;
+	}
+
+	int side = triangulator->Orient(edgeB, (edgeB + 1) % vertexCount, edgeA);
+	if (side == 0)
+		side = triangulator->Orient(edgeB, (edgeB + 1) % vertexCount, (edgeA + 1) % vertexCount);
+	return side < 0;
+}
+
+// This is the plane sweep from de Berg et al., Computational Geometry, chapter 3.  Every vertex where the boundary turns back
+// on itself, so that the polygon isn't monotone there, gets a diagonal to the nearest suitable vertex above or below it.
+bool PolygonTriangulator::FindDiagonals()
+{
+	int vertexCount = this->vertexCount;
+
+	std::vector<int>& sweepArray = *this->sweepArray;
+	sweepArray.resize(vertexCount);
+	for (int i = 0; i < vertexCount; i++)
+		sweepArray[i] = i;
+
+	std::sort(sweepArray.begin(), sweepArray.end(), [this](int vertexA, int vertexB) {
+		return this->IsAbove(vertexA, vertexB);
+	});
+
+	std::vector<int>& helperArray = *this->helperArray;
+	helperArray.assign(vertexCount, -1);
+	this->diagonalArray->clear();
+
+	std::set<int, EdgeLess> edgeSet((EdgeLess(this)));
+
+	// Find the edge on the sweep line just to the left of the given vertex.
+	auto findLeftEdge = [this, &edgeSet](int vertex) -> int {
+		this->queryVertex = vertex;
+		std::set<int, EdgeLess>::iterator iter = edgeSet.lower_bound(-1);
+		if (iter == edgeSet.begin())
+			return -1;
+		return *(--iter);
+	};
+
+	for (int i : sweepArray)
+	{
+		int prevVertex = (i + vertexCount - 1) % vertexCount;
+		int nextVertex = (i + 1) % vertexCount;
+		bool prevBelow = this->IsAbove(i, prevVertex);
+		bool nextBelow = this->IsAbove(i, nextVertex);
+		int turn = this->Orient(prevVertex, i, nextVertex);
+
+		if (prevBelow && nextBelow)
+		{
+			// This is a split vertex if it's reflex, and a start vertex otherwise.
+			if (turn < 0)
+			{
+				int j = findLeftEdge(i);
+				if (j < 0)
+					return false;
+
+				this->AddDiagonal(i, helperArray[j]);
+				helperArray[j] = i;
+			}
+
+			edgeSet.insert(i);
+			helperArray[i] = i;
+		}
+		else if (!prevBelow && !nextBelow)
+		{
+			// This is a merge vertex if it's reflex, and an end vertex otherwise.
+			if (this->IsMerge(helperArray[prevVertex]))
+				this->AddDiagonal(i, helperArray[prevVertex]);
+			edgeSet.erase(prevVertex);
+
+			if (turn < 0)
+			{
+				int j = findLeftEdge(i);
+				if (j < 0)
+					return false;
+
+				if (this->IsMerge(helperArray[j]))
+					this->AddDiagonal(i, helperArray[j]);
+				helperArray[j] = i;
+			}
+		}
+		else if (nextBelow)
+		{
+			// The boundary is going down here, so the inside is to the right.
+			if (this->IsMerge(helperArray[prevVertex]))
+				this->AddDiagonal(i, helperArray[prevVertex]);
+			edgeSet.erase(prevVertex);
+
+			edgeSet.insert(i);
+			helperArray[i] = i;
+		}
+		else
+		{
+			// The boundary is going up here, so the inside is to the left.
+			int j = findLeftEdge(i);
+			if (j < 0)
+				return false;
+
+			if (this->IsMerge(helperArray[j]))
+				this->AddDiagonal(i, helperArray[j]);
+			helperArray[j] = i;
+		}
+	}
+
+	return true;
+}
+
+void PolygonTriangulator::AddDiagonal(int vertexA, int vertexB)
+{
+	this->diagonalArray->push_back(vertexA);
+	this->diagonalArray->push_back(vertexB);
+}
+
+// The diagonals cut the polygon up into monotone pieces, which we find by walking around them.  Each vertex's outgoing half-edges are
+// sorted by angle, so that to keep the piece on our left, we leave each vertex by the half-edge just clockwise of the one we came in on.
+bool PolygonTriangulator::TriangulatePieces(std::vector<int>& triangleArray)
+{
+	int vertexCount = this->vertexCount;
+	const std::vector<int>& diagonalArray = *this->diagonalArray;
+	std::vector<HalfEdge>& halfEdgeArray = *this->halfEdgeArray;
+
+	// The boundary half-edges going backward are outside the polygon, so we never start a walk on one of those.
+	halfEdgeArray.clear();
+	for (int i = 0; i < vertexCount; i++)
+	{
+		int j = (int)halfEdgeArray.size();
+		halfEdgeArray.push_back(HalfEdge{ i, j + 1, -1, false });
+		halfEdgeArray.push_back(HalfEdge{ (i + 1) % vertexCount, j, -1, true });
+	}
+
+	for (int i = 0; i < (int)diagonalArray.size(); i += 2)
+	{
+		int j = (int)halfEdgeArray.size();
+		halfEdgeArray.push_back(HalfEdge{ diagonalArray[i], j + 1, -1, false });
+		halfEdgeArray.push_back(HalfEdge{ diagonalArray[i + 1], j, -1, false });
+	}
+
+	std::vector<int>& slotOffsetArray = *this->slotOffsetArray;
+	slotOffsetArray.assign(vertexCount + 1, 0);
+	for (const HalfEdge& halfEdge : halfEdgeArray)
+		slotOffsetArray[halfEdge.vertex + 1]++;
+	for (int i = 0; i < vertexCount; i++)
+		slotOffsetArray[i + 1] += slotOffsetArray[i];
+
+	std::vector<int>& slotArray = *this->slotArray;
+	slotArray.resize(halfEdgeArray.size());
+	std::vector<int>& chainArray = *this->chainArray;
+	chainArray.assign(slotOffsetArray.begin(), slotOffsetArray.end() - 1);
+	for (int i = 0; i < (int)halfEdgeArray.size(); i++)
+		slotArray[chainArray[halfEdgeArray[i].vertex]++] = i;
+
+	// Only vertices with diagonals have more than the two boundary half-edges to put in order.
+	for (int i = 0; i < vertexCount; i++)
+	{
+		if (slotOffsetArray[i + 1] - slotOffsetArray[i] > 2)
+		{
+			std::sort(slotArray.begin() + slotOffsetArray[i], slotArray.begin() + slotOffsetArray[i + 1], [this, i, &halfEdgeArray](int halfEdgeA, int halfEdgeB) {
+				int vertexA = halfEdgeArray[halfEdgeArray[halfEdgeA].twin].vertex;
+				int vertexB = halfEdgeArray[halfEdgeArray[halfEdgeB].twin].vertex;
+				bool upperA = this->IsAbove(vertexA, i);
+				bool upperB = this->IsAbove(vertexB, i);
+				if (upperA != upperB)
+					return upperA;
+				return this->Orient(i, vertexA, vertexB) > 0;
+			});
+		}
+
+		for (int j = slotOffsetArray[i]; j < slotOffsetArray[i + 1]; j++)
+			halfEdgeArray[slotArray[j]].slot = j;
+	}
+
+	std::vector<int>& pieceArray = *this->pieceArray;
+	for (int i = 0; i < (int)halfEdgeArray.size(); i++)
+	{
+		if (halfEdgeArray[i].visited)
+			continue;
+
+		pieceArray.clear();
+		int j = i;
+		do
+		{
+			if (halfEdgeArray[j].visited || (int)pieceArray.size() >= vertexCount)
+				return false;
+
+			halfEdgeArray[j].visited = true;
+			pieceArray.push_back(halfEdgeArray[j].vertex);
+
+			const HalfEdge& twin = halfEdgeArray[halfEdgeArray[j].twin];
+			int slot = (twin.slot == slotOffsetArray[twin.vertex]) ? slotOffsetArray[twin.vertex + 1] - 1 : twin.slot - 1;
+			j = slotArray[slot];
+		} while (j != i);
+
+		this->TriangulateMonotonePiece(pieceArray, triangleArray);
+	}
+
+	return true;
+}
+
+// Go down the piece from top to bottom, merging its two sides as we go, and keep a stack of the vertices that can't be cut off yet,
+// which always make a reflex chain down one side.  Each new vertex either cuts off everything on the stack, if it's on the other side,
+// or as much of it as it can see, if it's on the same side.
+void PolygonTriangulator::TriangulateMonotonePiece(std::vector<int>& pieceVertexArray, std::vector<int>& triangleArray)
+{
+	int count = (int)pieceVertexArray.size();
+	if (count < 3)
+		return;
+
+	if (count == 3)
+	{
+		this->AddTriangle(pieceVertexArray[0], pieceVertexArray[1], pieceVertexArray[2], triangleArray);
+		return;
+	}
+
+	int top = 0, bottom = 0;
+	for (int i = 1; i < count; i++)
+	{
+		if (this->IsAbove(pieceVertexArray[i], pieceVertexArray[top]))
+			top = i;
+		if (this->IsAbove(pieceVertexArray[bottom], pieceVertexArray[i]))
+			bottom = i;
+	}
+
+	// Going forward from the top takes us down the left side, and going backward, down the right.
+	std::vector<int>& chainArray = *this->chainArray;
+	chainArray.resize(this->vertexCount);
+	std::vector<int>& sortedArray = *this->sweepArray;
+	sortedArray.clear();
+	sortedArray.push_back(pieceVertexArray[top]);
+
+	int left = (top + 1) % count;
+	int right = (top + count - 1) % count;
+	while (left != bottom || right != bottom)
+	{
+		if (right == bottom || (left != bottom && this->IsAbove(pieceVertexArray[left], pieceVertexArray[right])))
+		{
+			chainArray[pieceVertexArray[left]] = 0;
+			sortedArray.push_back(pieceVertexArray[left]);
+			left = (left + 1) % count;
+		}
+		else
+		{
+			chainArray[pieceVertexArray[right]] = 1;
+			sortedArray.push_back(pieceVertexArray[right]);
+			right = (right + count - 1) % count;
+		}
+	}
+
+	sortedArray.push_back(pieceVertexArray[bottom]);
+
+	std::vector<int>& stackArray = *this->stackArray;
+	stackArray.clear();
+	stackArray.push_back(sortedArray[0]);
+	stackArray.push_back(sortedArray[1]);
+
+	for (int i = 2; i < count - 1; i++)
+	{
+		int vertex = sortedArray[i];
+		if (chainArray[vertex] != chainArray[stackArray.back()])
+		{
+			for (int j = 0; j + 1 < (int)stackArray.size(); j++)
+				this->AddTriangle(vertex, stackArray[j], stackArray[j + 1], triangleArray);
+
+			int lastVertex = stackArray.back();
+			stackArray.clear();
+			stackArray.push_back(lastVertex);
+			stackArray.push_back(vertex);
+		}
+		else
+		{
+			int lastVertex = stackArray.back();
+			stackArray.pop_back();
+			while (stackArray.size() > 0)
+			{
+				// The diagonal to the next one down the stack has to be inside the piece.
+				int turn = this->Orient(vertex, lastVertex, stackArray.back());
+				if (chainArray[vertex] == 0 ? (turn >= 0) : (turn <= 0))
+					break;
+
+				this->AddTriangle(vertex, lastVertex, stackArray.back(), triangleArray);
+				lastVertex = stackArray.back();
+				stackArray.pop_back();
+			}
+
+			stackArray.push_back(lastVertex);
+			stackArray.push_back(vertex);
+		}
+	}
+
+	for (int j = 0; j + 1 < (int)stackArray.size(); j++)
+		this->AddTriangle(sortedArray[count - 1], stackArray[j], stackArray[j + 1], triangleArray);
+}
+
+// Each triangle is wound CCW in the projection, which is the way the polygon is wound.
+void PolygonTriangulator::AddTriangle(int vertexA, int vertexB, int vertexC, std::vector<int>& triangleArray) const
+{
+	if (this->Orient(vertexA, vertexB, vertexC) < 0)
+		std::swap(vertexB, vertexC);
+
+	triangleArray.push_back(vertexA);
+	triangleArray.push_back(vertexB);
+	triangleArray.push_back(vertexC);
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Defines.h"
+#include "Vector.h"
+#include <vector>
+
+namespace MeshWarrior
+{
+	// This cuts a planar polygon, convex or not, into triangles in O(n log n) time.  The polygon is projected
+	// onto whichever coordinate plane it is most nearly parallel to, cut up into pieces that are monotone in
+	// that plane by sweeping a line down across it, and then each piece is triangulated in a single pass from
+	// top to bottom.  Convex polygons are spotted up front and just stripped, as below.  All the decisions are made with
+	// exact predicates on the projected coordinates, which aren't rounded, since projecting just drops one.
+	// The scratch space is kept from one polygon to the next, so it pays to reuse a triangulator for many.
+	class MESH_WARRIOR_API PolygonTriangulator
+	{
+	public:
+		PolygonTriangulator();
+		virtual ~PolygonTriangulator();
+
+		// Each triangle comes out as three indices into the given points, wound the same way as the polygon.
+		// If the polygon is degenerate, or is found not to be simple, this gives back a fan instead, and returns false.
+		bool Triangulate(const std::vector<Vector>& pointArray, std::vector<int>& triangleArray);
+
+		// Pick the coordinate plane to project onto for a polygon with the given normal, ordering its axes
+		// so that the polygon, wound CCW about its normal, is still wound CCW in the projection.
+		static void ChooseProjectionAxes(const Vector& normal, int& axisU, int& axisV);
+
+		// This assumes the polygon is convex and cuts it into a strip that zig-zags across it, taking the
+		// shorter of the two possible diagonals at each step, which keeps the triangles better shaped than
+		// a fan would.  It takes linear time, and the triangles are wound the same way as the polygon.  Every
+		// vertex is used, and there are always n - 2 triangles, so where the polygon has a run of collinear
+		// vertices, some of the triangles along it can still have zero area, just as with a fan.
+		static void TriangulateConvex(const std::vector<Vector>& pointArray, std::vector<int>& triangleArray);
+
+	private:
+
+		// These are the half-edges of the polygon and of the diagonals cutting it up, for walking the pieces.
+		struct HalfEdge
+		{
+			int vertex;
+			int twin;
+			int slot;
+			bool visited;
+		};
+
+		class EdgeLess
+		{
+		public:
+			EdgeLess(const PolygonTriangulator* triangulator) : triangulator(triangulator) {}
+			bool operator()(int edgeA, int edgeB) const;
+
+		private:
+			const PolygonTriangulator* triangulator;
+		};
+
+		int Orient(int vertexA, int vertexB, int vertexC) const;
+		bool IsAbove(int vertexA, int vertexB) const;
+		bool TurnsLeftOnly() const;
+		static int CountReversals(const std::vector<double>& coordArray);
+		bool IsMerge(int vertex) const;
+		bool FindDiagonals();
+		void AddDiagonal(int vertexA, int vertexB);
+		bool TriangulatePieces(std::vector<int>& triangleArray);
+		void TriangulateMonotonePiece(std::vector<int>& pieceVertexArray, std::vector<int>& triangleArray);
+		void AddTriangle(int vertexA, int vertexB, int vertexC, std::vector<int>& triangleArray) const;
+
+		std::vector<double>* uArray;
+		std::vector<double>* vArray;
+		std::vector<int>* sweepArray;
+		std::vector<int>* diagonalArray;
+		std::vector<int>* helperArray;
+		std::vector<HalfEdge>* halfEdgeArray;
+		std::vector<int>* slotArray;
+		std::vector<int>* slotOffsetArray;
+		std::vector<int>* chainArray;
+		std::vector<int>* pieceArray;
+		std::vector<int>* stackArray;
+		int vertexCount;
+		int queryVertex;
+	};
+}
\ No newline at end of file
@@ -74,6 +74,12 @@ Polyline::Polyline()
 		}
 
 		return polyline;
+	}, [=](const Polyline* polyline, CompressorCell* cellArray) -> int {
+		// Polylines only ever join at their end-points, so that's all we need to bucket.
+		double cellSize = (eps > 0.0) ? eps : MW_EPS;
+		cellArray[0] = CompressorCell::FromPoint((*polyline->vertexArray)[0], cellSize);
+		cellArray[1] = CompressorCell::FromPoint((*polyline->vertexArray)[polyline->vertexArray->size() - 1], cellSize);
+		return 2;
 	});
 }
 
@@ -0,0 +1,366 @@
+#include "Predicates.h"
+#include "Shape.h"
+#include "VectorKernels.h"
+#include <math.h>
+#include <float.h>
+
+using namespace MeshWarrior;
+
+// These bound the rounding error of the floating-point evaluations relative to the
+// magnitudes of the terms involved.  They're a bit looser than Shewchuk's, which is fine.
+#define MW_ORIENT2D_ERROR_BOUND			(4.0 * DBL_EPSILON)
+#define MW_ORIENT3D_ERROR_BOUND			(4.0 * DBL_EPSILON)
+#define MW_PLANE_SIDE_ERROR_BOUND		(4.0 * DBL_EPSILON)
+
+// The batched plane side test works on this many points at a time.
+#define MW_PLANE_SIDE_BATCH_SIZE		64
+
+//--------------------------------- expansion arithmetic ---------------------------------
+
+// An expansion is an array of doubles whose exact sum is the value represented.  The
+// components are non-overlapping and ordered by increasing magnitude, so the sign of the
+// whole thing is the sign of its last component.  Zero components are harmless, but
+// we drop them as we go to keep things short.
+
+// Calculate x + y = a + b exactly.
+static inline void TwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	double bVirtual = x - a;
+	double aVirtual = x - bVirtual;
+	y = (a - aVirtual) + (b - bVirtual);
+}
+
+// Same as above, but only good when |a| >= |b|.
+static inline void FastTwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	y = b - (x - a);
+}
+
+// Calculate x + y = a - b exactly.
+static inline void TwoDiff(double a, double b, double& x, double& y)
+{
+	x = a - b;
+	double bVirtual = a - x;
+	double aVirtual = x + bVirtual;
+	y = (a - aVirtual) + (bVirtual - b);
+}
+
+// Calculate x + y = a * b exactly.  The fused multiply-add rounds only once, which is what makes this work.
+static inline void TwoProduct(double a, double b, double& x, double& y)
+{
+	x = a * b;
+	y = ::fma(a, b, -x);
+}
+
+static int GrowExpansion(int eLength, const double* e, double b, double* h)
+{
+	int hLength = 0;
+	double q = b;
+
+	for (int i = 0; i < eLength; i++)
+	{
+		double sum, error;
+		TwoSum(q, e[i], sum, error);
+		q = sum;
+		if (error != 0.0)
+			h[hLength++] = error;
+	}
+
+	if (q != 0.0 || hLength == 0)
+		h[hLength++] = q;
+
+	return hLength;
+}
+
+static int SumExpansions(int eLength, const double* e, int fLength, const double* f, double* h)
+{
+	double buffer[MW_PREDICATE_MAX_EXPANSION];
+
+	int hLength = eLength;
+	for (int i = 0; i < eLength; i++)
+		h[i] = e[i];
+
+	for (int i = 0; i < fLength; i++)
+	{
+		hLength = GrowExpansion(hLength, h, f[i], buffer);
+		for (int j = 0; j < hLength; j++)
+			h[j] = buffer[j];
+	}
+
+	return hLength;
+}
+
+static int ScaleExpansion(int eLength, const double* e, double b, double* h)
+{
+	int hLength = 0;
+	double q, error;
+
+	TwoProduct(e[0], b, q, error);
+	if (error != 0.0)
+		h[hLength++] = error;
+
+	for (int i = 1; i < eLength; i++)
+	{
+		double productHigh, productLow, sum;
+		TwoProduct(e[i], b, productHigh, productLow);
+		TwoSum(q, productLow, sum, error);
+		if (error != 0.0)
+			h[hLength++] = error;
+		FastTwoSum(productHigh, sum, q, error);
+		if (error != 0.0)
+			h[hLength++] = error;
+	}
+
+	if (q != 0.0 || hLength == 0)
+		h[hLength++] = q;
+
+	return hLength;
+}
+
+static int MultiplyExpansions(int eLength, const double* e, int fLength, const double* f, double* h)
+{
+	double product[MW_PREDICATE_MAX_EXPANSION];
+	double sum[MW_PREDICATE_MAX_EXPANSION];
+
+	int hLength = 1;
+	h[0] = 0.0;
+
+	for (int i = 0; i < fLength; i++)
+	{
+		int productLength = ScaleExpansion(eLength, e, f[i], product);
+		int sumLength = SumExpansions(hLength, h, productLength, product, sum);
+		for (int j = 0; j < sumLength; j++)
+			h[j] = sum[j];
+		hLength = sumLength;
+	}
+
+	return hLength;
+}
+
+static inline int ExpansionSign(int eLength, const double* e)
+{
+	double last = e[eLength - 1];
+	return (last > 0.0) ? 1 : ((last < 0.0) ? -1 : 0);
+}
+
+// Calculate a.y * b.z - a.z * b.y, say, exactly, where each coordinate is itself a two-component expansion.
+static int CrossComponent(const double* aFirst, const double* aSecond, const double* bFirst, const double* bSecond, double* h)
+{
+	double left[MW_PREDICATE_MAX_EXPANSION], right[MW_PREDICATE_MAX_EXPANSION];
+
+	int leftLength = MultiplyExpansions(2, aFirst, 2, bSecond, left);
+	int rightLength = MultiplyExpansions(2, aSecond, 2, bFirst, right);
+	for (int i = 0; i < rightLength; i++)
+		right[i] = -right[i];
+
+	return SumExpansions(leftLength, left, rightLength, right, h);
+}
+
+//--------------------------------- Predicates ---------------------------------
+
+/*static*/ int Predicates::Orient2D(double pointAX, double pointAY, double pointBX, double pointBY, double pointCX, double pointCY)
+{
+	double ux = pointBX - pointAX;
+	double uy = pointBY - pointAY;
+	double vx = pointCX - pointAX;
+	double vy = pointCY - pointAY;
+
+	double determinant = ux * vy - uy * vx;
+	double permanent = ::fabs(ux * vy) + ::fabs(uy * vx);
+
+	double errorBound = MW_ORIENT2D_ERROR_BOUND * permanent;
+	if (determinant > errorBound)
+		return 1;
+	if (determinant < -errorBound)
+		return -1;
+
+	double uxExact[2], uyExact[2], vxExact[2], vyExact[2];
+	TwoDiff(pointBX, pointAX, uxExact[1], uxExact[0]);
+	TwoDiff(pointBY, pointAY, uyExact[1], uyExact[0]);
+	TwoDiff(pointCX, pointAX, vxExact[1], vxExact[0]);
+	TwoDiff(pointCY, pointAY, vyExact[1], vyExact[0]);
+
+	double cross[MW_PREDICATE_MAX_EXPANSION];
+	int crossLength = CrossComponent(uxExact, uyExact, vxExact, vyExact, cross);
+	return ExpansionSign(crossLength, cross);
+}
+
+// This is for when the floating-point determinant is too close to zero to call.  The differences are
+// two-component expansions, so the longest anything gets here is 3 * 2 * 2 * (8 + 8) = 192 components.
+static int CalcExactOrient3D(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC, const Vector3& pointD)
+{
+	double ux[2], uy[2], uz[2], vx[2], vy[2], vz[2], wx[2], wy[2], wz[2];
+	TwoDiff(pointB.x, pointA.x, ux[1], ux[0]);
+	TwoDiff(pointB.y, pointA.y, uy[1], uy[0]);
+	TwoDiff(pointB.z, pointA.z, uz[1], uz[0]);
+	TwoDiff(pointC.x, pointA.x, vx[1], vx[0]);
+	TwoDiff(pointC.y, pointA.y, vy[1], vy[0]);
+	TwoDiff(pointC.z, pointA.z, vz[1], vz[0]);
+	TwoDiff(pointD.x, pointA.x, wx[1], wx[0]);
+	TwoDiff(pointD.y, pointA.y, wy[1], wy[0]);
+	TwoDiff(pointD.z, pointA.z, wz[1], wz[0]);
+
+	double cross[MW_PREDICATE_MAX_EXPANSION], term[MW_PREDICATE_MAX_EXPANSION];
+	double sum[MW_PREDICATE_MAX_EXPANSION], total[MW_PREDICATE_MAX_EXPANSION];
+	int crossLength, termLength, sumLength, totalLength;
+
+	crossLength = CrossComponent(uy, uz, vy, vz, cross);
+	totalLength = MultiplyExpansions(crossLength, cross, 2, wx, total);
+
+	crossLength = CrossComponent(uz, ux, vz, vx, cross);
+	termLength = MultiplyExpansions(crossLength, cross, 2, wy, term);
+	sumLength = SumExpansions(totalLength, total, termLength, term, sum);
+
+	crossLength = CrossComponent(ux, uy, vx, vy, cross);
+	termLength = MultiplyExpansions(crossLength, cross, 2, wz, term);
+	totalLength = SumExpansions(sumLength, sum, termLength, term, total);
+
+	return ExpansionSign(totalLength, total);
+}
+
+/*static*/ int Predicates::Orient3D(const Vector& pointA, const Vector& pointB, const Vector& pointC, const Vector& pointD)
+{
+	return Orient3D(Vector3(pointA), Vector3(pointB), Vector3(pointC), Vector3(pointD));
+}
+
+/*static*/ int Predicates::Orient3D(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC, const Vector3& pointD)
+{
+	double ux = pointB.x - pointA.x, uy = pointB.y - pointA.y, uz = pointB.z - pointA.z;
+	double vx = pointC.x - pointA.x, vy = pointC.y - pointA.y, vz = pointC.z - pointA.z;
+	double wx = pointD.x - pointA.x, wy = pointD.y - pointA.y, wz = pointD.z - pointA.z;
+
+	double uvx = uy * vz - uz * vy;
+	double uvy = uz * vx - ux * vz;
+	double uvz = ux * vy - uy * vx;
+	double determinant = wx * uvx + wy * uvy + wz * uvz;
+
+	double permanent =
+		::fabs(wx) * (::fabs(uy * vz) + ::fabs(uz * vy)) +
+		::fabs(wy) * (::fabs(uz * vx) + ::fabs(ux * vz)) +
+		::fabs(wz) * (::fabs(ux * vy) + ::fabs(uy * vx));
+
+	double errorBound = MW_ORIENT3D_ERROR_BOUND * permanent;
+	if (determinant > errorBound)
+		return 1;
+	if (determinant < -errorBound)
+		return -1;
+
+	return CalcExactOrient3D(pointA, pointB, pointC, pointD);
+}
+
+// This is the same as the above, up to the permanent, with every |D - A| term replaced by an upper bound on it,
+// which makes for a bigger error bound than is really needed for any given point, but one that works for all of them.
+/*static*/ void Predicates::MakeOrient3DPlane(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC, const Vector3& maxOffset, Orient3DPlane& plane)
+{
+	double ux = pointB.x - pointA.x, uy = pointB.y - pointA.y, uz = pointB.z - pointA.z;
+	double vx = pointC.x - pointA.x, vy = pointC.y - pointA.y, vz = pointC.z - pointA.z;
+
+	double permanent =
+		::fabs(maxOffset.x) * (::fabs(uy * vz) + ::fabs(uz * vy)) +
+		::fabs(maxOffset.y) * (::fabs(uz * vx) + ::fabs(ux * vz)) +
+		::fabs(maxOffset.z) * (::fabs(ux * vy) + ::fabs(uy * vx));
+
+	plane.pointA = pointA;
+	plane.cross = Vector3(uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx);
+	plane.errorBound = MW_ORIENT3D_ERROR_BOUND * permanent;
+}
+
+// Settle which side of the tolerance band about the plane the point is on from its floating-point distance, if the
+// rounding error allows it.  If it doesn't, we return false, and it's up to the caller to decide exactly.
+static inline bool PlaneSideFilter(double distance, double magnitude, double eps, int& side)
+{
+	double errorBound = MW_PLANE_SIDE_ERROR_BOUND * (magnitude + eps);
+	if (distance - eps > errorBound)
+		side = 1;
+	else if (distance + eps < -errorBound)
+		side = -1;
+	else if (::fabs(distance) < eps - errorBound)
+		side = 0;
+	else
+		return false;
+
+	return true;
+}
+
+// We're right on the edge of the tolerance band, so decide exactly which side of it we're on.
+// The distance expansion is 3 * 4 = 12 components at most, and the comparisons add just one more.
+static int PlaneSideExact(const Plane& plane, const Vector& point, double eps)
+{
+	double product[4], sum[MW_PREDICATE_MAX_EXPANSION], total[MW_PREDICATE_MAX_EXPANSION];
+	int productLength, sumLength, totalLength;
+	double difference[2];
+
+	TwoDiff(point.x, plane.center.x, difference[1], difference[0]);
+	totalLength = ScaleExpansion(2, difference, plane.unitNormal.x, total);
+
+	TwoDiff(point.y, plane.center.y, difference[1], difference[0]);
+	productLength = ScaleExpansion(2, difference, plane.unitNormal.y, product);
+	sumLength = SumExpansions(totalLength, total, productLength, product, sum);
+
+	TwoDiff(point.z, plane.center.z, difference[1], difference[0]);
+	productLength = ScaleExpansion(2, difference, plane.unitNormal.z, product);
+	totalLength = SumExpansions(sumLength, sum, productLength, product, total);
+
+	double comparison[MW_PREDICATE_MAX_EXPANSION];
+	int comparisonLength = GrowExpansion(totalLength, total, -eps, comparison);
+	if (ExpansionSign(comparisonLength, comparison) > 0)
+		return 1;
+
+	comparisonLength = GrowExpansion(totalLength, total, eps, comparison);
+	if (ExpansionSign(comparisonLength, comparison) < 0)
+		return -1;
+
+	return 0;
+}
+
+/*static*/ int Predicates::PlaneSide(const Plane& plane, const Vector& point, double eps /*= MW_EPS*/)
+{
+	Vector delta = point - plane.center;
+	double distance = Vector::Dot(delta, plane.unitNormal);
+
+	double magnitude =
+		::fabs(delta.x * plane.unitNormal.x) +
+		::fabs(delta.y * plane.unitNormal.y) +
+		::fabs(delta.z * plane.unitNormal.z);
+
+	int side = 0;
+	if (PlaneSideFilter(distance, magnitude, eps, side))
+		return side;
+
+	return PlaneSideExact(plane, point, eps);
+}
+
+// Single-precision points are promoted to double before anything is done with them, so they get the same exact answers.
+template<typename Real>
+static void PlaneSideArrayTemplate(const Plane& plane, const Real* pointArray, int stride, const int* indexArray, int count, int* sideArray, double eps)
+{
+	// The distances are found a batch at a time by the vector kernels, so as not to need any heap memory.
+	double distanceArray[MW_PLANE_SIDE_BATCH_SIZE], magnitudeArray[MW_PLANE_SIDE_BATCH_SIZE];
+
+	for (int begin = 0; begin < count; begin += MW_PLANE_SIDE_BATCH_SIZE)
+	{
+		int batchCount = MW_MIN(count - begin, MW_PLANE_SIDE_BATCH_SIZE);
+		VectorKernels::CalcPlaneDistances(plane, indexArray ? pointArray : &pointArray[begin * stride], indexArray ? &indexArray[begin] : nullptr, batchCount, distanceArray, magnitudeArray, stride);
+
+		for (int i = 0; i < batchCount; i++)
+		{
+			if (!PlaneSideFilter(distanceArray[i], magnitudeArray[i], eps, sideArray[begin + i]))
+			{
+				const Real* point = &pointArray[(indexArray ? indexArray[begin + i] : begin + i) * stride];
+				sideArray[begin + i] = PlaneSideExact(plane, Vector(point[0], point[1], point[2]), eps);
+			}
+		}
+	}
+}
+
+/*static*/ void Predicates::PlaneSideArray(const Plane& plane, const double* pointArray, int stride, const int* indexArray, int count, int* sideArray, double eps /*= MW_EPS*/)
+{
+	PlaneSideArrayTemplate(plane, pointArray, stride, indexArray, count, sideArray, eps);
+}
+
+/*static*/ void Predicates::PlaneSideArray(const Plane& plane, const float* pointArray, int stride, const int* indexArray, int count, int* sideArray, double eps /*= MW_EPS*/)
+{
+	PlaneSideArrayTemplate(plane, pointArray, stride, indexArray, count, sideArray, eps);
+}
\ No newline at end of file
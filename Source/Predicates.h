@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Defines.h"
+#include "Vector.h"
+#include "Vector3.h"
+
+// Exact arithmetic needs a buffer big enough for the longest expansion we can build.
+#define MW_PREDICATE_MAX_EXPANSION		256
+
+namespace MeshWarrior
+{
+	class Plane;
+
+	// These are geometric predicates in the style of Shewchuk's adaptive predicates.  Each
+	// one first evaluates its expression in ordinary floating-point along with a bound on the
+	// rounding error, and if that settles the answer (which is almost always), that's that.
+	// Otherwise, the expression is evaluated again exactly using floating-point expansions.
+	// Either way, the answer is the one that exact arithmetic on the given inputs would give,
+	// so it doesn't depend on the order in which things were computed, or by whom.
+	class MESH_WARRIOR_API Predicates
+	{
+	public:
+		// Return +1 if points A, B and C wind CCW in the plane, -1 if they wind CW, and 0 if they're collinear.
+		static int Orient2D(double pointAX, double pointAY, double pointBX, double pointBY, double pointCX, double pointCY);
+
+		// Return +1 if point D is on the side of the plane through points A, B and C that
+		// (B - A) x (C - A) points toward, -1 if it is on the other side, and 0 if it is on it.
+		// Note that this is opposite to the sign convention of Shewchuk's orient3d.
+		static int Orient3D(const Vector& pointA, const Vector& pointB, const Vector& pointC, const Vector& pointD);
+		static int Orient3D(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC, const Vector3& pointD);
+
+		// When many points, all within some known box, are tested against the same points A, B and C, most of the
+		// floating-point work of Orient3D, and a bound on its rounding error that holds for all of them, can be done
+		// once up front.  Then it takes only a dot product to settle all but the closest calls, and the answer is
+		// the same as Orient3D would give.  The offset bounds how far any point D can be from A along each axis.
+		struct Orient3DPlane
+		{
+			Vector3 pointA;
+			Vector3 cross;
+			double errorBound;
+		};
+
+		static void MakeOrient3DPlane(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC, const Vector3& maxOffset, Orient3DPlane& plane);
+		static int Orient3D(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC, const Orient3DPlane& plane, const Vector3& pointD)
+		{
+			double determinant = Vector3::Dot(pointD - plane.pointA, plane.cross);
+			if (determinant > plane.errorBound)
+				return 1;
+			if (determinant < -plane.errorBound)
+				return -1;
+
+			return Orient3D(pointA, pointB, pointC, pointD);
+		}
+
+		// Return +1 if the given point is further than the given distance in front of the given plane,
+		// -1 if it is further than that behind it, and 0 if it is within that distance of it.
+		static int PlaneSide(const Plane& plane, const Vector& point, double eps = MW_EPS);
+
+		// This is the same as the above, for each of an array of points, given as coordinates the given stride apart.
+		// If there's an index array, the i-th side is for the point at that index, and otherwise it's for the i-th point.
+		static void PlaneSideArray(const Plane& plane, const double* pointArray, int stride, const int* indexArray, int count, int* sideArray, double eps = MW_EPS);
+		static void PlaneSideArray(const Plane& plane, const float* pointArray, int stride, const int* indexArray, int count, int* sideArray, double eps = MW_EPS);
+	};
+}
\ No newline at end of file
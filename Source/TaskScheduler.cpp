@@ -0,0 +1,235 @@
+#include "TaskScheduler.h"
+
+using namespace MeshWarrior;
+
+static thread_local const TaskScheduler* currentScheduler = nullptr;
+static thread_local int currentWorkerIndex = -1;
+
+static std::mutex defaultSchedulerMutex;
+static TaskScheduler* defaultScheduler = nullptr;
+static int defaultThreadCount = 0;
+
+//--------------------------------- TaskScheduler ---------------------------------
+
+TaskScheduler::TaskScheduler(int threadCount /*= 0*/)
+{
+	this->workerArray = new std::vector<Worker*>();
+	this->queuedTaskCount = 0;
+	this->submitCursor = 0;
+	this->shuttingDown = false;
+
+	if (threadCount <= 0)
+		threadCount = MW_MAX((int)std::thread::hardware_concurrency(), 1);
+
+	for (int i = 0; i < threadCount - 1; i++)
+		this->workerArray->push_back(new Worker());
+
+	for (int i = 0; i < (int)this->workerArray->size(); i++)
+		(*this->workerArray)[i]->thread = std::thread([this, i]() { this->WorkerLoop(i); });
+}
+
+/*virtual*/ TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->shuttingDown = true;
+	}
+
+	this->sleepCondition.notify_all();
+
+	for (Worker* worker : *this->workerArray)
+	{
+		worker->thread.join();
+		delete worker;
+	}
+
+	delete this->workerArray;
+}
+
+/*static*/ TaskScheduler* TaskScheduler::GetDefault()
+{
+	std::lock_guard<std::mutex> lock(defaultSchedulerMutex);
+
+	// Note that this is never deleted.  Joining threads during static
+	// destruction (or worse, DLL unload) is more trouble than it's worth.
+	if (!defaultScheduler)
+		defaultScheduler = new TaskScheduler(defaultThreadCount);
+
+	return defaultScheduler;
+}
+
+/*static*/ bool TaskScheduler::SetDefaultThreadCount(int threadCount)
+{
+	std::lock_guard<std::mutex> lock(defaultSchedulerMutex);
+
+	if (defaultScheduler)
+		return false;
+
+	defaultThreadCount = threadCount;
+	return true;
+}
+
+int TaskScheduler::GetThreadCount() const
+{
+	return (int)this->workerArray->size() + 1;
+}
+
+int TaskScheduler::CurrentWorkerIndex() const
+{
+	return (currentScheduler == this) ? currentWorkerIndex : -1;
+}
+
+void TaskScheduler::Submit(const Task& task)
+{
+	int i = this->CurrentWorkerIndex();
+	if (i < 0)
+		i = (this->submitCursor++ & 0x7FFFFFFF) % (int)this->workerArray->size();
+
+	Worker* worker = (*this->workerArray)[i];
+
+	{
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		worker->taskQueue.push_back(task);
+	}
+
+	// Taking the sleep lock here makes sure that no worker can miss this wake-up call.
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->queuedTaskCount++;
+	}
+
+	this->sleepCondition.notify_one();
+}
+
+// Run a task from our own queue if we have one, or else steal one from someone else.
+bool TaskScheduler::RunOneTask()
+{
+	int workerCount = (int)this->workerArray->size();
+	int i = this->CurrentWorkerIndex();
+
+	Task task;
+	bool found = false;
+
+	if (i >= 0)
+	{
+		Worker* worker = (*this->workerArray)[i];
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		if (worker->taskQueue.size() > 0)
+		{
+			task = worker->taskQueue.back();
+			worker->taskQueue.pop_back();
+			found = true;
+		}
+	}
+
+	for (int j = 1; j <= workerCount && !found; j++)
+	{
+		Worker* victim = (*this->workerArray)[(MW_MAX(i, 0) + j) % workerCount];
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if (victim->taskQueue.size() > 0)
+		{
+			task = victim->taskQueue.front();
+			victim->taskQueue.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	this->queuedTaskCount--;
+	task.taskFunc();
+	task.taskGroup->pendingCount--;
+	return true;
+}
+
+void TaskScheduler::WorkerLoop(int workerIndex)
+{
+	currentScheduler = this;
+	currentWorkerIndex = workerIndex;
+
+	while (true)
+	{
+		if (this->RunOneTask())
+			continue;
+
+		std::unique_lock<std::mutex> lock(this->sleepMutex);
+		this->sleepCondition.wait(lock, [this]() { return this->shuttingDown || this->queuedTaskCount > 0; });
+		if (this->shuttingDown)
+			break;
+	}
+}
+
+void TaskScheduler::ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc, int grainSize /*= 0*/, int concurrency /*= 0*/)
+{
+	int count = end - begin;
+	if (count <= 0)
+		return;
+
+	int threadCount = this->GetThreadCount();
+	if (concurrency > 0)
+		threadCount = MW_MIN(threadCount, concurrency);
+
+	if (grainSize <= 0)
+		grainSize = MW_MAX(count / (threadCount * 8), 1);
+
+	int chunkCount = (count + grainSize - 1) / grainSize;
+	if (threadCount <= 1 || chunkCount <= 1)
+	{
+		rangeFunc(begin, end);
+		return;
+	}
+
+	// Rather than make a task per chunk, each thread keeps grabbing the next chunk until there are none left.
+	std::atomic<int> nextChunk(0);
+	auto chunkLoop = [&nextChunk, chunkCount, begin, end, grainSize, &rangeFunc]() {
+		while (true)
+		{
+			int chunk = nextChunk++;
+			if (chunk >= chunkCount)
+				break;
+
+			int chunkBegin = begin + chunk * grainSize;
+			rangeFunc(chunkBegin, MW_MIN(chunkBegin + grainSize, end));
+		}
+	};
+
+	TaskGroup taskGroup(this);
+	for (int i = 0; i < MW_MIN(threadCount, chunkCount) - 1; i++)
+		taskGroup.Run(chunkLoop);
+
+	chunkLoop();
+	taskGroup.Wait();
+}
+
+//--------------------------------- TaskGroup ---------------------------------
+
+TaskScheduler::TaskGroup::TaskGroup(TaskScheduler* scheduler /*= nullptr*/)
+{
+	this->scheduler = scheduler ? scheduler : TaskScheduler::GetDefault();
+	this->pendingCount = 0;
+}
+
+/*virtual*/ TaskScheduler::TaskGroup::~TaskGroup()
+{
+	this->Wait();
+}
+
+void TaskScheduler::TaskGroup::Run(std::function<void()> taskFunc)
+{
+	if (this->scheduler->workerArray->size() == 0)
+	{
+		taskFunc();
+		return;
+	}
+
+	this->pendingCount++;
+	this->scheduler->Submit(Task{ taskFunc, this });
+}
+
+void TaskScheduler::TaskGroup::Wait()
+{
+	while (this->pendingCount > 0)
+		if (!this->scheduler->RunOneTask())
+			std::this_thread::yield();
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Defines.h"
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace MeshWarrior
+{
+	// This is a small work-stealing thread pool.  Each worker thread has its own
+	// task queue, which it works from the back, and when that runs dry, it steals
+	// from the front of everyone else's.  A thread waiting on a task group pitches
+	// in rather than blocking, so task groups can be nested freely.  If the pool
+	// has only one thread, then everything just runs inline on the calling thread.
+	class MESH_WARRIOR_API TaskScheduler
+	{
+	public:
+		// The thread count includes the calling thread, so this spawns one fewer
+		// worker threads than asked for.  Zero means one per hardware thread.
+		TaskScheduler(int threadCount = 0);
+		virtual ~TaskScheduler();
+
+		// This is shared by anyone who doesn't have a scheduler of their own.
+		// Its size can only be changed before it is first used.
+		static TaskScheduler* GetDefault();
+		static bool SetDefaultThreadCount(int threadCount);
+
+		int GetThreadCount() const;
+
+		class MESH_WARRIOR_API TaskGroup
+		{
+			friend class TaskScheduler;
+
+		public:
+			TaskGroup(TaskScheduler* scheduler = nullptr);
+			virtual ~TaskGroup();
+
+			void Run(std::function<void()> taskFunc);
+			void Wait();
+
+		private:
+
+			TaskScheduler* scheduler;
+			std::atomic<int> pendingCount;
+		};
+
+		// Call the given function on consecutive sub-ranges of [begin, end) from up
+		// to the given number of threads at once, and return when all are done.
+		// A grain size of zero picks one that gives each thread several sub-ranges.
+		// A concurrency of zero means use as many threads as the pool has.
+		void ParallelFor(int begin, int end, std::function<void(int, int)> rangeFunc, int grainSize = 0, int concurrency = 0);
+
+	private:
+
+		struct Task
+		{
+			std::function<void()> taskFunc;
+			TaskGroup* taskGroup;
+		};
+
+		struct Worker
+		{
+			std::thread thread;
+			std::deque<Task> taskQueue;
+			std::mutex mutex;
+		};
+
+		void Submit(const Task& task);
+		bool RunOneTask();
+		void WorkerLoop(int workerIndex);
+		int CurrentWorkerIndex() const;
+
+		std::vector<Worker*>* workerArray;
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		std::atomic<int> queuedTaskCount;
+		std::atomic<int> submitCursor;
+		std::atomic<bool> shuttingDown;
+	};
+}
\ No newline at end of file
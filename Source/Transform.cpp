@@ -1,4 +1,5 @@
 #include "Transform.h"
+#include "VectorKernels.h"
 
 using namespace MeshWarrior;
 
@@ -32,6 +33,18 @@ Vector Transform::TransformPosition(const Vector& position) const
 	return result;
 }
 
+void Transform::TransformVectors(const Vector* inVectorArray, Vector* outVectorArray, int count) const
+{
+	if (count > 0)
+		VectorKernels::TransformVectors(this->matrix, &inVectorArray->x, &outVectorArray->x, count, MW_DOUBLE_STRIDE(Vector), MW_DOUBLE_STRIDE(Vector));
+}
+
+void Transform::TransformPositions(const Vector* inPositionArray, Vector* outPositionArray, int count) const
+{
+	if (count > 0)
+		VectorKernels::TransformPositions(*this, &inPositionArray->x, &outPositionArray->x, count, MW_DOUBLE_STRIDE(Vector), MW_DOUBLE_STRIDE(Vector));
+}
+
 bool Transform::SetInverse(const Transform& transform)
 {
 	if (!transform.matrix.GetInverse(this->matrix))
@@ -14,6 +14,10 @@ namespace MeshWarrior
 		
 		Vector TransformVector(const Vector& vector) const;
 		Vector TransformPosition(const Vector& position) const;
+
+		// These do the same as the above to whole arrays at once.  The input and output arrays may be the same.
+		void TransformVectors(const Vector* inVectorArray, Vector* outVectorArray, int count) const;
+		void TransformPositions(const Vector* inPositionArray, Vector* outPositionArray, int count) const;
 		
 		bool SetInverse(const Transform& transform);
 		bool GetInverse(Transform& transform) const;
@@ -0,0 +1,332 @@
+#include "TriangleMesh.h"
+#include "VectorKernels.h"
+#include "TaskScheduler.h"
+#include "Ray.h"
+#include <math.h>
+
+// Faces and vertices are worked on in parallel in runs of this many.
+#define MW_TRIANGLE_MESH_GRAIN_SIZE		4096
+
+using namespace MeshWarrior;
+
+// This reads a vertex position the same way whether or not the vertices are stored in single precision.
+static inline Vector3 LoadPoint(const Mesh::Vertex& vertex)
+{
+	return Vector3(vertex.point.x, vertex.point.y, vertex.point.z);
+}
+
+//--------------------------------- TriangleMesh ---------------------------------
+
+TriangleMesh::TriangleMesh()
+{
+	this->vertexArray = new std::vector<Mesh::Vertex>();
+	this->triangleArray = new std::vector<Triangle>();
+}
+
+/*virtual*/ TriangleMesh::~TriangleMesh()
+{
+	delete this->vertexArray;
+	delete this->triangleArray;
+}
+
+Mesh::Vertex* TriangleMesh::GetVertex(int i)
+{
+	if (!this->IsValidVertex(i))
+		return nullptr;
+
+	return &(*this->vertexArray)[i];
+}
+
+const Mesh::Vertex* TriangleMesh::GetVertex(int i) const
+{
+	return const_cast<TriangleMesh*>(this)->GetVertex(i);
+}
+
+bool TriangleMesh::IsValidVertex(int i) const
+{
+	return i >= 0 && i < (signed)this->vertexArray->size();
+}
+
+int TriangleMesh::GetNumVertices() const
+{
+	return (int)this->vertexArray->size();
+}
+
+TriangleMesh::Triangle* TriangleMesh::GetTriangle(int i)
+{
+	if (!this->IsValidTriangle(i))
+		return nullptr;
+
+	return &(*this->triangleArray)[i];
+}
+
+const TriangleMesh::Triangle* TriangleMesh::GetTriangle(int i) const
+{
+	return const_cast<TriangleMesh*>(this)->GetTriangle(i);
+}
+
+bool TriangleMesh::IsValidTriangle(int i) const
+{
+	return i >= 0 && i < (signed)this->triangleArray->size();
+}
+
+int TriangleMesh::GetNumTriangles() const
+{
+	return (int)this->triangleArray->size();
+}
+
+void TriangleMesh::Clear()
+{
+	this->vertexArray->clear();
+	this->triangleArray->clear();
+}
+
+int TriangleMesh::AddVertex(const Mesh::Vertex& vertex)
+{
+	this->vertexArray->push_back(vertex);
+	return (int)this->vertexArray->size() - 1;
+}
+
+bool TriangleMesh::AddTriangle(int vertexA, int vertexB, int vertexC)
+{
+	if (!this->IsValidVertex(vertexA) || !this->IsValidVertex(vertexB) || !this->IsValidVertex(vertexC))
+		return false;
+
+	Triangle triangle;
+	triangle.vertex[0] = vertexA;
+	triangle.vertex[1] = vertexB;
+	triangle.vertex[2] = vertexC;
+	this->triangleArray->push_back(triangle);
+	return true;
+}
+
+bool TriangleMesh::FromMesh(const Mesh* mesh)
+{
+	if (!mesh->IsTriangleMesh())
+		return false;
+
+	*this->name = *mesh->name;
+	*this->vertexArray = *mesh->vertexArray;
+	this->CopyFaces(mesh);
+	return true;
+}
+
+Mesh* TriangleMesh::ToMesh() const
+{
+	Mesh* mesh = new Mesh();
+	*mesh->name = *this->name;
+	*mesh->vertexArray = *this->vertexArray;
+	this->CopyFacesTo(mesh);
+	return mesh;
+}
+
+bool TriangleMesh::MoveFromMesh(Mesh* mesh)
+{
+	if (!mesh->IsTriangleMesh())
+		return false;
+
+	*this->name = *mesh->name;
+	this->vertexArray->clear();
+	this->vertexArray->swap(*mesh->vertexArray);
+	this->CopyFaces(mesh);
+	mesh->Clear();
+	return true;
+}
+
+Mesh* TriangleMesh::MoveToMesh()
+{
+	Mesh* mesh = new Mesh();
+	*mesh->name = *this->name;
+	mesh->vertexArray->swap(*this->vertexArray);
+	this->CopyFacesTo(mesh);
+	this->Clear();
+	return mesh;
+}
+
+void TriangleMesh::CopyFaces(const Mesh* mesh)
+{
+	this->triangleArray->resize(mesh->faceArray->size());
+
+	TaskScheduler::GetDefault()->ParallelFor(0, (int)this->triangleArray->size(), [this, mesh](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			const std::vector<int>& vertexArray = (*mesh->faceArray)[i].vertexArray;
+			Triangle& triangle = (*this->triangleArray)[i];
+			for (int j = 0; j < 3; j++)
+				triangle.vertex[j] = vertexArray[j];
+		}
+	}, MW_TRIANGLE_MESH_GRAIN_SIZE);
+}
+
+void TriangleMesh::CopyFacesTo(Mesh* mesh) const
+{
+	mesh->faceArray->resize(this->triangleArray->size());
+
+	TaskScheduler::GetDefault()->ParallelFor(0, (int)this->triangleArray->size(), [this, mesh](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			const Triangle& triangle = (*this->triangleArray)[i];
+			(*mesh->faceArray)[i].vertexArray.assign(triangle.vertex, triangle.vertex + 3);
+		}
+	}, MW_TRIANGLE_MESH_GRAIN_SIZE);
+}
+
+AxisAlignedBox TriangleMesh::CalcBoundingBox() const
+{
+	if (this->vertexArray->size() == 0)
+		return AxisAlignedBox();
+
+	return VectorKernels::CalcBoundingBox(&(*this->vertexArray)[0].point.x, (int)this->vertexArray->size(), MW_VERTEX_STRIDE);
+}
+
+void TriangleMesh::CalcFaceNormals(std::vector<Vector3>& normalArray) const
+{
+	normalArray.resize(this->triangleArray->size());
+
+	TaskScheduler::GetDefault()->ParallelFor(0, (int)this->triangleArray->size(), [this, &normalArray](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			const Triangle& triangle = (*this->triangleArray)[i];
+			Vector3 vertexA = LoadPoint((*this->vertexArray)[triangle.vertex[0]]);
+			Vector3 vertexB = LoadPoint((*this->vertexArray)[triangle.vertex[1]]);
+			Vector3 vertexC = LoadPoint((*this->vertexArray)[triangle.vertex[2]]);
+
+			Vector3 normal = (vertexB - vertexA) ^ (vertexC - vertexA);
+			double length = normal.Length();
+			normalArray[i] = (length > 0.0) ? normal / length : Vector3(0.0, 0.0, 0.0);
+		}
+	}, MW_TRIANGLE_MESH_GRAIN_SIZE);
+}
+
+void TriangleMesh::CalcVertexNormals()
+{
+	// The cross product of two edges is already as long as twice the area of the triangle, so summing
+	// those is what weights them by area.  This part scatters to the vertices, so it isn't done in parallel.
+	std::vector<Vector3> normalSumArray(this->vertexArray->size(), Vector3(0.0, 0.0, 0.0));
+	for (const Triangle& triangle : *this->triangleArray)
+	{
+		Vector3 vertexA = LoadPoint((*this->vertexArray)[triangle.vertex[0]]);
+		Vector3 vertexB = LoadPoint((*this->vertexArray)[triangle.vertex[1]]);
+		Vector3 vertexC = LoadPoint((*this->vertexArray)[triangle.vertex[2]]);
+
+		Vector3 normal = (vertexB - vertexA) ^ (vertexC - vertexA);
+		for (int j = 0; j < 3; j++)
+			normalSumArray[triangle.vertex[j]] = normalSumArray[triangle.vertex[j]] + normal;
+	}
+
+	TaskScheduler::GetDefault()->ParallelFor(0, (int)this->vertexArray->size(), [this, &normalSumArray](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			double length = normalSumArray[i].Length();
+			Vector3 normal = (length > 0.0) ? normalSumArray[i] / length : Vector3(0.0, 0.0, 0.0);
+			(*this->vertexArray)[i].normal = normal.ToVector();
+		}
+	}, MW_TRIANGLE_MESH_GRAIN_SIZE);
+}
+
+void TriangleMesh::CalcAdjacency(std::vector<int>& neighborArray) const
+{
+	int vertexCount = (int)this->vertexArray->size();
+	int triangleCount = (int)this->triangleArray->size();
+
+	// Sort the edges by the vertex they start from, so that the ones going back the other way can be
+	// found among those leaving the far end of each edge.  Edge j of triangle i is numbered 3i + j.
+	std::vector<int> offsetArray(vertexCount + 1, 0);
+	for (const Triangle& triangle : *this->triangleArray)
+		for (int j = 0; j < 3; j++)
+			offsetArray[triangle.vertex[j] + 1]++;
+
+	for (int i = 0; i < vertexCount; i++)
+		offsetArray[i + 1] += offsetArray[i];
+
+	std::vector<int> edgeArray(3 * triangleCount);
+	std::vector<int> cursorArray(offsetArray.begin(), offsetArray.end() - 1);
+	for (int i = 0; i < triangleCount; i++)
+		for (int j = 0; j < 3; j++)
+			edgeArray[cursorArray[(*this->triangleArray)[i].vertex[j]]++] = 3 * i + j;
+
+	neighborArray.resize(3 * triangleCount);
+
+	TaskScheduler::GetDefault()->ParallelFor(0, triangleCount, [this, &offsetArray, &edgeArray, &neighborArray](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			const Triangle& triangle = (*this->triangleArray)[i];
+			for (int j = 0; j < 3; j++)
+			{
+				int vertexA = triangle.vertex[j];
+				int vertexB = triangle.vertex[(j + 1) % 3];
+
+				int neighbor = -1;
+				int matchCount = 0;
+				for (int k = offsetArray[vertexB]; k < offsetArray[vertexB + 1]; k++)
+				{
+					int edge = edgeArray[k];
+					const Triangle& otherTriangle = (*this->triangleArray)[edge / 3];
+					if (otherTriangle.vertex[(edge % 3 + 1) % 3] == vertexA)
+					{
+						neighbor = edge / 3;
+						matchCount++;
+					}
+				}
+
+				neighborArray[3 * i + j] = (matchCount == 1) ? neighbor : -1;
+			}
+		}
+	}, MW_TRIANGLE_MESH_GRAIN_SIZE);
+}
+
+bool TriangleMesh::RayCast(const Ray& ray, double& rayAlpha, int* triangleIndex /*= nullptr*/) const
+{
+	Vector3 rayOrigin(ray.origin);
+	Vector3 rayDirection(ray.direction);
+
+	int hitTriangle = -1;
+	for (int i = 0; i < (int)this->triangleArray->size(); i++)
+	{
+		const Triangle& triangle = (*this->triangleArray)[i];
+		Vector3 vertexA = LoadPoint((*this->vertexArray)[triangle.vertex[0]]);
+		Vector3 vertexB = LoadPoint((*this->vertexArray)[triangle.vertex[1]]);
+		Vector3 vertexC = LoadPoint((*this->vertexArray)[triangle.vertex[2]]);
+
+		double triangleRayAlpha = 0.0;
+		if (RayCastTriangle(rayOrigin, rayDirection, vertexA, vertexB, vertexC, triangleRayAlpha) && (hitTriangle < 0 || triangleRayAlpha < rayAlpha))
+		{
+			hitTriangle = i;
+			rayAlpha = triangleRayAlpha;
+		}
+	}
+
+	if (hitTriangle >= 0 && triangleIndex)
+		*triangleIndex = hitTriangle;
+
+	return hitTriangle >= 0;
+}
+
+/*static*/ bool TriangleMesh::RayCastTriangle(const Vector3& rayOrigin, const Vector3& rayDirection, const Vector3& vertexA, const Vector3& vertexB, const Vector3& vertexC, double& rayAlpha)
+{
+	// Solve origin + alpha * direction = A + u * (B - A) + v * (C - A) by Cramer's rule, bailing
+	// out as soon as u or v shows the ray passes outside the triangle.  The determinant is zero
+	// when the ray runs parallel to the triangle.
+	Vector3 edgeAB = vertexB - vertexA;
+	Vector3 edgeAC = vertexC - vertexA;
+
+	Vector3 p = rayDirection ^ edgeAC;
+	double determinant = Vector3::Dot(edgeAB, p);
+	if (determinant == 0.0)
+		return false;
+
+	double inverseDeterminant = 1.0 / determinant;
+
+	Vector3 t = rayOrigin - vertexA;
+	double u = Vector3::Dot(t, p) * inverseDeterminant;
+	if (u < 0.0 || u > 1.0)
+		return false;
+
+	Vector3 q = t ^ edgeAB;
+	double v = Vector3::Dot(rayDirection, q) * inverseDeterminant;
+	if (v < 0.0 || u + v > 1.0)
+		return false;
+
+	rayAlpha = Vector3::Dot(edgeAC, q) * inverseDeterminant;
+	return rayAlpha > 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "FileObject.h"
+#include "Mesh.h"
+#include "Vector3.h"
+#include "AxisAlignedBox.h"
+#include <vector>
+
+namespace MeshWarrior
+{
+	class Ray;
+
+	// This is a mesh made of nothing but triangles, which is what most meshes are.  Each face is just three
+	// vertex indices stored inline, so there's no allocation per face, and every loop over the corners of a
+	// face runs exactly three times.  The vertices are the same as those of a Mesh, so converting between
+	// the two can hand the vertex array over as it is, leaving only the faces to be repacked.
+	class MESH_WARRIOR_API TriangleMesh : public FileObject
+	{
+	public:
+		TriangleMesh();
+		virtual ~TriangleMesh();
+
+		// These are wound CCW when viewing the front side of the face.
+		// Edge i of a triangle goes from its vertex i to its vertex i + 1.
+		struct Triangle
+		{
+			int vertex[3];
+		};
+
+		Mesh::Vertex* GetVertex(int i);
+		const Mesh::Vertex* GetVertex(int i) const;
+		bool IsValidVertex(int i) const;
+		int GetNumVertices() const;
+
+		Triangle* GetTriangle(int i);
+		const Triangle* GetTriangle(int i) const;
+		bool IsValidTriangle(int i) const;
+		int GetNumTriangles() const;
+
+		void Clear();
+		int AddVertex(const Mesh::Vertex& vertex);
+		bool AddTriangle(int vertexA, int vertexB, int vertexC);
+
+		// This fails, leaving this mesh alone, if the given mesh has any face that isn't a triangle.
+		// In that case, see Mesh::GenerateTriangleMesh.
+		bool FromMesh(const Mesh* mesh);
+		Mesh* ToMesh() const;
+
+		// These are the same, except that the vertex array is taken from the mesh being converted
+		// instead of copied, and that mesh is left empty.
+		bool MoveFromMesh(Mesh* mesh);
+		Mesh* MoveToMesh();
+
+		AxisAlignedBox CalcBoundingBox() const;
+
+		// Give the unit normal of each triangle, or zero for one that has no area.
+		void CalcFaceNormals(std::vector<Vector3>& normalArray) const;
+
+		// Set the normal of each vertex to the average of the normals of the triangles around it, weighted by their areas.
+		void CalcVertexNormals();
+
+		// For edge j of triangle i, give at 3i + j the triangle on the other side of it, which is the one having
+		// the same edge the other way around.  This is -1 where there is no such triangle, or more than one.
+		void CalcAdjacency(std::vector<int>& neighborArray) const;
+
+		// Find the nearest triangle hit in front of the ray origin, if any.  Every triangle is tested, so
+		// to cast many rays at the same mesh, a MeshVolume, which sorts the faces into a tree, is faster.
+		bool RayCast(const Ray& ray, double& rayAlpha, int* triangleIndex = nullptr) const;
+
+		// This is the Moller-Trumbore test, which works straight from the corners, without finding the plane
+		// of the triangle first.  Either side of the triangle can be hit, and so can its edges.
+		static bool RayCastTriangle(const Vector3& rayOrigin, const Vector3& rayDirection, const Vector3& vertexA, const Vector3& vertexB, const Vector3& vertexC, double& rayAlpha);
+
+	private:
+
+		void CopyFaces(const Mesh* mesh);
+		void CopyFacesTo(Mesh* mesh) const;
+
+		std::vector<Mesh::Vertex>* vertexArray;
+		std::vector<Triangle>* triangleArray;
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Defines.h"
 #include <vector>
+#include <new>
 #include <assert.h>
 
 namespace MeshWarrior
@@ -50,6 +51,7 @@ namespace MeshWarrior
 
 			this->memorySize = stackSize * sizeof(Type);
 			this->memory = new char[this->memorySize];
+			this->peakCount = 0;
 		}
 
 		virtual ~StackHeap()
@@ -68,6 +70,11 @@ namespace MeshWarrior
 
 			int i = *this->stack->rbegin();
 			this->stack->pop_back();
+
+			int count = this->memorySize / sizeof(Type) - (int)this->stack->size();
+			if (count > this->peakCount)
+				this->peakCount = count;
+
 			int j = i * sizeof(Type);
 			Type* type = reinterpret_cast<Type*>(&this->memory[j]);
 			new (type) Type();
@@ -86,10 +93,115 @@ namespace MeshWarrior
 			}
 		}
 
+		// This is the most memory that was ever in use at once.
+		size_t GetPeakBytes() const
+		{
+			return this->peakCount * sizeof(Type);
+		}
+
 	private:
 
 		char* memory;
 		int memorySize;
+		int peakCount;
 		std::vector<int>* stack;
 	};
+	// This heap hands out members from big chunks (slabs) of memory and recycles them through
+	// a free-list threaded through the unused members themselves, so once it has grown to the
+	// size needed, allocation never touches the system heap.  Unlike the stack heap, it grows
+	// as needed.  For a given sequence of allocations and deallocations, members are always
+	// handed out in the same order from the same slots, so set iteration stays reproducible
+	// across runs, at least within a slab.  This makes it usable in both debug and release.
+	template<typename Type>
+	class MESH_WARRIOR_API SlabHeap : public TypeHeap<Type>
+	{
+	public:
+		SlabHeap(int slabSize = 4096)
+		{
+			this->slabArray = new std::vector<char*>();
+			this->slabSize = slabSize;
+			this->slabIndex = 0;
+			this->slabCursor = 0;
+			this->freeList = nullptr;
+
+			// Each slot must be big enough to hold a free-list link when not in use.
+			this->slotSize = sizeof(Type) > sizeof(FreeSlot) ? sizeof(Type) : sizeof(FreeSlot);
+			this->slotSize = (this->slotSize + alignof(Type) - 1) / alignof(Type) * alignof(Type);
+		}
+
+		virtual ~SlabHeap()
+		{
+			for (char* slab : *this->slabArray)
+				delete[] slab;
+
+			delete this->slabArray;
+		}
+
+		virtual Type* Allocate() override
+		{
+			void* memory = nullptr;
+
+			if (this->freeList)
+			{
+				memory = this->freeList;
+				this->freeList = this->freeList->next;
+			}
+			else
+			{
+				if (this->slabCursor == this->slabSize)
+				{
+					this->slabIndex++;
+					this->slabCursor = 0;
+				}
+
+				if (this->slabIndex == (signed)this->slabArray->size())
+					this->slabArray->push_back(new char[this->slabSize * this->slotSize]);
+
+				memory = &(*this->slabArray)[this->slabIndex][this->slabCursor++ * this->slotSize];
+			}
+
+			return new (memory) Type();
+		}
+
+		virtual void Deallocate(Type* type) override
+		{
+			type->~Type();
+
+			FreeSlot* freeSlot = reinterpret_cast<FreeSlot*>(type);
+			freeSlot->next = this->freeList;
+			this->freeList = freeSlot;
+		}
+
+		// Forget every allocation in constant time, keeping the slabs around for reuse.
+		// Note that destructors are not called here, so any member still in use should
+		// be deallocated first if it owns anything.
+		void Reset()
+		{
+			this->slabIndex = 0;
+			this->slabCursor = 0;
+			this->freeList = nullptr;
+		}
+
+		// This is the most memory that was in use at once since the last reset.  Freed members
+		// are always recycled before any new ones are carved out of the slabs, so it's just the
+		// number of members carved out so far.
+		size_t GetPeakBytes() const
+		{
+			return size_t(this->slabIndex * this->slabSize + this->slabCursor) * this->slotSize;
+		}
+
+	private:
+
+		struct FreeSlot
+		{
+			FreeSlot* next;
+		};
+
+		std::vector<char*>* slabArray;
+		int slabSize;
+		int slabIndex;
+		int slabCursor;
+		int slotSize;
+		FreeSlot* freeList;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "Defines.h"
+#include "Vector.h"
+#include "AxisAlignedBox.h"
+#include "Shape.h"
+#include <math.h>
+#include <type_traits>
+
+namespace MeshWarrior
+{
+	// Vector has a virtual destructor, and the shapes are all polymorphic, so every one of them drags a
+	// vtable pointer around, can't be memcpy'd, and costs a constructor call every time a temporary is
+	// made.  These are plain-old-data stand-ins for the inner loops where that adds up.  Everything here
+	// is inline, and does exactly the same arithmetic, in the same order, as the corresponding method
+	// of the real thing, so switching a loop over to these doesn't change its results in the least.
+	struct Vector3
+	{
+		Vector3() = default;
+		constexpr Vector3(double x, double y, double z) : x(x), y(y), z(z) {}
+		explicit Vector3(const Vector& vector) : x(vector.x), y(vector.y), z(vector.z) {}
+
+		Vector ToVector() const { return Vector(this->x, this->y, this->z); }
+
+		static constexpr double Dot(const Vector3& vectorA, const Vector3& vectorB)
+		{
+			return vectorA.x * vectorB.x + vectorA.y * vectorB.y + vectorA.z * vectorB.z;
+		}
+
+		static constexpr Vector3 Cross(const Vector3& vectorA, const Vector3& vectorB)
+		{
+			return Vector3(
+				vectorA.y * vectorB.z - vectorA.z * vectorB.y,
+				vectorA.z * vectorB.x - vectorA.x * vectorB.z,
+				vectorA.x * vectorB.y - vectorA.y * vectorB.x);
+		}
+
+		static constexpr Vector3 Min(const Vector3& vectorA, const Vector3& vectorB)
+		{
+			return Vector3(MW_MIN(vectorA.x, vectorB.x), MW_MIN(vectorA.y, vectorB.y), MW_MIN(vectorA.z, vectorB.z));
+		}
+
+		static constexpr Vector3 Max(const Vector3& vectorA, const Vector3& vectorB)
+		{
+			return Vector3(MW_MAX(vectorA.x, vectorB.x), MW_MAX(vectorA.y, vectorB.y), MW_MAX(vectorA.z, vectorB.z));
+		}
+
+		double Length() const { return ::sqrt(Dot(*this, *this)); }
+
+		double x, y, z;
+	};
+
+	constexpr Vector3 operator+(const Vector3& vectorA, const Vector3& vectorB)
+	{
+		return Vector3(vectorA.x + vectorB.x, vectorA.y + vectorB.y, vectorA.z + vectorB.z);
+	}
+
+	constexpr Vector3 operator-(const Vector3& vectorA, const Vector3& vectorB)
+	{
+		return Vector3(vectorA.x - vectorB.x, vectorA.y - vectorB.y, vectorA.z - vectorB.z);
+	}
+
+	constexpr Vector3 operator^(const Vector3& vectorA, const Vector3& vectorB)
+	{
+		return Vector3::Cross(vectorA, vectorB);
+	}
+
+	constexpr Vector3 operator*(const Vector3& vector, double scalar)
+	{
+		return Vector3(vector.x * scalar, vector.y * scalar, vector.z * scalar);
+	}
+
+	constexpr Vector3 operator/(const Vector3& vector, double scalar)
+	{
+		return Vector3(vector.x / scalar, vector.y / scalar, vector.z / scalar);
+	}
+
+	// Unlike AxisAlignedBox, there's no default box here that means "nothing yet."  Start with the first point instead.
+	struct Box3
+	{
+		Box3() = default;
+		constexpr Box3(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+		explicit Box3(const AxisAlignedBox& box) : min(box.min), max(box.max) {}
+
+		AxisAlignedBox ToAxisAlignedBox() const { return AxisAlignedBox(this->min.ToVector(), this->max.ToVector()); }
+
+		constexpr bool ContainsPoint(const Vector3& point) const
+		{
+			return
+				this->min.x <= point.x && point.x <= this->max.x &&
+				this->min.y <= point.y && point.y <= this->max.y &&
+				this->min.z <= point.z && point.z <= this->max.z;
+		}
+
+		constexpr bool ContainsBox(const Box3& box) const
+		{
+			return this->ContainsPoint(box.min) && this->ContainsPoint(box.max);
+		}
+
+		// This is true when the intersection of the two boxes would be valid, touching included.
+		constexpr bool OverlapsWith(const Box3& box) const
+		{
+			return
+				MW_MAX(this->min.x, box.min.x) <= MW_MIN(this->max.x, box.max.x) &&
+				MW_MAX(this->min.y, box.min.y) <= MW_MIN(this->max.y, box.max.y) &&
+				MW_MAX(this->min.z, box.min.z) <= MW_MIN(this->max.z, box.max.z);
+		}
+
+		void ExpandToContainPoint(const Vector3& point)
+		{
+			this->min = Vector3::Min(this->min, point);
+			this->max = Vector3::Max(this->max, point);
+		}
+
+		Vector3 min, max;
+	};
+
+	struct Plane3
+	{
+		Plane3() = default;
+		constexpr Plane3(const Vector3& center, const Vector3& unitNormal) : center(center), unitNormal(unitNormal) {}
+		explicit Plane3(const Plane& plane) : center(plane.center), unitNormal(plane.unitNormal) {}
+
+		// The normal is taken as given, so it had better be unit-length already.
+		Plane ToPlane() const
+		{
+			Plane plane;
+			plane.center = this->center.ToVector();
+			plane.unitNormal = this->unitNormal.ToVector();
+			return plane;
+		}
+
+		constexpr double ShortestSignedDistanceToPoint(const Vector3& point) const
+		{
+			return Vector3::Dot(point - this->center, this->unitNormal);
+		}
+
+		Vector3 center, unitNormal;
+	};
+
+	// This keeps a vector in single precision, for when memory matters more than the last few digits, as
+	// with mesh vertices when MW_SINGLE_PRECISION_VERTICES is set.  Unlike the others here, it converts to
+	// and from Vector implicitly, so that it can stand in for one wherever a vertex attribute is read or
+	// written.  The math is all still done in double precision; only the storage is rounded.
+	struct Vector3f
+	{
+		Vector3f() : x(0.0f), y(0.0f), z(0.0f) {}
+		constexpr Vector3f(float x, float y, float z) : x(x), y(y), z(z) {}
+		Vector3f(const Vector& vector) : x(float(vector.x)), y(float(vector.y)), z(float(vector.z)) {}
+
+		operator Vector() const { return Vector(this->x, this->y, this->z); }
+
+		float x, y, z;
+	};
+
+	static_assert(std::is_trivially_copyable<Vector3>::value && std::is_standard_layout<Vector3>::value && sizeof(Vector3) == 3 * sizeof(double), "Vector3 must be plain old data.");
+	static_assert(std::is_trivially_copyable<Box3>::value && std::is_standard_layout<Box3>::value, "Box3 must be plain old data.");
+	static_assert(std::is_trivially_copyable<Plane3>::value && std::is_standard_layout<Plane3>::value, "Plane3 must be plain old data.");
+	static_assert(std::is_trivially_copyable<Vector3f>::value && sizeof(Vector3f) == 3 * sizeof(float), "Vector3f must be plain old data.");
+}
\ No newline at end of file
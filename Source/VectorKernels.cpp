@@ -0,0 +1,397 @@
+#include "VectorKernels.h"
+#include "Vector.h"
+#include "Shape.h"
+#include "Transform.h"
+#include <math.h>
+#include <float.h>
+
+#if defined MW_VECTOR_KERNELS_AVX2
+#	include <immintrin.h>
+#elif defined MW_VECTOR_KERNELS_SSE2
+#	include <emmintrin.h>
+#endif
+
+using namespace MeshWarrior;
+
+//--------------------------------- scalar kernels ---------------------------------
+
+// These handle every case the vectorized kernels don't, including the left-over points at the end of an array.
+
+template<typename Real>
+static void CalcBoundingBoxScalar(const Real* pointArray, int count, int stride, double* min, double* max)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const Real* point = &pointArray[i * stride];
+		for (int j = 0; j < 3; j++)
+		{
+			min[j] = MW_MIN(min[j], double(point[j]));
+			max[j] = MW_MAX(max[j], double(point[j]));
+		}
+	}
+}
+
+// The terms are summed in the same order as Vector::Dot sums them, so that the results agree with Transform's to the bit.
+template<typename Real>
+static void TransformScalar(const Matrix3x3& matrix, const Vector& translation, const Real* inPointArray, Real* outPointArray, int count, int inStride, int outStride)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const Real* inPoint = &inPointArray[i * inStride];
+		double x = inPoint[0], y = inPoint[1], z = inPoint[2];
+
+		Real* outPoint = &outPointArray[i * outStride];
+		outPoint[0] = Real(x * matrix.ele[0][0] + y * matrix.ele[0][1] + z * matrix.ele[0][2] + translation.x);
+		outPoint[1] = Real(x * matrix.ele[1][0] + y * matrix.ele[1][1] + z * matrix.ele[1][2] + translation.y);
+		outPoint[2] = Real(x * matrix.ele[2][0] + y * matrix.ele[2][1] + z * matrix.ele[2][2] + translation.z);
+	}
+}
+
+template<typename Real>
+static void CalcPlaneDistancesScalar(const Plane& plane, const Real* pointArray, const int* indexArray, int begin, int end, double* distanceArray, double* magnitudeArray, int stride)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const Real* point = &pointArray[(indexArray ? indexArray[i] : i) * stride];
+
+		double termX = (point[0] - plane.center.x) * plane.unitNormal.x;
+		double termY = (point[1] - plane.center.y) * plane.unitNormal.y;
+		double termZ = (point[2] - plane.center.z) * plane.unitNormal.z;
+
+		distanceArray[i] = termX + termY + termZ;
+		magnitudeArray[i] = ::fabs(termX) + ::fabs(termY) + ::fabs(termZ);
+	}
+}
+
+// A length of zero gives an infinite scale, and that, like a NaN, fails the comparison.
+template<typename Real>
+static void NormalizeScalar(Real* vectorArray, int begin, int end, int stride)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Real* vector = &vectorArray[i * stride];
+		double x = vector[0], y = vector[1], z = vector[2];
+		double scale = 1.0 / ::sqrt(x * x + y * y + z * z);
+		if (scale <= DBL_MAX)
+		{
+			vector[0] = Real(x * scale);
+			vector[1] = Real(y * scale);
+			vector[2] = Real(z * scale);
+		}
+	}
+}
+
+//--------------------------------- VectorKernels ---------------------------------
+
+/*static*/ AxisAlignedBox VectorKernels::CalcBoundingBox(const double* pointArray, int count, int stride /*= 3*/)
+{
+	if (count <= 0)
+		return AxisAlignedBox();
+
+	double min[3] = { pointArray[0], pointArray[1], pointArray[2] };
+	double max[3] = { pointArray[0], pointArray[1], pointArray[2] };
+
+#if defined MW_VECTOR_KERNELS_AVX2
+	// Each point goes in one register, with the fourth lane masked off so that we never read past the end.
+	__m256i mask = _mm256_set_epi64x(0, -1, -1, -1);
+	__m256d minVector = _mm256_maskload_pd(pointArray, mask);
+	__m256d maxVector = minVector;
+
+	for (int i = 1; i < count; i++)
+	{
+		__m256d point = _mm256_maskload_pd(&pointArray[i * stride], mask);
+		minVector = _mm256_min_pd(minVector, point);
+		maxVector = _mm256_max_pd(maxVector, point);
+	}
+
+	double minLanes[4], maxLanes[4];
+	_mm256_storeu_pd(minLanes, minVector);
+	_mm256_storeu_pd(maxLanes, maxVector);
+
+	for (int j = 0; j < 3; j++)
+	{
+		min[j] = minLanes[j];
+		max[j] = maxLanes[j];
+	}
+#elif defined MW_VECTOR_KERNELS_SSE2
+	__m128d minXY = _mm_loadu_pd(pointArray), maxXY = minXY;
+	__m128d minZ = _mm_load_sd(&pointArray[2]), maxZ = minZ;
+
+	for (int i = 1; i < count; i++)
+	{
+		const double* point = &pointArray[i * stride];
+		__m128d pointXY = _mm_loadu_pd(point);
+		__m128d pointZ = _mm_load_sd(&point[2]);
+		minXY = _mm_min_pd(minXY, pointXY);
+		maxXY = _mm_max_pd(maxXY, pointXY);
+		minZ = _mm_min_sd(minZ, pointZ);
+		maxZ = _mm_max_sd(maxZ, pointZ);
+	}
+
+	_mm_storeu_pd(min, minXY);
+	_mm_storeu_pd(max, maxXY);
+	_mm_store_sd(&min[2], minZ);
+	_mm_store_sd(&max[2], maxZ);
+#else
+	CalcBoundingBoxScalar(pointArray, count, stride, min, max);
+#endif
+
+	return AxisAlignedBox(Vector(min[0], min[1], min[2]), Vector(max[0], max[1], max[2]));
+}
+
+/*static*/ AxisAlignedBox VectorKernels::CalcBoundingBox(const float* pointArray, int count, int stride /*= 3*/)
+{
+	if (count <= 0)
+		return AxisAlignedBox();
+
+	double min[3] = { pointArray[0], pointArray[1], pointArray[2] };
+	double max[3] = { pointArray[0], pointArray[1], pointArray[2] };
+	CalcBoundingBoxScalar(pointArray, count, stride, min, max);
+
+	return AxisAlignedBox(Vector(min[0], min[1], min[2]), Vector(max[0], max[1], max[2]));
+}
+
+/*static*/ void VectorKernels::TransformPositions(const Transform& transform, const double* inPointArray, double* outPointArray, int count, int inStride /*= 3*/, int outStride /*= 3*/)
+{
+	const Matrix3x3& matrix = transform.matrix;
+	const Vector& translation = transform.translation;
+
+#if defined MW_VECTOR_KERNELS_AVX2
+	// The columns of the matrix get scaled by the coordinates of each point and added up.
+	__m256i mask = _mm256_set_epi64x(0, -1, -1, -1);
+	__m256d columnX = _mm256_set_pd(0.0, matrix.ele[2][0], matrix.ele[1][0], matrix.ele[0][0]);
+	__m256d columnY = _mm256_set_pd(0.0, matrix.ele[2][1], matrix.ele[1][1], matrix.ele[0][1]);
+	__m256d columnZ = _mm256_set_pd(0.0, matrix.ele[2][2], matrix.ele[1][2], matrix.ele[0][2]);
+	__m256d translationVector = _mm256_set_pd(0.0, translation.z, translation.y, translation.x);
+
+	for (int i = 0; i < count; i++)
+	{
+		const double* inPoint = &inPointArray[i * inStride];
+		__m256d result = _mm256_mul_pd(columnX, _mm256_broadcast_sd(&inPoint[0]));
+		result = _mm256_add_pd(result, _mm256_mul_pd(columnY, _mm256_broadcast_sd(&inPoint[1])));
+		result = _mm256_add_pd(result, _mm256_mul_pd(columnZ, _mm256_broadcast_sd(&inPoint[2])));
+		result = _mm256_add_pd(result, translationVector);
+		_mm256_maskstore_pd(&outPointArray[i * outStride], mask, result);
+	}
+#elif defined MW_VECTOR_KERNELS_SSE2
+	// The same, but with X and Y in one register, and Z in the low lane of another.
+	__m128d columnXY[3], columnZ[3];
+	for (int j = 0; j < 3; j++)
+	{
+		columnXY[j] = _mm_set_pd(matrix.ele[1][j], matrix.ele[0][j]);
+		columnZ[j] = _mm_set_sd(matrix.ele[2][j]);
+	}
+
+	__m128d translationXY = _mm_set_pd(translation.y, translation.x);
+	__m128d translationZ = _mm_set_sd(translation.z);
+
+	for (int i = 0; i < count; i++)
+	{
+		const double* inPoint = &inPointArray[i * inStride];
+		__m128d x = _mm_set1_pd(inPoint[0]);
+		__m128d y = _mm_set1_pd(inPoint[1]);
+		__m128d z = _mm_set1_pd(inPoint[2]);
+
+		__m128d resultXY = _mm_add_pd(_mm_mul_pd(columnXY[0], x), _mm_mul_pd(columnXY[1], y));
+		resultXY = _mm_add_pd(_mm_add_pd(resultXY, _mm_mul_pd(columnXY[2], z)), translationXY);
+
+		__m128d resultZ = _mm_add_sd(_mm_mul_sd(columnZ[0], x), _mm_mul_sd(columnZ[1], y));
+		resultZ = _mm_add_sd(_mm_add_sd(resultZ, _mm_mul_sd(columnZ[2], z)), translationZ);
+
+		double* outPoint = &outPointArray[i * outStride];
+		_mm_storeu_pd(outPoint, resultXY);
+		_mm_store_sd(&outPoint[2], resultZ);
+	}
+#else
+	TransformScalar(matrix, translation, inPointArray, outPointArray, count, inStride, outStride);
+#endif
+}
+
+/*static*/ void VectorKernels::TransformPositions(const Transform& transform, const float* inPointArray, float* outPointArray, int count, int inStride /*= 3*/, int outStride /*= 3*/)
+{
+	TransformScalar(transform.matrix, transform.translation, inPointArray, outPointArray, count, inStride, outStride);
+}
+
+// A vector is a position with no translation.  Adding a zero translation doesn't change any of the sums.
+/*static*/ void VectorKernels::TransformVectors(const Matrix3x3& matrix, const double* inVectorArray, double* outVectorArray, int count, int inStride /*= 3*/, int outStride /*= 3*/)
+{
+	Transform transform;
+	transform.matrix.SetCopy(matrix);
+	TransformPositions(transform, inVectorArray, outVectorArray, count, inStride, outStride);
+}
+
+/*static*/ void VectorKernels::TransformVectors(const Matrix3x3& matrix, const float* inVectorArray, float* outVectorArray, int count, int inStride /*= 3*/, int outStride /*= 3*/)
+{
+	TransformScalar(matrix, Vector(0.0, 0.0, 0.0), inVectorArray, outVectorArray, count, inStride, outStride);
+}
+
+/*static*/ void VectorKernels::CalcDotProducts(const Vector& vector, const double* vectorArray, int count, double* dotArray, int stride /*= 3*/)
+{
+	int i = 0;
+
+#if defined MW_VECTOR_KERNELS_AVX2
+	// Four vectors at a time, their coordinates gathered across the lanes.
+	__m256i offset = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+	__m256d vectorX = _mm256_set1_pd(vector.x);
+	__m256d vectorY = _mm256_set1_pd(vector.y);
+	__m256d vectorZ = _mm256_set1_pd(vector.z);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const double* base = &vectorArray[i * stride];
+		__m256d dot = _mm256_mul_pd(_mm256_i64gather_pd(&base[0], offset, 8), vectorX);
+		dot = _mm256_add_pd(dot, _mm256_mul_pd(_mm256_i64gather_pd(&base[1], offset, 8), vectorY));
+		dot = _mm256_add_pd(dot, _mm256_mul_pd(_mm256_i64gather_pd(&base[2], offset, 8), vectorZ));
+		_mm256_storeu_pd(&dotArray[i], dot);
+	}
+#elif defined MW_VECTOR_KERNELS_SSE2
+	__m128d vectorX = _mm_set1_pd(vector.x);
+	__m128d vectorY = _mm_set1_pd(vector.y);
+	__m128d vectorZ = _mm_set1_pd(vector.z);
+
+	for (; i + 2 <= count; i += 2)
+	{
+		const double* vectorA = &vectorArray[i * stride];
+		const double* vectorB = &vectorArray[(i + 1) * stride];
+		__m128d dot = _mm_mul_pd(_mm_set_pd(vectorB[0], vectorA[0]), vectorX);
+		dot = _mm_add_pd(dot, _mm_mul_pd(_mm_set_pd(vectorB[1], vectorA[1]), vectorY));
+		dot = _mm_add_pd(dot, _mm_mul_pd(_mm_set_pd(vectorB[2], vectorA[2]), vectorZ));
+		_mm_storeu_pd(&dotArray[i], dot);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const double* element = &vectorArray[i * stride];
+		dotArray[i] = element[0] * vector.x + element[1] * vector.y + element[2] * vector.z;
+	}
+}
+
+/*static*/ void VectorKernels::CalcPlaneDistances(const Plane& plane, const double* pointArray, const int* indexArray, int count, double* distanceArray, double* magnitudeArray, int stride /*= 3*/)
+{
+	int i = 0;
+
+#if defined MW_VECTOR_KERNELS_AVX2
+	__m256d centerX = _mm256_set1_pd(plane.center.x);
+	__m256d centerY = _mm256_set1_pd(plane.center.y);
+	__m256d centerZ = _mm256_set1_pd(plane.center.z);
+	__m256d normalX = _mm256_set1_pd(plane.unitNormal.x);
+	__m256d normalY = _mm256_set1_pd(plane.unitNormal.y);
+	__m256d normalZ = _mm256_set1_pd(plane.unitNormal.z);
+	__m256d signMask = _mm256_set1_pd(-0.0);
+
+	__m256i sequence = _mm256_set_epi64x(3, 2, 1, 0);
+	__m256i strideVector = _mm256_set1_epi64x(stride);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		// The offsets of the four points, in doubles, are their indices times the stride.
+		__m256i index = indexArray ? _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)&indexArray[i])) : _mm256_add_epi64(_mm256_set1_epi64x(i), sequence);
+		__m256i offset = _mm256_mul_epi32(index, strideVector);
+
+		__m256d termX = _mm256_mul_pd(_mm256_sub_pd(_mm256_i64gather_pd(&pointArray[0], offset, 8), centerX), normalX);
+		__m256d termY = _mm256_mul_pd(_mm256_sub_pd(_mm256_i64gather_pd(&pointArray[1], offset, 8), centerY), normalY);
+		__m256d termZ = _mm256_mul_pd(_mm256_sub_pd(_mm256_i64gather_pd(&pointArray[2], offset, 8), centerZ), normalZ);
+
+		_mm256_storeu_pd(&distanceArray[i], _mm256_add_pd(_mm256_add_pd(termX, termY), termZ));
+
+		__m256d magnitude = _mm256_add_pd(_mm256_andnot_pd(signMask, termX), _mm256_andnot_pd(signMask, termY));
+		_mm256_storeu_pd(&magnitudeArray[i], _mm256_add_pd(magnitude, _mm256_andnot_pd(signMask, termZ)));
+	}
+#elif defined MW_VECTOR_KERNELS_SSE2
+	__m128d center[3] = { _mm_set1_pd(plane.center.x), _mm_set1_pd(plane.center.y), _mm_set1_pd(plane.center.z) };
+	__m128d normal[3] = { _mm_set1_pd(plane.unitNormal.x), _mm_set1_pd(plane.unitNormal.y), _mm_set1_pd(plane.unitNormal.z) };
+	__m128d signMask = _mm_set1_pd(-0.0);
+
+	for (; i + 2 <= count; i += 2)
+	{
+		const double* pointA = &pointArray[(indexArray ? indexArray[i] : i) * stride];
+		const double* pointB = &pointArray[(indexArray ? indexArray[i + 1] : i + 1) * stride];
+
+		__m128d term[3];
+		for (int j = 0; j < 3; j++)
+			term[j] = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(pointB[j], pointA[j]), center[j]), normal[j]);
+
+		_mm_storeu_pd(&distanceArray[i], _mm_add_pd(_mm_add_pd(term[0], term[1]), term[2]));
+
+		__m128d magnitude = _mm_add_pd(_mm_andnot_pd(signMask, term[0]), _mm_andnot_pd(signMask, term[1]));
+		_mm_storeu_pd(&magnitudeArray[i], _mm_add_pd(magnitude, _mm_andnot_pd(signMask, term[2])));
+	}
+#endif
+
+	CalcPlaneDistancesScalar(plane, pointArray, indexArray, i, count, distanceArray, magnitudeArray, stride);
+}
+
+/*static*/ void VectorKernels::CalcPlaneDistances(const Plane& plane, const float* pointArray, const int* indexArray, int count, double* distanceArray, double* magnitudeArray, int stride /*= 3*/)
+{
+	CalcPlaneDistancesScalar(plane, pointArray, indexArray, 0, count, distanceArray, magnitudeArray, stride);
+}
+
+/*static*/ void VectorKernels::NormalizeVectors(double* vectorArray, int count, int stride /*= 3*/)
+{
+	int i = 0;
+
+#if defined MW_VECTOR_KERNELS_AVX2
+	// The scales are found four at a time, but written back one vector at a time, since AVX2 can't scatter.
+	__m256i offset = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+	__m256d one = _mm256_set1_pd(1.0);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		double* base = &vectorArray[i * stride];
+		__m256d x = _mm256_i64gather_pd(&base[0], offset, 8);
+		__m256d y = _mm256_i64gather_pd(&base[1], offset, 8);
+		__m256d z = _mm256_i64gather_pd(&base[2], offset, 8);
+
+		__m256d squareLength = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)), _mm256_mul_pd(z, z));
+		double scale[4];
+		_mm256_storeu_pd(scale, _mm256_div_pd(one, _mm256_sqrt_pd(squareLength)));
+
+		for (int j = 0; j < 4; j++)
+		{
+			if (scale[j] <= DBL_MAX)
+			{
+				double* vector = &base[j * stride];
+				_mm_storeu_pd(vector, _mm_mul_pd(_mm_loadu_pd(vector), _mm_set1_pd(scale[j])));
+				vector[2] *= scale[j];
+			}
+		}
+	}
+#elif defined MW_VECTOR_KERNELS_SSE2
+	for (; i < count; i++)
+	{
+		double* vector = &vectorArray[i * stride];
+		__m128d xy = _mm_loadu_pd(vector);
+		__m128d z = _mm_load_sd(&vector[2]);
+
+		__m128d square = _mm_mul_pd(xy, xy);
+		__m128d squareLength = _mm_add_sd(_mm_add_sd(square, _mm_unpackhi_pd(square, square)), _mm_mul_sd(z, z));
+		double scale = 1.0 / _mm_cvtsd_f64(_mm_sqrt_sd(squareLength, squareLength));
+
+		if (scale <= DBL_MAX)
+		{
+			__m128d scaleVector = _mm_set1_pd(scale);
+			_mm_storeu_pd(vector, _mm_mul_pd(xy, scaleVector));
+			_mm_store_sd(&vector[2], _mm_mul_sd(z, scaleVector));
+		}
+	}
+#endif
+
+	NormalizeScalar(vectorArray, i, count, stride);
+}
+
+/*static*/ void VectorKernels::NormalizeVectors(float* vectorArray, int count, int stride /*= 3*/)
+{
+	NormalizeScalar(vectorArray, 0, count, stride);
+}
+
+/*static*/ const char* VectorKernels::GetInstructionSetName()
+{
+#if defined MW_VECTOR_KERNELS_AVX2
+	return "AVX2";
+#elif defined MW_VECTOR_KERNELS_SSE2
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
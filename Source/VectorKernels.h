@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Defines.h"
+#include "AxisAlignedBox.h"
+
+// The kernels are vectorized with whatever the compiler was told it may use.  AVX2 has to be asked
+// for (/arch:AVX2 or -mavx2), but SSE2 is always there on x64.  Defining MW_VECTOR_KERNELS_SCALAR
+// turns both off, which is handy for checking the vectorized paths against the plain ones.
+#if !defined MW_VECTOR_KERNELS_SCALAR
+#	if defined __AVX2__
+#		define MW_VECTOR_KERNELS_AVX2
+#	endif
+#	if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#		define MW_VECTOR_KERNELS_SSE2
+#	endif
+#endif
+
+// This is how many doubles apart consecutive points are in an array of the given type, for
+// pointing the kernels at, say, the point member of an array of mesh vertices.
+#define MW_DOUBLE_STRIDE(type)		int(sizeof(type) / sizeof(double))
+
+namespace MeshWarrior
+{
+	class Vector;
+	class Plane;
+	class Matrix3x3;
+	class Transform;
+
+	// These do the same simple thing to a whole array of points or vectors at once.  Each point is
+	// three coordinates in a row, and consecutive points are the given stride apart (counted in
+	// coordinates, not bytes), so the arrays can be packed, or be members of bigger structures.
+	// Point arrays are read-only unless they're also the output, in which case each point is read
+	// before it is written, so transforming in place is fine.
+	class MESH_WARRIOR_API VectorKernels
+	{
+	public:
+		// An empty array gives the default box, the same as expanding one to contain no points would.
+		static AxisAlignedBox CalcBoundingBox(const double* pointArray, int count, int stride = 3);
+		static AxisAlignedBox CalcBoundingBox(const float* pointArray, int count, int stride = 3);
+
+		static void TransformPositions(const Transform& transform, const double* inPointArray, double* outPointArray, int count, int inStride = 3, int outStride = 3);
+		static void TransformPositions(const Transform& transform, const float* inPointArray, float* outPointArray, int count, int inStride = 3, int outStride = 3);
+		static void TransformVectors(const Matrix3x3& matrix, const double* inVectorArray, double* outVectorArray, int count, int inStride = 3, int outStride = 3);
+		static void TransformVectors(const Matrix3x3& matrix, const float* inVectorArray, float* outVectorArray, int count, int inStride = 3, int outStride = 3);
+
+		static void CalcDotProducts(const Vector& vector, const double* vectorArray, int count, double* dotArray, int stride = 3);
+
+		// For each point, this gives its signed distance from the plane, along with the sum of the
+		// absolute values of the terms making up that distance, which is what its rounding error
+		// is proportional to.  If given an index array, the i-th point is the one at that index.
+		static void CalcPlaneDistances(const Plane& plane, const double* pointArray, const int* indexArray, int count, double* distanceArray, double* magnitudeArray, int stride = 3);
+		static void CalcPlaneDistances(const Plane& plane, const float* pointArray, const int* indexArray, int count, double* distanceArray, double* magnitudeArray, int stride = 3);
+
+		// Vectors of zero length are left alone.
+		static void NormalizeVectors(double* vectorArray, int count, int stride = 3);
+		static void NormalizeVectors(float* vectorArray, int count, int stride = 3);
+
+		// Say which of the paths above this build uses, for benchmark reports and the like.
+		static const char* GetInstructionSetName();
+	};
+}
\ No newline at end of file
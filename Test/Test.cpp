@@ -1,12 +1,553 @@
 #include "FileFormats/OBJFormat.h"
 #include "MeshOperations/MeshSetOperation.h"
+#include "MeshOperations/MeshIncrementalSetOperation.h"
 #include "MeshOperations/MeshMergeOperation.h"
+#include "MeshGenerator.h"
+#include "ConvexHullGenerator.h"
+#include "TriangleMesh.h"
+#include "Polygon.h"
+#include "PolygonTriangulator.h"
+#include "Ray.h"
+#include "Predicates.h"
 #include "Mesh.h"
+#include "Shape.h"
+#include "Transform.h"
 #include <iostream>
+#include <set>
+#include <math.h>
+
+using namespace MeshWarrior;
+
+// An edge is open if no face has it going the other way.  A set operation on closed meshes should have none.
+static int CountOpenEdges(const Mesh* mesh)
+{
+	std::set<std::pair<int, int>> edgeSet;
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+	{
+		const Mesh::Face* face = mesh->GetFace(i);
+		for (int j = 0; j < (signed)face->vertexArray.size(); j++)
+			edgeSet.insert(std::pair<int, int>(face->vertexArray[j], face->vertexArray[(j + 1) % face->vertexArray.size()]));
+	}
+
+	int count = 0;
+	for (const std::pair<int, int>& edge : edgeSet)
+		if (edgeSet.find(std::pair<int, int>(edge.second, edge.first)) == edgeSet.end())
+			count++;
+
+	return count;
+}
+
+static bool CheckClosed(const std::vector<Mesh*>& meshArray, const char* caseName)
+{
+	bool closed = true;
+
+	for (const Mesh* mesh : meshArray)
+	{
+		int openEdgeCount = CountOpenEdges(mesh);
+		if (openEdgeCount > 0)
+		{
+			std::cerr << caseName << ": " << mesh->name->c_str() << " has " << openEdgeCount << " open edges!" << std::endl;
+			closed = false;
+		}
+	}
+
+	return closed;
+}
+
+static bool TestSetOperationOfSpheres()
+{
+	MeshGenerator meshGenerator;
+
+	std::vector<Mesh*> inputMeshArray;
+	inputMeshArray.push_back(meshGenerator.GenerateSphere(Sphere(Vector(0.0, 0.0, 0.0), 1.0), 40, 20));
+	inputMeshArray.push_back(meshGenerator.GenerateSphere(Sphere(Vector(0.7, 0.3, 0.1), 1.0), 40, 20));
+
+	std::vector<Mesh*> outputMeshArray;
+
+	MeshOperation* meshOp = new MeshSetOperation(MW_FLAG_ALL_SET_OP_RESULTS);
+	bool success = meshOp->Calculate(inputMeshArray, outputMeshArray) && CheckClosed(outputMeshArray, "spheres");
+	delete meshOp;
+
+	for (Mesh* mesh : inputMeshArray)
+		delete mesh;
+
+	for (Mesh* mesh : outputMeshArray)
+		delete mesh;
+
+	return success;
+}
+
+// The hull has to be closed, and no point can be outside the plane of any of its faces, not even by rounding error.
+static bool CheckConvexHull(std::vector<Vector> pointArray, const char* caseName)
+{
+#if MW_SINGLE_PRECISION_VERTICES
+	// The hull's vertices get rounded to float, so round the points the same way, for those to still be among them.
+	for (Vector& point : pointArray)
+		point = Vector(float(point.x), float(point.y), float(point.z));
+#endif
+
+	ConvexHullGenerator convexHullGenerator;
+	convexHullGenerator.mergeCoplanarFaces = false;
+
+	Mesh* mesh = convexHullGenerator.Generate(pointArray);
+	if (!mesh)
+	{
+		std::cerr << caseName << ": no hull!" << std::endl;
+		return false;
+	}
+
+	bool success = true;
+
+	int openEdgeCount = CountOpenEdges(mesh);
+	if (openEdgeCount > 0)
+	{
+		std::cerr << caseName << ": hull has " << openEdgeCount << " open edges!" << std::endl;
+		success = false;
+	}
+
+	int outsideCount = 0;
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+	{
+		const Mesh::Face* face = mesh->GetFace(i);
+		const Vector& pointA = mesh->GetVertex(face->vertexArray[0])->point;
+		const Vector& pointB = mesh->GetVertex(face->vertexArray[1])->point;
+		const Vector& pointC = mesh->GetVertex(face->vertexArray[2])->point;
+		for (const Vector& point : pointArray)
+			if (Predicates::Orient3D(pointA, pointB, pointC, point) > 0)
+				outsideCount++;
+	}
+
+	if (outsideCount > 0)
+	{
+		std::cerr << caseName << ": " << outsideCount << " points are outside faces of the hull!" << std::endl;
+		success = false;
+	}
+
+	delete mesh;
+	return success;
+}
+
+// Points scattered over the faces of a tilted box, and over a sphere far from the origin, are all nearly
+// coplanar with their neighbors, which is where deciding visibility within a tolerance goes wrong.
+static bool TestConvexHullOfNearlyCoplanarPoints()
+{
+	std::vector<Vector> boxPointArray;
+	for (int i = 0; i < 10000; i++)
+	{
+		double u = 2.0 * ::fmod(i * 0.6180339887498949, 1.0) - 1.0;
+		double v = 2.0 * ::fmod(i * 0.7548776662466927, 1.0) - 1.0;
+		double side = ((i / 3) % 2 == 0) ? -1.0 : 1.0;
+
+		Vector point;
+		if (i % 3 == 0)
+			point = Vector(side, u, v);
+		else if (i % 3 == 1)
+			point = Vector(u, side, v);
+		else
+			point = Vector(u, v, side);
+
+		// Tilt the box by turning it about the z-axis, then the x-axis.
+		point = Vector(point.x * ::cos(0.3) - point.y * ::sin(0.3), point.x * ::sin(0.3) + point.y * ::cos(0.3), point.z);
+		point = Vector(point.x, point.y * ::cos(0.7) - point.z * ::sin(0.7), point.y * ::sin(0.7) + point.z * ::cos(0.7));
+		boxPointArray.push_back(point);
+	}
+
+	std::vector<Vector> spherePointArray;
+	for (int i = 0; i < 2000; i++)
+	{
+		double z = 1.0 - (2.0 * i + 1.0) / 2000.0;
+		double radius = ::sqrt(1.0 - z * z);
+		double angle = i * 2.399963229728653;
+		spherePointArray.push_back(Vector(1e6 + radius * ::cos(angle), 1e6 + radius * ::sin(angle), 1e6 + z));
+	}
+
+	bool success = CheckConvexHull(boxPointArray, "box surface hull");
+	success = CheckConvexHull(spherePointArray, "far sphere hull") && success;
+	return success;
+}
+
+// A triangulation of a simple polygon has n - 2 triangles, all wound the same way as the polygon, and
+// adding up their areas gives the polygon's area, which it wouldn't if any of them overlapped.
+static bool CheckTriangulation(const std::vector<Vector>& pointArray, const char* caseName)
+{
+	PolygonTriangulator triangulator;
+	std::vector<int> triangleArray;
+	if (!triangulator.Triangulate(pointArray, triangleArray))
+	{
+		std::cerr << caseName << ": triangulation failed!" << std::endl;
+		return false;
+	}
+
+	bool success = true;
+
+	int triangleCount = (int)triangleArray.size() / 3;
+	if (triangleCount != (int)pointArray.size() - 2)
+	{
+		std::cerr << caseName << ": " << triangleCount << " triangles for " << pointArray.size() << " vertices!" << std::endl;
+		success = false;
+	}
+
+	Vector normal = Polygon::CalcAreaNormal(pointArray);
+	int axisU = 0, axisV = 0;
+	PolygonTriangulator::ChooseProjectionAxes(normal, axisU, axisV);
+
+	int clockwiseCount = 0;
+	double triangleArea = 0.0;
+	for (int i = 0; i < triangleCount; i++)
+	{
+		std::vector<Vector> trianglePointArray;
+		for (int j = 0; j < 3; j++)
+			trianglePointArray.push_back(pointArray[triangleArray[3 * i + j]]);
+
+		if (Predicates::Orient2D(
+			(&trianglePointArray[0].x)[axisU], (&trianglePointArray[0].x)[axisV],
+			(&trianglePointArray[1].x)[axisU], (&trianglePointArray[1].x)[axisV],
+			(&trianglePointArray[2].x)[axisU], (&trianglePointArray[2].x)[axisV]) <= 0)
+		{
+			clockwiseCount++;
+		}
+
+		triangleArea += Polygon::CalcAreaNormal(trianglePointArray).Length() / 2.0;
+	}
+
+	if (clockwiseCount > 0)
+	{
+		std::cerr << caseName << ": " << clockwiseCount << " triangles aren't wound CCW!" << std::endl;
+		success = false;
+	}
+
+	double area = normal.Length() / 2.0;
+	if (::fabs(triangleArea - area) > 1e-9 * area)
+	{
+		std::cerr << caseName << ": triangles cover an area of " << triangleArea << " instead of " << area << "!" << std::endl;
+		success = false;
+	}
+
+	return success;
+}
+
+// A comb whose teeth all hide each other, a spiral whose every ear is long and thin, and a comb with square
+// teeth, whose vertices are all level with a lot of others, are the polygons the sweep has the hardest time with.
+// A pentagram only ever turns left, but crosses itself, so it has to be turned down rather than stripped.
+static bool TestTriangulationOfConcavePolygons()
+{
+	std::vector<Vector> combPointArray;
+	combPointArray.push_back(Vector(0.0, 0.0, 0.0));
+	combPointArray.push_back(Vector(40.0, 0.0, 0.0));
+	for (int i = 19; i >= 0; i--)
+	{
+		combPointArray.push_back(Vector(2.0 * i + 2.0, 1.0, 0.0));
+		combPointArray.push_back(Vector(2.0 * i + 1.5, 10.0, 0.0));
+		combPointArray.push_back(Vector(2.0 * i + 1.0, 1.0, 0.0));
+	}
+	combPointArray.push_back(Vector(0.0, 1.0, 0.0));
+
+	std::vector<Vector> spiralPointArray;
+	for (int i = 0; i < 200; i++)
+	{
+		double angle = 5.0 * MW_TWO_PI * double(i) / 200.0;
+		spiralPointArray.push_back(Vector((1.0 + angle) * ::cos(angle), 0.0, (1.0 + angle) * ::sin(angle)));
+	}
+	for (int i = 199; i >= 0; i--)
+	{
+		double angle = 5.0 * MW_TWO_PI * double(i) / 200.0;
+		spiralPointArray.push_back(Vector((0.5 + angle) * ::cos(angle), 0.0, (0.5 + angle) * ::sin(angle)));
+	}
+
+	std::vector<Vector> squareCombPointArray;
+	squareCombPointArray.push_back(Vector(0.0, 0.0, 0.0));
+	squareCombPointArray.push_back(Vector(0.0, 0.0, 40.0));
+	for (int i = 19; i >= 0; i--)
+	{
+		squareCombPointArray.push_back(Vector(0.0, 1.0, 2.0 * i + 2.0));
+		squareCombPointArray.push_back(Vector(0.0, 3.0, 2.0 * i + 2.0));
+		squareCombPointArray.push_back(Vector(0.0, 3.0, 2.0 * i + 1.0));
+		squareCombPointArray.push_back(Vector(0.0, 1.0, 2.0 * i + 1.0));
+	}
+	squareCombPointArray.push_back(Vector(0.0, 1.0, 0.0));
+
+	bool success = CheckTriangulation(combPointArray, "comb triangulation");
+	success = CheckTriangulation(spiralPointArray, "spiral triangulation") && success;
+	success = CheckTriangulation(squareCombPointArray, "square comb triangulation") && success;
+
+	std::vector<Vector> pentagramPointArray;
+	for (int i = 0; i < 5; i++)
+	{
+		double angle = 2.0 * MW_TWO_PI * double(i) / 5.0;
+		pentagramPointArray.push_back(Vector(::cos(angle), ::sin(angle), 0.0));
+	}
+
+	PolygonTriangulator triangulator;
+	std::vector<int> triangleArray;
+	if (triangulator.Triangulate(pentagramPointArray, triangleArray))
+	{
+		std::cerr << "pentagram triangulation: a polygon that crosses itself was triangulated!" << std::endl;
+		success = false;
+	}
+
+	return success;
+}
+
+// On a closed sphere, every edge has a neighbor that has it the other way around, every vertex normal points
+// out from the center, and a ray through the middle comes out the far side at about the radius.
+static bool TestTriangleMeshOfSphere()
+{
+	MeshGenerator meshGenerator;
+	Mesh* sphereMesh = meshGenerator.GenerateSphere(Sphere(Vector(0.0, 0.0, 0.0), 1.0), 40, 20);
+	Mesh* mesh = sphereMesh->GenerateTriangleMesh();
+	*mesh->name = "sphere";
+	delete sphereMesh;
+
+	bool success = true;
+
+	TriangleMesh triangleMesh;
+	if (!triangleMesh.FromMesh(mesh) || *triangleMesh.name != "sphere")
+	{
+		std::cerr << "triangle mesh: conversion from mesh failed, or lost the name!" << std::endl;
+		success = false;
+	}
+
+	std::vector<int> neighborArray;
+	triangleMesh.CalcAdjacency(neighborArray);
+	for (int i = 0; i < triangleMesh.GetNumTriangles() && success; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			int neighbor = neighborArray[3 * i + j];
+			const TriangleMesh::Triangle* triangle = triangleMesh.GetTriangle(i);
+			const TriangleMesh::Triangle* neighborTriangle = triangleMesh.GetTriangle(neighbor);
+
+			bool matched = false;
+			for (int k = 0; neighborTriangle && k < 3; k++)
+				matched = matched || (neighborTriangle->vertex[k] == triangle->vertex[(j + 1) % 3] && neighborTriangle->vertex[(k + 1) % 3] == triangle->vertex[j]);
+
+			if (!matched)
+			{
+				std::cerr << "triangle mesh: edge " << j << " of triangle " << i << " has no neighbor!" << std::endl;
+				success = false;
+				break;
+			}
+		}
+	}
+
+	triangleMesh.CalcVertexNormals();
+	for (int i = 0; i < triangleMesh.GetNumVertices() && success; i++)
+	{
+		const Mesh::Vertex* vertex = triangleMesh.GetVertex(i);
+		Vector point(vertex->point.x, vertex->point.y, vertex->point.z);
+		Vector normal(vertex->normal.x, vertex->normal.y, vertex->normal.z);
+		if (Vector::Dot(point, normal) < 0.99)
+		{
+			std::cerr << "triangle mesh: normal of vertex " << i << " doesn't point out!" << std::endl;
+			success = false;
+		}
+	}
+
+	double rayAlpha = 0.0;
+	if (!triangleMesh.RayCast(Ray(Vector(-5.0, 0.01, 0.02), Vector(1.0, 0.0, 0.0)), rayAlpha) || ::fabs(rayAlpha - 4.0) > 0.01)
+	{
+		std::cerr << "triangle mesh: ray through the sphere missed it!" << std::endl;
+		success = false;
+	}
+
+	if (triangleMesh.RayCast(Ray(Vector(-5.0, 0.01, 0.02), Vector(-1.0, 0.0, 0.0)), rayAlpha))
+	{
+		std::cerr << "triangle mesh: ray away from the sphere hit it!" << std::endl;
+		success = false;
+	}
+
+	int triangleCount = triangleMesh.GetNumTriangles();
+	Mesh* movedMesh = triangleMesh.MoveToMesh();
+	if (*movedMesh->name != "sphere" || movedMesh->GetNumFaces() != triangleCount || !triangleMesh.MoveFromMesh(movedMesh) || *triangleMesh.name != "sphere" || triangleMesh.GetNumTriangles() != triangleCount || movedMesh->GetNumVertices() != 0)
+	{
+		std::cerr << "triangle mesh: moving to and from a mesh failed, or lost the name!" << std::endl;
+		success = false;
+	}
+
+	delete movedMesh;
+	delete mesh;
+	return success;
+}
+
+// This adds up the signed volumes of the tetrahedra made by the origin and the triangles of a fan across each face.
+static double CalcEnclosedVolume(const Mesh* mesh)
+{
+	double volume = 0.0;
+	for (int i = 0; i < mesh->GetNumFaces(); i++)
+	{
+		const Mesh::Face* face = mesh->GetFace(i);
+
+		std::vector<Vector> pointArray;
+		for (int j : face->vertexArray)
+		{
+			const Mesh::Vertex* vertex = mesh->GetVertex(j);
+			pointArray.push_back(Vector(vertex->point.x, vertex->point.y, vertex->point.z));
+		}
+
+		for (int j = 1; j + 1 < (int)pointArray.size(); j++)
+			volume += Vector::Dot(pointArray[0], pointArray[j] ^ pointArray[j + 1]) / 6.0;
+	}
+
+	return volume;
+}
+
+// A small sphere goes from inside a big one, out through its surface, and away from it, and at each step the
+// incremental set operation, which keeps what it knows about the big sphere, has to agree with working it all out.
+static bool TestIncrementalSetOperationOfSpheres()
+{
+	MeshGenerator meshGenerator;
+	Mesh* bigMesh = meshGenerator.GenerateSphere(Sphere(Vector(0.0, 0.0, 0.0), 2.0), 48, 24);
+
+	MeshIncrementalSetOperation incrementalMeshOp(MW_FLAG_ALL_SET_OP_RESULTS);
+
+	bool success = true;
+
+	for (int i = 0; i < 8; i++)
+	{
+		Mesh* smallMesh = meshGenerator.GenerateSphere(Sphere(Vector(1.1 + 0.23 * i, 0.07 * i, 0.03), 0.5), 20, 10);
+
+		std::vector<Mesh*> inputMeshArray;
+		inputMeshArray.push_back(bigMesh);
+		inputMeshArray.push_back(smallMesh);
+
+		std::vector<Mesh*> incrementalOutputMeshArray, outputMeshArray;
+
+		MeshOperation* meshOp = new MeshSetOperation(MW_FLAG_ALL_SET_OP_RESULTS);
+		bool calculated = meshOp->Calculate(inputMeshArray, outputMeshArray);
+		delete meshOp;
+
+		if (!calculated || !incrementalMeshOp.Calculate(inputMeshArray, incrementalOutputMeshArray))
+		{
+			std::cerr << "incremental spheres: step " << i << " failed!" << std::endl;
+			success = false;
+		}
+		else if (incrementalOutputMeshArray.size() != outputMeshArray.size())
+		{
+			std::cerr << "incremental spheres: step " << i << " gave " << incrementalOutputMeshArray.size() << " results instead of " << outputMeshArray.size() << "!" << std::endl;
+			success = false;
+		}
+		else
+		{
+			for (int j = 0; j < (int)outputMeshArray.size(); j++)
+			{
+				int incrementalFaceCount = incrementalOutputMeshArray[j]->GetNumFaces();
+				int faceCount = outputMeshArray[j]->GetNumFaces();
+				double incrementalVolume = CalcEnclosedVolume(incrementalOutputMeshArray[j]);
+				double volume = CalcEnclosedVolume(outputMeshArray[j]);
+				if (incrementalFaceCount != faceCount || ::fabs(incrementalVolume - volume) > 1e-9 * MW_MAX(::fabs(volume), 1.0))
+				{
+					std::cerr << "incremental spheres: step " << i << ", result " << j << " has " << incrementalFaceCount << " faces and a volume of " << incrementalVolume;
+					std::cerr << " instead of " << faceCount << " faces and a volume of " << volume << "!" << std::endl;
+					success = false;
+				}
+			}
+
+			success = CheckClosed(incrementalOutputMeshArray, "incremental spheres") && success;
+		}
+
+		for (Mesh* mesh : incrementalOutputMeshArray)
+			delete mesh;
+
+		for (Mesh* mesh : outputMeshArray)
+			delete mesh;
+
+		delete smallMesh;
+	}
+
+	delete bigMesh;
+	return success;
+}
+
+// Count the given faces, and their vertices, whose normals point in toward the given center rather than out from it.
+static int CountInwardNormals(const Mesh* mesh, int firstFace, int faceCount, const Vector& center)
+{
+	int count = 0;
+	for (int i = firstFace; i < firstFace + faceCount; i++)
+	{
+		const Mesh::Face* face = mesh->GetFace(i);
+
+		std::vector<Vector> pointArray;
+		Vector centroid(0.0, 0.0, 0.0);
+		for (int j : face->vertexArray)
+		{
+			const Mesh::Vertex* vertex = mesh->GetVertex(j);
+			Vector point(vertex->point.x, vertex->point.y, vertex->point.z);
+			Vector normal(vertex->normal.x, vertex->normal.y, vertex->normal.z);
+			if (Vector::Dot(point - center, normal) <= 0.0)
+				count++;
+
+			pointArray.push_back(point);
+			centroid += point;
+		}
+
+		centroid /= double(pointArray.size());
+		if (Vector::Dot(centroid - center, Polygon::CalcAreaNormal(pointArray)) <= 0.0)
+			count++;
+	}
+
+	return count;
+}
+
+// A mirrored sphere has to have its faces turned around to stay closed with its normals pointing out,
+// whether it's mirrored in place or as one of several instances.
+static bool TestMirroredSphere()
+{
+	MeshGenerator meshGenerator;
+	Mesh* mesh = meshGenerator.GenerateSphere(Sphere(Vector(0.0, 0.0, 0.0), 1.0), 40, 20);
+	int faceCount = mesh->GetNumFaces();
+
+	Transform mirror;
+	mirror.matrix.SetRow(0, Vector(-1.0, 0.0, 0.0));
+
+	std::vector<Transform> transformArray(2);
+	transformArray[0].translation = Vector(-3.0, 0.0, 0.0);
+	transformArray[1] = mirror;
+	transformArray[1].translation = Vector(3.0, 0.0, 0.0);
+
+	bool success = true;
+
+	Mesh* instanceMesh = mesh->GenerateInstances(transformArray);
+	if (!instanceMesh || instanceMesh->GetNumFaces() != 2 * faceCount)
+	{
+		std::cerr << "mirrored sphere: instancing failed!" << std::endl;
+		success = false;
+	}
+	else
+	{
+		int openEdgeCount = CountOpenEdges(instanceMesh);
+		int inwardCount = CountInwardNormals(instanceMesh, 0, faceCount, Vector(-3.0, 0.0, 0.0));
+		inwardCount += CountInwardNormals(instanceMesh, faceCount, faceCount, Vector(3.0, 0.0, 0.0));
+		if (openEdgeCount > 0 || inwardCount > 0)
+		{
+			std::cerr << "mirrored sphere: instances have " << openEdgeCount << " open edges and " << inwardCount << " inward normals!" << std::endl;
+			success = false;
+		}
+	}
+
+	if (!mesh->ApplyTransform(mirror))
+	{
+		std::cerr << "mirrored sphere: transform failed!" << std::endl;
+		success = false;
+	}
+	else
+	{
+		int openEdgeCount = CountOpenEdges(mesh);
+		int inwardCount = CountInwardNormals(mesh, 0, faceCount, Vector(0.0, 0.0, 0.0));
+		if (openEdgeCount > 0 || inwardCount > 0)
+		{
+			std::cerr << "mirrored sphere: mesh has " << openEdgeCount << " open edges and " << inwardCount << " inward normals!" << std::endl;
+			success = false;
+		}
+	}
+
+	delete instanceMesh;
+	delete mesh;
+	return success;
+}
 
 int main()
 {
-	using namespace MeshWarrior;
+	int result = 0;
 
 	OBJFormat objFormat;
 
@@ -28,9 +569,13 @@ int main()
 	{
 		std::cerr << "Mesh calculation failed!" << std::endl;
 		std::cerr << meshOp->error->c_str() << std::endl;
+		result = 1;
 	}
 	else
 	{
+		if (!CheckClosed(outputMeshArray, "MeshA/MeshB"))
+			result = 1;
+
 		std::vector<FileObject*> fileObjectArray;
 		for (Mesh* mesh : outputMeshArray)
 			fileObjectArray.push_back(mesh);
@@ -46,5 +591,23 @@ int main()
 
 	delete meshOp;
 
-	return 0;
+	if (!TestSetOperationOfSpheres())
+		result = 1;
+
+	if (!TestIncrementalSetOperationOfSpheres())
+		result = 1;
+
+	if (!TestConvexHullOfNearlyCoplanarPoints())
+		result = 1;
+
+	if (!TestTriangulationOfConcavePolygons())
+		result = 1;
+
+	if (!TestTriangleMeshOfSphere())
+		result = 1;
+
+	if (!TestMirroredSphere())
+		result = 1;
+
+	return result;
 }
\ No newline at end of file